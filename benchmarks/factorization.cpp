@@ -0,0 +1,93 @@
+#include "lup_decomposition.hpp"
+#include "parallel.hpp"
+#include "tile_factorization.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace basic_matrix;
+
+namespace {
+/// A random, diagonally dominant and so well-conditioned, n x n matrix.
+Matrix randomMatrix(const size_t &n) {
+  Matrix A(n, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      A(x, y) = 2.0 * rand() / RAND_MAX - 1.0;
+    }
+    A(y, y) += n;
+  }
+  return A;
+}
+
+/// The best of a few runs of fn, in seconds.
+template <typename Fn> double timeIt(const Fn &fn) {
+  double best = 0.0;
+  for (size_t run = 0; run < 3; run++) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+/// GFLOP/s of a factorization of n^3 * flops_per_n3 flops in seconds.
+double gflops(const size_t &n, const double &flops_per_n3,
+              const double &seconds) {
+  return flops_per_n3 * n * n * n / seconds * 1e-9;
+}
+}; // namespace
+
+/// Reports the strong scaling of the tile LU and Cholesky factorizations
+/// against the row-parallel luFactorize, for 1, 2, 4, ... threads up to
+/// the number of hardware threads.
+/// Usage: factorization_benchmark [n] [tile_size]
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? atol(argv[1]) : 2048;
+  size_t tile_size = argc > 2 ? atol(argv[2]) : kDefaultTileSize;
+  size_t max_threads = numThreads();
+  Matrix A = randomMatrix(n);
+  Matrix spd = A * A.transpose();
+  std::cout << "n = " << n << ", tile size = " << tile_size << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(18) << "luFactorize"
+            << std::setw(18) << "tileLU" << std::setw(18) << "tileCholesky"
+            << "   (GFLOP/s, speedup over 1 thread)" << std::endl;
+  double base[3] = {0.0, 0.0, 0.0};
+  for (size_t threads = 1;; threads = std::min(2 * threads, max_threads)) {
+    setNumThreads(threads);
+    std::vector<size_t> pivots;
+    double seconds[3] = {
+        timeIt([&]() {
+          Matrix LU = A;
+          luFactorize(LU, pivots);
+        }),
+        timeIt([&]() {
+          Matrix LU = A;
+          tileLUFactorize(LU, pivots, tile_size);
+        }),
+        timeIt([&]() {
+          Matrix L = spd;
+          tileCholeskyFactorize(L, tile_size);
+        })};
+    double flops[3] = {2.0 / 3.0, 2.0 / 3.0, 1.0 / 3.0};
+    std::cout << std::setw(8) << threads;
+    for (size_t i = 0; i < 3; i++) {
+      if (threads == 1) {
+        base[i] = seconds[i];
+      }
+      std::cout << std::setw(10) << std::fixed << std::setprecision(2)
+                << gflops(n, flops[i], seconds[i]) << " (" << std::setw(5)
+                << base[i] / seconds[i] << ")";
+    }
+    std::cout << std::endl;
+    if (threads == max_threads) {
+      break;
+    }
+  }
+  setNumThreads(0);
+}
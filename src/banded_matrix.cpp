@@ -0,0 +1,390 @@
+#include "banded_matrix.hpp"
+#include "kernel_helpers.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+void checkRightHandSide(const size_t &n, const Matrix &b) {
+  if (b.height() != n) {
+    throw std::runtime_error("b has height " + std::to_string(b.height()) +
+                             " but the system has " + std::to_string(n) +
+                             " rows.");
+  }
+}
+}; // namespace
+
+BandedMatrix::BandedMatrix() : BandedMatrix(0, 0, 0) {}
+
+BandedMatrix::BandedMatrix(const size_t &n, const size_t &lower,
+                           const size_t &upper)
+    : m_n(n), m_lower(lower), m_upper(upper),
+      m_band(n * (lower + upper + 1), 0.0) {}
+
+BandedMatrix::BandedMatrix(const Matrix &dense, const size_t &lower,
+                           const size_t &upper)
+    : BandedMatrix(dense.width(), lower, upper) {
+  if (dense.width() != dense.height()) {
+    throw std::runtime_error("A banded matrix must be square, but got " +
+                             std::to_string(dense.width()) + "x" +
+                             std::to_string(dense.height()));
+  }
+  for (size_t x = 0; x < m_n; x++) {
+    size_t y_begin = x > m_upper ? x - m_upper : 0;
+    size_t y_end = std::min(m_n, x + m_lower + 1);
+    for (size_t y = y_begin; y < y_end; y++) {
+      m_band[index(x, y)] = dense(x, y);
+    }
+  }
+}
+
+size_t BandedMatrix::size() const { return m_n; }
+size_t BandedMatrix::lower() const { return m_lower; }
+size_t BandedMatrix::upper() const { return m_upper; }
+
+bool BandedMatrix::inBand(const size_t &x, const size_t &y) const {
+  return x < m_n && y < m_n && y + m_upper >= x && y <= x + m_lower;
+}
+
+size_t BandedMatrix::index(const size_t &x, const size_t &y) const {
+  return x * (m_lower + m_upper + 1) + m_upper + y - x;
+}
+
+double BandedMatrix::operator()(const size_t &x, const size_t &y) const {
+  if (x >= m_n || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_n) + "x" + std::to_string(m_n) +
+                            " matrix.");
+  }
+  return inBand(x, y) ? m_band[index(x, y)] : 0.0;
+}
+
+double &BandedMatrix::operator()(const size_t &x, const size_t &y) {
+  if (!inBand(x, y)) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) +
+                            ") is outside the band of the matrix.");
+  }
+  return m_band[index(x, y)];
+}
+
+const std::vector<double> &BandedMatrix::band() const { return m_band; }
+
+Matrix BandedMatrix::toDense() const {
+  Matrix result(m_n, m_n);
+  for (size_t x = 0; x < m_n; x++) {
+    size_t y_begin = x > m_upper ? x - m_upper : 0;
+    size_t y_end = std::min(m_n, x + m_lower + 1);
+    for (size_t y = y_begin; y < y_end; y++) {
+      result(x, y) = m_band[index(x, y)];
+    }
+  }
+  return result;
+}
+
+const Matrix BandedMatrix::operator*(const Matrix &dense) const {
+  if (dense.height() != m_n) {
+    throw std::runtime_error(
+        "Cannot multiply a " + std::to_string(m_n) + "x" +
+        std::to_string(m_n) + " banded matrix by a " +
+        std::to_string(dense.width()) + "x" +
+        std::to_string(dense.height()) + " matrix.");
+  }
+  size_t k = dense.width();
+  Matrix result(k, m_n);
+  double *c = result.data();
+  size_t bandwidth = m_lower + m_upper + 1;
+  parallelFor(
+      0, m_n,
+      [&](const size_t &y) {
+        size_t x_begin = y > m_lower ? y - m_lower : 0;
+        size_t x_end = std::min(m_n, y + m_upper + 1);
+        for (size_t x = x_begin; x < x_end; x++) {
+          double a = m_band[index(x, y)];
+          for (size_t j = 0; j < k; j++) {
+            c[y * k + j] += a * dense(j, x);
+          }
+        }
+      },
+      std::max<size_t>(1, 16384 / std::max<size_t>(bandwidth * k, 1)));
+  return result;
+}
+
+bool bandedLUFactorize(const BandedMatrix &A, BandedMatrix &LU,
+                       std::vector<size_t> &pivots) {
+  size_t n = A.size();
+  size_t kl = A.lower();
+  // Room for the fill-in of the row interchanges.
+  size_t ku = A.upper() + kl;
+  LU = BandedMatrix(n, kl, ku);
+  for (size_t x = 0; x < n; x++) {
+    size_t y_begin = x > A.upper() ? x - A.upper() : 0;
+    size_t y_end = std::min(n, x + kl + 1);
+    for (size_t y = y_begin; y < y_end; y++) {
+      LU(x, y) = A(x, y);
+    }
+  }
+  pivots.resize(n);
+  for (size_t j = 0; j < n; j++) {
+    size_t y_end = std::min(n, j + kl + 1);
+    size_t x_end = std::min(n, j + ku + 1);
+    size_t p = j;
+    for (size_t y = j + 1; y < y_end; y++) {
+      if (fabs(LU(j, y)) > fabs(LU(j, p))) {
+        p = y;
+      }
+    }
+    pivots[j] = p;
+    if (LU(j, p) == 0.0) {
+      return false;
+    }
+    if (p != j) {
+      for (size_t x = j; x < x_end; x++) {
+        std::swap(LU(x, j), LU(x, p));
+      }
+    }
+    double pivot = LU(j, j);
+    for (size_t y = j + 1; y < y_end; y++) {
+      double l = LU(j, y) / pivot;
+      LU(j, y) = l;
+      if (l == 0.0) {
+        continue;
+      }
+      for (size_t x = j + 1; x < x_end; x++) {
+        LU(x, y) -= l * LU(x, j);
+      }
+    }
+  }
+  return true;
+}
+
+void solveBandedLU(const BandedMatrix &LU, const std::vector<size_t> &pivots,
+                   Matrix &b_in) {
+  size_t n = LU.size();
+  checkRightHandSide(n, b_in);
+  onContiguous(b_in, [&](Matrix &b) {
+    size_t k = b.width();
+    double *x = b.data();
+    size_t kl = LU.lower();
+    size_t ku = LU.upper();
+    // Apply the interchanges and L, in the order they were computed.
+    for (size_t j = 0; j < n; j++) {
+      if (pivots[j] != j) {
+        std::swap_ranges(&x[j * k], &x[j * k] + k, &x[pivots[j] * k]);
+      }
+      size_t y_end = std::min(n, j + kl + 1);
+      for (size_t y = j + 1; y < y_end; y++) {
+        double l = LU(j, y);
+        for (size_t c = 0; c < k; c++) {
+          x[y * k + c] -= l * x[j * k + c];
+        }
+      }
+    }
+    // Back substitution with U, a column of U at a time.
+    for (size_t j = n; j-- > 0;) {
+      double d = LU(j, j);
+      for (size_t c = 0; c < k; c++) {
+        x[j * k + c] /= d;
+      }
+      size_t y_begin = j > ku ? j - ku : 0;
+      for (size_t y = y_begin; y < j; y++) {
+        double u = LU(j, y);
+        for (size_t c = 0; c < k; c++) {
+          x[y * k + c] -= u * x[j * k + c];
+        }
+      }
+    }
+    return true;
+  });
+}
+
+bool bandedCholeskyFactorize(const BandedMatrix &A, BandedMatrix &L) {
+  size_t n = A.size();
+  size_t kd = A.lower();
+  L = BandedMatrix(n, kd, 0);
+  for (size_t j = 0; j < n; j++) {
+    size_t y_end = std::min(n, j + kd + 1);
+    for (size_t y = j; y < y_end; y++) {
+      // L(y, j) = (A(y, j) - sum_k L(y, k) * L(j, k)) / L(j, j), over the
+      // columns k < j inside both rows' bands.
+      double sum = A(j, y);
+      size_t k_begin = y > kd ? y - kd : 0;
+      for (size_t k = k_begin; k < j; k++) {
+        sum -= L(k, y) * L(k, j);
+      }
+      if (y == j) {
+        if (sum <= 0.0) {
+          return false;
+        }
+        L(j, j) = sqrt(sum);
+      } else {
+        L(j, y) = sum / L(j, j);
+      }
+    }
+  }
+  return true;
+}
+
+void solveBandedCholesky(const BandedMatrix &L, Matrix &b_in) {
+  size_t n = L.size();
+  checkRightHandSide(n, b_in);
+  onContiguous(b_in, [&](Matrix &b) {
+    size_t k = b.width();
+    double *x = b.data();
+    size_t kd = L.lower();
+    for (size_t y = 0; y < n; y++) {
+      size_t j_begin = y > kd ? y - kd : 0;
+      for (size_t j = j_begin; j < y; j++) {
+        double l = L(j, y);
+        for (size_t c = 0; c < k; c++) {
+          x[y * k + c] -= l * x[j * k + c];
+        }
+      }
+      double d = L(y, y);
+      for (size_t c = 0; c < k; c++) {
+        x[y * k + c] /= d;
+      }
+    }
+    // L^T is upper triangular; row y of L^T is column y of L.
+    for (size_t y = n; y-- > 0;) {
+      size_t j_end = std::min(n, y + kd + 1);
+      for (size_t j = y + 1; j < j_end; j++) {
+        double l = L(y, j);
+        for (size_t c = 0; c < k; c++) {
+          x[y * k + c] -= l * x[j * k + c];
+        }
+      }
+      double d = L(y, y);
+      for (size_t c = 0; c < k; c++) {
+        x[y * k + c] /= d;
+      }
+    }
+    return true;
+  });
+}
+
+bool solveBandedBatch(const std::vector<BandedMatrix> &A,
+                      std::vector<Matrix> &b) {
+  if (A.size() != b.size()) {
+    throw std::runtime_error("Got " + std::to_string(A.size()) +
+                             " matrices but " + std::to_string(b.size()) +
+                             " right-hand sides.");
+  }
+  std::vector<char> solved(A.size(), 0);
+  parallelFor(0, A.size(), [&](const size_t &i) {
+    BandedMatrix LU;
+    std::vector<size_t> pivots;
+    if (bandedLUFactorize(A[i], LU, pivots)) {
+      solveBandedLU(LU, pivots, b[i]);
+      solved[i] = 1;
+    }
+  });
+  return std::all_of(solved.begin(), solved.end(),
+                     [](const char &s) { return s != 0; });
+}
+
+bool solveTridiagonal(const Matrix &sub, const Matrix &diagonal,
+                      const Matrix &super, Matrix &b) {
+  size_t n = diagonal.height();
+  if (diagonal.width() != 1 || sub.width() != 1 || super.width() != 1 ||
+      sub.height() + 1 != std::max<size_t>(n, 1) ||
+      super.height() != sub.height()) {
+    throw std::runtime_error("The diagonals of a tridiagonal matrix must be "
+                             "column vectors of heights n-1, n and n-1.");
+  }
+  checkRightHandSide(n, b);
+  if (n == 0) {
+    return true;
+  }
+  size_t k = b.width();
+  // Forward elimination; c holds the modified superdiagonal.
+  std::vector<double> c(n);
+  for (size_t y = 0; y < n; y++) {
+    double d = diagonal(0, y);
+    if (y > 0) {
+      d -= sub(0, y - 1) * c[y - 1];
+    }
+    if (d == 0.0) {
+      return false;
+    }
+    c[y] = y + 1 < n ? super(0, y) / d : 0.0;
+    for (size_t j = 0; j < k; j++) {
+      double value = b(j, y);
+      if (y > 0) {
+        value -= sub(0, y - 1) * b(j, y - 1);
+      }
+      b(j, y) = value / d;
+    }
+  }
+  for (size_t y = n - 1; y-- > 0;) {
+    for (size_t j = 0; j < k; j++) {
+      b(j, y) -= c[y] * b(j, y + 1);
+    }
+  }
+  return true;
+}
+
+bool solveTridiagonalBatch(const Matrix &sub_in, const Matrix &diagonal_in,
+                           const Matrix &super_in, Matrix &b_in) {
+  size_t n = diagonal_in.height();
+  size_t m = diagonal_in.width();
+  if (b_in.width() != m || b_in.height() != n || sub_in.width() != m ||
+      super_in.width() != m || sub_in.height() + 1 != std::max<size_t>(n, 1) ||
+      super_in.height() != sub_in.height()) {
+    throw std::runtime_error(
+        "A batch of m tridiagonal systems needs m x (n-1) sub- and "
+        "superdiagonals and an m x n diagonal and b.");
+  }
+  if (n == 0) {
+    return true;
+  }
+  Matrix sub = sub_in;
+  Matrix diagonal = diagonal_in;
+  Matrix super = super_in;
+  return onContiguous(b_in, [&](Matrix &b_matrix) {
+    const double *lo = sub.data();
+    const double *d = diagonal.data();
+    const double *up = super.data();
+    double *b = b_matrix.data();
+    std::vector<double> c(n * m);
+    std::vector<char> ok(m, 1);
+    // Blocks of systems are eliminated row by row, with the systems of a
+    // block side by side in each row.
+    const size_t kBlock = 64;
+    parallelFor(
+        0, (m + kBlock - 1) / kBlock,
+        [&](const size_t &block) {
+          size_t j0 = block * kBlock;
+          size_t j1 = std::min(m, j0 + kBlock);
+          for (size_t y = 0; y < n; y++) {
+            for (size_t j = j0; j < j1; j++) {
+              double pivot = d[y * m + j];
+              double bv = b[y * m + j];
+              if (y > 0) {
+                double l = lo[(y - 1) * m + j];
+                pivot -= l * c[(y - 1) * m + j];
+                bv -= l * b[(y - 1) * m + j];
+              }
+              if (pivot == 0.0) {
+                // Keep going to stay in lockstep; the result is discarded.
+                ok[j] = 0;
+                pivot = 1.0;
+              }
+              c[y * m + j] = y + 1 < n ? up[y * m + j] / pivot : 0.0;
+              b[y * m + j] = bv / pivot;
+            }
+          }
+          for (size_t y = n - 1; y-- > 0;) {
+            for (size_t j = j0; j < j1; j++) {
+              b[y * m + j] -= c[y * m + j] * b[(y + 1) * m + j];
+            }
+          }
+        },
+        std::max<size_t>(1, 256 / std::max<size_t>(n, 1)));
+    return std::all_of(ok.begin(), ok.end(),
+                       [](const char &s) { return s != 0; });
+  });
+}
+}; // namespace basic_matrix
@@ -0,0 +1,119 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// A square n x n matrix that is zero outside a band of lower()
+/// subdiagonals and upper() superdiagonals.
+///
+/// Storage follows LAPACK's band layout: the band is a
+/// (lower + upper + 1) x n column-major array in which the entry at column
+/// x and row y is stored at row upper + y - x of column x. Only the
+/// n * (lower + upper + 1) band entries are stored.
+class BandedMatrix {
+public:
+  /// A 0x0 matrix.
+  BandedMatrix();
+
+  /// An n x n matrix of zeros with the given bandwidths.
+  BandedMatrix(const size_t &n, const size_t &lower, const size_t &upper);
+
+  /// The band of the square matrix dense. Entries outside the band are
+  /// ignored.
+  BandedMatrix(const Matrix &dense, const size_t &lower, const size_t &upper);
+
+  size_t size() const;
+  size_t lower() const;
+  size_t upper() const;
+
+  /// Whether (x, y) is inside the band.
+  bool inBand(const size_t &x, const size_t &y) const;
+
+  /// The entry at column x and row y; 0 outside the band.
+  double operator()(const size_t &x, const size_t &y) const;
+
+  /// The entry at column x and row y. Throws std::out_of_range outside the
+  /// band.
+  double &operator()(const size_t &x, const size_t &y);
+
+  /// The band, as described above.
+  const std::vector<double> &band() const;
+
+  /// The matrix as a dense Matrix.
+  Matrix toDense() const;
+
+  /// Banded times dense, O(n * (lower + upper + 1)) per column of dense.
+  /// The rows of the result are computed in parallel.
+  const Matrix operator*(const Matrix &dense) const;
+
+private:
+  size_t index(const size_t &x, const size_t &y) const;
+
+  size_t m_n;
+  size_t m_lower;
+  size_t m_upper;
+  std::vector<double> m_band;
+};
+
+/// LU factorization of a banded matrix with partial pivoting, P*A = L*U, as
+/// LAPACK's xGBTRF does it. Row interchanges widen U to lower + upper
+/// superdiagonals, so the factors are returned in a new BandedMatrix with
+/// that many superdiagonals, U on and above the diagonal and the
+/// multipliers of the unit lower-triangular L below it. The cost is
+/// O(n * lower * (lower + upper)).
+/// @in A - the banded matrix.
+/// @out LU - the factors.
+/// @out pivots - row i was swapped with row pivots[i] at step i.
+/// Returns false if a pivot is exactly zero, i.e. A is singular.
+bool bandedLUFactorize(const BandedMatrix &A, BandedMatrix &LU,
+                       std::vector<size_t> &pivots);
+
+/// Solve A*x = b using the output of bandedLUFactorize. Each column of b is
+/// solved, in O(n * (2 * lower + upper)).
+/// @in LU, pivots - result of bandedLUFactorize.
+/// @in/out b - right-hand side of equation. Output is stored here.
+void solveBandedLU(const BandedMatrix &LU, const std::vector<size_t> &pivots,
+                   Matrix &b);
+
+/// Cholesky factorization, A = L * L^T, of a symmetric positive definite
+/// banded matrix. Only the diagonal and the lower() subdiagonals of A are
+/// read. L has the same lower bandwidth and no superdiagonals. The cost is
+/// O(n * lower^2).
+/// Returns false if A is not positive definite.
+bool bandedCholeskyFactorize(const BandedMatrix &A, BandedMatrix &L);
+
+/// Solve A*x = b using the output of bandedCholeskyFactorize. Each column
+/// of b is solved, in O(n * lower).
+void solveBandedCholesky(const BandedMatrix &L, Matrix &b);
+
+/// Solve A*x = b for each of a batch of banded systems with bandedLUFactorize
+/// and solveBandedLU. The systems are independent and are solved in
+/// parallel.
+/// @in A - the banded matrices.
+/// @in/out b - right-hand sides, one per matrix. Outputs are stored here.
+/// Returns false if any of the matrices is singular; the corresponding b
+/// is left unchanged.
+bool solveBandedBatch(const std::vector<BandedMatrix> &A,
+                      std::vector<Matrix> &b);
+
+/// Solve the tridiagonal system A*x = b with the Thomas algorithm, O(n)
+/// per column of b. There is no pivoting, so A should be diagonally
+/// dominant or symmetric positive definite; use bandedLUFactorize
+/// otherwise.
+/// @in sub - the (n-1) x 1 subdiagonal, sub(0, i) = A(i, i + 1).
+/// @in diagonal - the n x 1 diagonal.
+/// @in super - the (n-1) x 1 superdiagonal, super(0, i) = A(i + 1, i).
+/// @in/out b - right-hand side of equation. Output is stored here.
+/// Returns false if a pivot is zero.
+bool solveTridiagonal(const Matrix &sub, const Matrix &diagonal,
+                      const Matrix &super, Matrix &b);
+
+/// Solve a batch of m independent n x n tridiagonal systems with the Thomas
+/// algorithm. Column j of each argument belongs to system j, so sub and
+/// super are m x (n-1) and diagonal and b are m x n. The elimination runs
+/// down the rows with the systems side by side in each row, which keeps
+/// the inner loop contiguous, and blocks of systems run in parallel.
+/// Returns false if a pivot is zero in any system.
+bool solveTridiagonalBatch(const Matrix &sub, const Matrix &diagonal,
+                           const Matrix &super, Matrix &b);
+}; // namespace basic_matrix
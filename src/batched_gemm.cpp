@@ -0,0 +1,160 @@
+#include "batched_gemm.hpp"
+#include "kernel_helpers.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+namespace basic_matrix {
+namespace {
+typedef void (*Kernel)(const double *a, const double *b, double *c,
+                       const double &alpha, const double &beta);
+
+/// C = alpha * A * B + beta * C for an M x K A and a K x N B. The sizes
+/// are compile-time constants, so the compiler unrolls every loop and keeps
+/// C in registers.
+template <size_t M, size_t N, size_t K>
+void fixedKernel(const double *a, const double *b, double *c,
+                 const double &alpha, const double &beta) {
+  double sum[M][N] = {};
+  for (size_t i = 0; i < M; i++) {
+    for (size_t p = 0; p < K; p++) {
+      for (size_t j = 0; j < N; j++) {
+        sum[i][j] += a[i * K + p] * b[p * N + j];
+      }
+    }
+  }
+  for (size_t i = 0; i < M; i++) {
+    for (size_t j = 0; j < N; j++) {
+      c[i * N + j] = beta == 0.0 ? alpha * sum[i][j]
+                                 : alpha * sum[i][j] + beta * c[i * N + j];
+    }
+  }
+}
+
+template <size_t M, size_t N> Kernel kernelForK(const size_t &k) {
+  switch (k) {
+  case 1:
+    return fixedKernel<M, N, 1>;
+  case 2:
+    return fixedKernel<M, N, 2>;
+  case 3:
+    return fixedKernel<M, N, 3>;
+  case 4:
+    return fixedKernel<M, N, 4>;
+  }
+  return nullptr;
+}
+
+template <size_t M> Kernel kernelForN(const size_t &n, const size_t &k) {
+  switch (n) {
+  case 1:
+    return kernelForK<M, 1>(k);
+  case 2:
+    return kernelForK<M, 2>(k);
+  case 3:
+    return kernelForK<M, 3>(k);
+  case 4:
+    return kernelForK<M, 4>(k);
+  }
+  return nullptr;
+}
+
+/// The micro-kernel for an m x k times k x n product, or null if there is
+/// none for that shape.
+Kernel fixedSizeKernel(const size_t &m, const size_t &n, const size_t &k) {
+  switch (m) {
+  case 1:
+    return kernelForN<1>(n, k);
+  case 2:
+    return kernelForN<2>(n, k);
+  case 3:
+    return kernelForN<3>(n, k);
+  case 4:
+    return kernelForN<4>(n, k);
+  }
+  return nullptr;
+}
+
+/// C = alpha * A * B + beta * C for any shape, a row of C at a time.
+void genericKernel(const double *a, const double *b, double *c,
+                   const size_t &m, const size_t &n, const size_t &k,
+                   const double &alpha, const double &beta) {
+  for (size_t i = 0; i < m; i++) {
+    double *c_row = &c[i * n];
+    for (size_t j = 0; j < n; j++) {
+      c_row[j] = beta == 0.0 ? 0.0 : beta * c_row[j];
+    }
+    for (size_t p = 0; p < k; p++) {
+      double a_ip = alpha * a[i * k + p];
+      const double *b_row = &b[p * n];
+      for (size_t j = 0; j < n; j++) {
+        c_row[j] += a_ip * b_row[j];
+      }
+    }
+  }
+}
+}; // namespace
+
+void batchedMultiply(const double *A, const size_t &stride_a, const double *B,
+                     const size_t &stride_b, double *C,
+                     const size_t &stride_c, const size_t &m, const size_t &n,
+                     const size_t &k, const size_t &count,
+                     const double &alpha, const double &beta) {
+  if (m == 0 || n == 0 || count == 0) {
+    return;
+  }
+  if (count > 1 && stride_c < m * n) {
+    throw std::runtime_error(
+        "Cannot write a batch of " + std::to_string(count) + " " +
+        std::to_string(m) + "x" + std::to_string(n) +
+        " products with a C stride of " + std::to_string(stride_c) +
+        "; the products would overlap.");
+  }
+  size_t min_chunk = indicesPerChunk(count, count * (2 * m * n * k + 1));
+  Kernel kernel = fixedSizeKernel(m, n, k);
+  if (kernel) {
+    parallelFor(
+        0, count,
+        [&](const size_t &i) {
+          kernel(&A[i * stride_a], &B[i * stride_b], &C[i * stride_c], alpha,
+                 beta);
+        },
+        min_chunk);
+    return;
+  }
+  parallelFor(
+      0, count,
+      [&](const size_t &i) {
+        genericKernel(&A[i * stride_a], &B[i * stride_b], &C[i * stride_c], m,
+                      n, k, alpha, beta);
+      },
+      min_chunk);
+}
+
+Matrix batchedMultiply(const Matrix &A, const Matrix &B,
+                       const size_t &count) {
+  size_t k = A.width();
+  size_t n = B.width();
+  if (count == 0 || A.height() % count != 0 || B.height() != k * count) {
+    throw std::runtime_error(
+        "Cannot multiply a batch of " + std::to_string(count) + " from a " +
+        std::to_string(A.width()) + "x" + std::to_string(A.height()) +
+        " and a " + std::to_string(B.width()) + "x" +
+        std::to_string(B.height()) +
+        " stack; A must be k x (m * count) and B n x (k * count).");
+  }
+  if (!A.contiguous()) {
+    return batchedMultiply(Matrix(A), B, count);
+  }
+  if (!B.contiguous()) {
+    return batchedMultiply(A, Matrix(B), count);
+  }
+  size_t m = A.height() / count;
+  Matrix result(n, m * count);
+  if (m == 0 || n == 0 || k == 0) {
+    return result;
+  }
+  batchedMultiply(A.data(), m * k, B.data(), k * n, result.data(), m * n, m,
+                  n, k, count);
+  return result;
+}
+}; // namespace basic_matrix
@@ -0,0 +1,33 @@
+#pragma once
+#include "matrix.hpp"
+
+namespace basic_matrix {
+/// Batched general matrix multiplication over strided arrays, as in BLAS's
+/// gemm_batch_strided:
+///   C_i = alpha * A_i * B_i + beta * C_i,  for i in [0, count),
+/// where A_i is the row-major m x k matrix at A + i * stride_a, B_i the
+/// row-major k x n matrix at B + i * stride_b and C_i the row-major m x n
+/// matrix at C + i * stride_c. A stride of 0 for A or B uses the same
+/// matrix for every product, e.g. to apply one transform to many points.
+/// The C_i are written concurrently, so they must not overlap: a
+/// stride_c smaller than m * n throws if count > 1.
+///
+/// Products with m, n and k all at most 4 use micro-kernels compiled for
+/// their exact shape, with every loop unrolled; larger shapes use a generic
+/// loop. Either way there is no allocation or dispatch per product, and the
+/// batch is spread over threads.
+///
+/// If beta is 0, C is overwritten and its previous contents are ignored,
+/// even if they are NaN.
+void batchedMultiply(const double *A, const size_t &stride_a, const double *B,
+                     const size_t &stride_b, double *C,
+                     const size_t &stride_c, const size_t &m, const size_t &n,
+                     const size_t &k, const size_t &count,
+                     const double &alpha = 1.0, const double &beta = 0.0);
+
+/// batchedMultiply for matrices stacked vertically, as in BatchedLU: A is
+/// k x (m * count), B is n x (k * count), and the result is n x (m * count),
+/// with product i in rows [i * m, (i + 1) * m). A and B are only copied if
+/// they are not contiguous.
+Matrix batchedMultiply(const Matrix &A, const Matrix &B, const size_t &count);
+}; // namespace basic_matrix
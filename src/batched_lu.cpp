@@ -0,0 +1,237 @@
+#include "batched_lu.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+/// One double per matrix of a group.
+typedef double double8 __attribute__((vector_size(64)));
+static_assert(sizeof(double8) == BatchedLU::kLanes * sizeof(double),
+              "One lane per matrix of a group.");
+
+/// double8 at the alignment of a double, for the lanes of a group in its
+/// storage. No vector is passed or returned by value between functions, as
+/// the ABI for 64-byte vectors depends on whether AVX-512 is enabled;
+/// scalars in vector expressions are broadcast to every lane instead.
+typedef double unalignedDouble8
+    __attribute__((vector_size(64), aligned(alignof(double)), may_alias));
+
+inline const unalignedDouble8 &load(const double *p) {
+  return *reinterpret_cast<const unalignedDouble8 *>(p);
+}
+
+inline void store(double *p, const double8 &v) {
+  *reinterpret_cast<unalignedDouble8 *>(p) = v;
+}
+
+/// Swap rows k and y of the lanes in which pivot == y. Rows are width
+/// vectors long and start at rows[row * width].
+inline void swapRows(double *rows, const size_t &width, const size_t &k,
+                     const double8 &pivot, const size_t &n) {
+  for (size_t y = k + 1; y < n; y++) {
+    auto mask = pivot == double(y);
+    bool any = false;
+    for (size_t l = 0; l < BatchedLU::kLanes; l++) {
+      any = any || mask[l];
+    }
+    if (!any) {
+      continue;
+    }
+    for (size_t x = 0; x < width; x++) {
+      double *p = &rows[(k * width + x) * BatchedLU::kLanes];
+      double *q = &rows[(y * width + x) * BatchedLU::kLanes];
+      double8 a = load(p);
+      double8 b = load(q);
+      store(p, mask ? b : a);
+      store(q, mask ? a : b);
+    }
+  }
+}
+
+/// Groups per parallel chunk so that each chunk does roughly 2^16 flops.
+size_t groupsPerChunk(const size_t &flops_per_group) {
+  return std::max<size_t>(1, (size_t(1) << 16) /
+                                 std::max<size_t>(flops_per_group, 1));
+}
+}; // namespace
+
+BatchedLU::BatchedLU(const Matrix &stacked, const size_t &n)
+    : m_n(n), m_count(n == 0 ? 0 : stacked.height() / n) {
+  if (stacked.width() != n || stacked.height() != n * m_count) {
+    throw std::runtime_error("A batch of " + std::to_string(n) + "x" +
+                             std::to_string(n) +
+                             " matrices must be n x (n * count), but got " +
+                             std::to_string(stacked.width()) + "x" +
+                             std::to_string(stacked.height()));
+  }
+  size_t groups = (m_count + kLanes - 1) / kLanes;
+  m_factors.assign(groups * n * n * kLanes, 0.0);
+  m_pivots.assign(groups * n * kLanes, 0.0);
+  m_ok.assign(m_count, 1);
+  if (n == 0) {
+    return;
+  }
+  parallelFor(
+      0, groups,
+      [&](const size_t &g) {
+        double *a = &m_factors[g * n * n * kLanes];
+        // Interleave the group's matrices. Lanes past the end of the batch
+        // hold the identity.
+        for (size_t l = 0; l < kLanes; l++) {
+          size_t i = g * kLanes + l;
+          for (size_t y = 0; y < n; y++) {
+            for (size_t x = 0; x < n; x++) {
+              a[(y * n + x) * kLanes + l] =
+                  i < m_count ? stacked(x, i * n + y) : double(x == y);
+            }
+          }
+        }
+        double8 zero_pivot = {};
+        for (size_t k = 0; k < n; k++) {
+          // Each lane picks its own pivot row.
+          double8 best = load(&a[(k * n + k) * kLanes]);
+          best = best < 0.0 ? -best : best;
+          double8 pivot = (double8){} + double(k);
+          for (size_t y = k + 1; y < n; y++) {
+            double8 v = load(&a[(y * n + k) * kLanes]);
+            v = v < 0.0 ? -v : v;
+            auto larger = v > best;
+            best = larger ? v : best;
+            pivot = larger ? double(y) : pivot;
+          }
+          store(&m_pivots[(g * n + k) * kLanes], pivot);
+          swapRows(a, n, k, pivot, n);
+          // A zero pivot makes its lane NaN from here on, without touching
+          // the other lanes.
+          double8 d = load(&a[(k * n + k) * kLanes]);
+          zero_pivot = d == 0.0 ? 1.0 : zero_pivot;
+          double8 inverse = 1.0 / d;
+          for (size_t y = k + 1; y < n; y++) {
+            double *row = &a[y * n * kLanes];
+            const double *pivot_row = &a[k * n * kLanes];
+            double8 l = load(&row[k * kLanes]) * inverse;
+            store(&row[k * kLanes], l);
+            for (size_t x = k + 1; x < n; x++) {
+              store(&row[x * kLanes], load(&row[x * kLanes]) -
+                                          l * load(&pivot_row[x * kLanes]));
+            }
+          }
+        }
+        for (size_t l = 0; l < kLanes && g * kLanes + l < m_count; l++) {
+          m_ok[g * kLanes + l] = zero_pivot[l] == 0.0;
+        }
+      },
+      groupsPerChunk(n * n * n * kLanes));
+}
+
+size_t BatchedLU::size() const { return m_n; }
+size_t BatchedLU::count() const { return m_count; }
+bool BatchedLU::ok(const size_t &i) const { return m_ok.at(i) != 0; }
+
+bool BatchedLU::allOk() const {
+  return std::all_of(m_ok.begin(), m_ok.end(),
+                     [](const char &ok) { return ok != 0; });
+}
+
+void BatchedLU::solve(Matrix &b) const {
+  size_t n = m_n;
+  size_t m = b.width();
+  if (b.height() != n * m_count) {
+    throw std::runtime_error(
+        "The right-hand sides of a batch of " + std::to_string(m_count) +
+        " " + std::to_string(n) + "x" + std::to_string(n) +
+        " systems must have height " + std::to_string(n * m_count) +
+        ", but got " + std::to_string(b.height()));
+  }
+  if (n == 0 || m == 0) {
+    return;
+  }
+  size_t groups = (m_count + kLanes - 1) / kLanes;
+  parallelFor(
+      0, groups,
+      [&](const size_t &g) {
+        const double *a = &m_factors[g * n * n * kLanes];
+        std::vector<double> x(n * m * kLanes, 0.0);
+        for (size_t l = 0; l < kLanes && g * kLanes + l < m_count; l++) {
+          size_t i = g * kLanes + l;
+          for (size_t y = 0; y < n; y++) {
+            for (size_t c = 0; c < m; c++) {
+              x[(y * m + c) * kLanes + l] = b(c, i * n + y);
+            }
+          }
+        }
+        for (size_t k = 0; k < n; k++) {
+          swapRows(x.data(), m, k, load(&m_pivots[(g * n + k) * kLanes]), n);
+        }
+        // Forward substitution with the unit lower triangle, then back
+        // substitution with the upper triangle.
+        for (size_t y = 1; y < n; y++) {
+          for (size_t k = 0; k < y; k++) {
+            double8 l = load(&a[(y * n + k) * kLanes]);
+            for (size_t c = 0; c < m; c++) {
+              double *p = &x[(y * m + c) * kLanes];
+              store(p, load(p) - l * load(&x[(k * m + c) * kLanes]));
+            }
+          }
+        }
+        for (size_t y = n; y-- > 0;) {
+          for (size_t k = y + 1; k < n; k++) {
+            double8 u = load(&a[(y * n + k) * kLanes]);
+            for (size_t c = 0; c < m; c++) {
+              double *p = &x[(y * m + c) * kLanes];
+              store(p, load(p) - u * load(&x[(k * m + c) * kLanes]));
+            }
+          }
+          double8 inverse = 1.0 / load(&a[(y * n + y) * kLanes]);
+          for (size_t c = 0; c < m; c++) {
+            double *p = &x[(y * m + c) * kLanes];
+            store(p, load(p) * inverse);
+          }
+        }
+        for (size_t l = 0; l < kLanes && g * kLanes + l < m_count; l++) {
+          size_t i = g * kLanes + l;
+          for (size_t y = 0; y < n; y++) {
+            for (size_t c = 0; c < m; c++) {
+              b(c, i * n + y) = m_ok[i]
+                                    ? x[(y * m + c) * kLanes + l]
+                                    : std::numeric_limits<double>::quiet_NaN();
+            }
+          }
+        }
+      },
+      groupsPerChunk(2 * n * n * m * kLanes));
+}
+
+Matrix BatchedLU::inverse() const {
+  Matrix result(m_n, m_n * m_count);
+  for (size_t i = 0; i < m_count; i++) {
+    for (size_t j = 0; j < m_n; j++) {
+      result(j, i * m_n + j) = 1.0;
+    }
+  }
+  solve(result);
+  return result;
+}
+
+Matrix BatchedLU::determinants() const {
+  Matrix result(1, m_count);
+  for (size_t i = 0; i < m_count; i++) {
+    if (!m_ok[i]) {
+      continue;
+    }
+    size_t g = i / kLanes;
+    size_t l = i % kLanes;
+    double det = 1.0;
+    for (size_t k = 0; k < m_n; k++) {
+      det *= m_factors[((g * m_n + k) * m_n + k) * kLanes + l];
+      if (m_pivots[(g * m_n + k) * kLanes + l] != double(k)) {
+        det = -det;
+      }
+    }
+    result(0, i) = det;
+  }
+  return result;
+}
+}; // namespace basic_matrix
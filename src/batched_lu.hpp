@@ -0,0 +1,64 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// LU factorizations, with partial pivoting, of a batch of small square
+/// matrices of the same size, for solving many independent systems at once.
+///
+/// The batch is a Matrix of n x n blocks stacked vertically: the n x
+/// (n * count) matrix whose rows [i * n, (i + 1) * n) are matrix i, so the
+/// matrices lie one after the other in memory. Right-hand sides and
+/// results are stacked the same way.
+///
+/// Internally the matrices are interleaved in groups of kLanes: entry (x, y)
+/// of the matrices of a group sits in one SIMD vector, one matrix per lane.
+/// Every step of the factorization and of the solves is then a vector
+/// operation over kLanes matrices, pivoting included, with no per-matrix
+/// allocation or dispatch. Groups are spread over threads.
+class BatchedLU {
+public:
+  /// The number of matrices per SIMD vector.
+  static const size_t kLanes = 8;
+
+  /// Factor the count = stacked.height() / n matrices in stacked.
+  /// @in stacked - n x (n * count), the matrices stacked vertically.
+  /// @in n - the size of each matrix.
+  BatchedLU(const Matrix &stacked, const size_t &n);
+
+  /// The size of each matrix.
+  size_t size() const;
+
+  /// The number of matrices.
+  size_t count() const;
+
+  /// Whether matrix i was factored without an exactly zero pivot. The
+  /// solution and inverse of a singular matrix are NaN.
+  bool ok(const size_t &i) const;
+
+  /// Whether every matrix was factored without an exactly zero pivot.
+  bool allOk() const;
+
+  /// Solve A_i * x_i = b_i for every matrix.
+  /// @in/out b - m x (n * count), the right-hand sides stacked vertically;
+  ///             each may have m columns. Output is stored here.
+  void solve(Matrix &b) const;
+
+  /// The inverses, stacked vertically.
+  Matrix inverse() const;
+
+  /// The determinants, as a count x 1 column. 0 for a singular matrix.
+  Matrix determinants() const;
+
+private:
+  size_t m_n;
+  size_t m_count;
+  /// Factors in the interleaved layout: group g, entry (x, y) and lane l at
+  /// ((g * n + y) * n + x) * kLanes + l.
+  std::vector<double> m_factors;
+  /// Pivots, interleaved likewise: group g, step k and lane l at
+  /// (g * n + k) * kLanes + l.
+  std::vector<double> m_pivots;
+  std::vector<char> m_ok;
+};
+}; // namespace basic_matrix
@@ -0,0 +1,242 @@
+#include "diagonal_matrix.hpp"
+
+namespace basic_matrix {
+namespace {
+void throwSizeMismatch(const Matrix &A, const size_t &n,
+                       const std::string &operation) {
+  throw std::runtime_error(operation + " of a " + std::to_string(A.width()) +
+                           "x" + std::to_string(A.height()) +
+                           " matrix and a " + std::to_string(n) + "x" +
+                           std::to_string(n) + " diagonal matrix.");
+}
+
+/// A += scale * D, or A += scale * I if D is null.
+void addToDiagonal(Matrix &A, const size_t &n, const double *D,
+                   const double &scale) {
+  if (A.width() != n || A.height() != n) {
+    throwSizeMismatch(A, n, "Addition");
+  }
+  if (A.contiguous()) {
+    double *a = A.data();
+    for (size_t i = 0; i < n; i++) {
+      a[i * n + i] += scale * (D ? D[i] : 1.0);
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    A(i, i) += scale * (D ? D[i] : 1.0);
+  }
+}
+}; // namespace
+
+Identity::Identity(const size_t &n) : m_n(n) {}
+size_t Identity::size() const { return m_n; }
+Matrix Identity::toDense() const { return identity(m_n); }
+
+ScaledIdentity::ScaledIdentity(const size_t &n, const double &scale)
+    : m_n(n), m_scale(scale) {}
+ScaledIdentity::ScaledIdentity(const Identity &identity)
+    : ScaledIdentity(identity.size(), 1.0) {}
+size_t ScaledIdentity::size() const { return m_n; }
+double ScaledIdentity::scale() const { return m_scale; }
+Matrix ScaledIdentity::toDense() const { return identity(m_n) * m_scale; }
+
+Diagonal::Diagonal() {}
+Diagonal::Diagonal(const std::vector<double> &values) : m_values(values) {}
+Diagonal::Diagonal(const Matrix &values) : m_values(values.height()) {
+  if (values.width() != 1) {
+    throw std::runtime_error("A diagonal must be an n x 1 column vector, "
+                             "but got " +
+                             std::to_string(values.width()) + "x" +
+                             std::to_string(values.height()));
+  }
+  for (size_t i = 0; i < m_values.size(); i++) {
+    m_values[i] = values(0, i);
+  }
+}
+Diagonal::Diagonal(const ScaledIdentity &scaled_identity)
+    : m_values(scaled_identity.size(), scaled_identity.scale()) {}
+
+size_t Diagonal::size() const { return m_values.size(); }
+double Diagonal::operator()(const size_t &i) const { return m_values.at(i); }
+double &Diagonal::operator()(const size_t &i) { return m_values.at(i); }
+const std::vector<double> &Diagonal::values() const { return m_values; }
+
+Matrix Diagonal::toDense() const {
+  Matrix result(size(), size());
+  for (size_t i = 0; i < size(); i++) {
+    result(i, i) = m_values[i];
+  }
+  return result;
+}
+
+Diagonal Diagonal::inverse() const {
+  Diagonal result = *this;
+  for (auto &value : result.m_values) {
+    if (value == 0.0) {
+      throw std::runtime_error("Cannot invert a singular diagonal matrix.");
+    }
+    value = 1.0 / value;
+  }
+  return result;
+}
+
+Diagonal diagonalOf(const Matrix &A) {
+  if (A.width() != A.height()) {
+    throw std::runtime_error("Cannot take the diagonal of a non-square " +
+                             std::to_string(A.width()) + "x" +
+                             std::to_string(A.height()) + " matrix.");
+  }
+  std::vector<double> values(A.height());
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = A(i, i);
+  }
+  return Diagonal(values);
+}
+
+const ScaledIdentity operator*(const double &scale, const Identity &I) {
+  return ScaledIdentity(I.size(), scale);
+}
+const ScaledIdentity operator*(const Identity &I, const double &scale) {
+  return scale * I;
+}
+const ScaledIdentity operator*(const double &scale, const ScaledIdentity &S) {
+  return ScaledIdentity(S.size(), scale * S.scale());
+}
+const ScaledIdentity operator*(const ScaledIdentity &S, const double &scale) {
+  return scale * S;
+}
+const ScaledIdentity operator-(const ScaledIdentity &S) { return -1.0 * S; }
+
+const Diagonal operator*(const double &scale, const Diagonal &D) {
+  std::vector<double> values = D.values();
+  for (auto &value : values) {
+    value *= scale;
+  }
+  return Diagonal(values);
+}
+const Diagonal operator*(const Diagonal &D, const double &scale) {
+  return scale * D;
+}
+const Diagonal operator-(const Diagonal &D) { return -1.0 * D; }
+
+namespace {
+template <typename Fn>
+Diagonal combine(const Diagonal &D, const Diagonal &E, const Fn &fn) {
+  if (D.size() != E.size()) {
+    throw std::runtime_error("Cannot combine diagonal matrices of sizes " +
+                             std::to_string(D.size()) + " and " +
+                             std::to_string(E.size()));
+  }
+  std::vector<double> values(D.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = fn(D.values()[i], E.values()[i]);
+  }
+  return Diagonal(values);
+}
+}; // namespace
+
+const Diagonal operator+(const Diagonal &D, const Diagonal &E) {
+  return combine(D, E, [](const double &d, const double &e) { return d + e; });
+}
+const Diagonal operator-(const Diagonal &D, const Diagonal &E) {
+  return combine(D, E, [](const double &d, const double &e) { return d - e; });
+}
+const Diagonal operator*(const Diagonal &D, const Diagonal &E) {
+  return combine(D, E, [](const double &d, const double &e) { return d * e; });
+}
+
+const Matrix operator+(const Matrix &A, const Diagonal &D) {
+  Matrix result = A;
+  result += D;
+  return result;
+}
+const Matrix operator-(const Matrix &A, const Diagonal &D) {
+  Matrix result = A;
+  result -= D;
+  return result;
+}
+const Matrix operator+(const Diagonal &D, const Matrix &A) { return A + D; }
+const Matrix operator-(const Diagonal &D, const Matrix &A) {
+  Matrix result = -A;
+  result += D;
+  return result;
+}
+const Matrix operator+(const Matrix &A, const ScaledIdentity &S) {
+  Matrix result = A;
+  result += S;
+  return result;
+}
+const Matrix operator-(const Matrix &A, const ScaledIdentity &S) {
+  Matrix result = A;
+  result -= S;
+  return result;
+}
+const Matrix operator+(const ScaledIdentity &S, const Matrix &A) {
+  return A + S;
+}
+const Matrix operator-(const ScaledIdentity &S, const Matrix &A) {
+  Matrix result = -A;
+  result += S;
+  return result;
+}
+
+void operator+=(Matrix &A, const Diagonal &D) {
+  addToDiagonal(A, D.size(), D.values().data(), 1.0);
+}
+void operator-=(Matrix &A, const Diagonal &D) {
+  addToDiagonal(A, D.size(), D.values().data(), -1.0);
+}
+void operator+=(Matrix &A, const ScaledIdentity &S) {
+  addToDiagonal(A, S.size(), nullptr, S.scale());
+}
+void operator-=(Matrix &A, const ScaledIdentity &S) {
+  addToDiagonal(A, S.size(), nullptr, -S.scale());
+}
+
+const Matrix operator*(const Diagonal &D, const Matrix &A) {
+  if (A.height() != D.size()) {
+    throwSizeMismatch(A, D.size(), "Multiplication");
+  }
+  Matrix result = A;
+  double *r = result.data();
+  size_t w = result.width();
+  for (size_t y = 0; y < result.height(); y++) {
+    double d = D.values()[y];
+    for (size_t x = 0; x < w; x++) {
+      r[y * w + x] *= d;
+    }
+  }
+  return result;
+}
+
+const Matrix operator*(const Matrix &A, const Diagonal &D) {
+  if (A.width() != D.size()) {
+    throwSizeMismatch(A, D.size(), "Multiplication");
+  }
+  Matrix result = A;
+  double *r = result.data();
+  const double *d = D.values().data();
+  size_t w = result.width();
+  for (size_t y = 0; y < result.height(); y++) {
+    for (size_t x = 0; x < w; x++) {
+      r[y * w + x] *= d[x];
+    }
+  }
+  return result;
+}
+
+const Matrix operator*(const ScaledIdentity &S, const Matrix &A) {
+  if (A.height() != S.size()) {
+    throwSizeMismatch(A, S.size(), "Multiplication");
+  }
+  return A * S.scale();
+}
+
+const Matrix operator*(const Matrix &A, const ScaledIdentity &S) {
+  if (A.width() != S.size()) {
+    throwSizeMismatch(A, S.size(), "Multiplication");
+  }
+  return A * S.scale();
+}
+}; // namespace basic_matrix
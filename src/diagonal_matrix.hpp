@@ -0,0 +1,98 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// The n x n identity matrix, without its n^2 storage. Combined with a
+/// Matrix it costs O(n) on top of any copy, e.g. A - mu * Identity(n) only
+/// touches the diagonal of A. Use identity() for a dense one.
+class Identity {
+public:
+  explicit Identity(const size_t &n);
+
+  size_t size() const;
+  Matrix toDense() const;
+
+private:
+  size_t m_n;
+};
+
+/// scale * I for an n x n identity I.
+class ScaledIdentity {
+public:
+  ScaledIdentity(const size_t &n, const double &scale);
+  ScaledIdentity(const Identity &identity);
+
+  size_t size() const;
+  double scale() const;
+  Matrix toDense() const;
+
+private:
+  size_t m_n;
+  double m_scale;
+};
+
+/// An n x n diagonal matrix that only stores its diagonal.
+class Diagonal {
+public:
+  /// A 0x0 diagonal matrix.
+  Diagonal();
+  explicit Diagonal(const std::vector<double> &values);
+  /// The diagonal matrix with the n x 1 column vector values on its
+  /// diagonal.
+  explicit Diagonal(const Matrix &values);
+  Diagonal(const ScaledIdentity &scaled_identity);
+
+  size_t size() const;
+  double operator()(const size_t &i) const;
+  double &operator()(const size_t &i);
+  const std::vector<double> &values() const;
+  Matrix toDense() const;
+
+  /// The inverse, which throws std::runtime_error if an entry is zero.
+  Diagonal inverse() const;
+
+private:
+  std::vector<double> m_values;
+};
+
+/// The diagonal of the square matrix A.
+Diagonal diagonalOf(const Matrix &A);
+
+const ScaledIdentity operator*(const double &scale, const Identity &I);
+const ScaledIdentity operator*(const Identity &I, const double &scale);
+const ScaledIdentity operator*(const double &scale, const ScaledIdentity &S);
+const ScaledIdentity operator*(const ScaledIdentity &S, const double &scale);
+const ScaledIdentity operator-(const ScaledIdentity &S);
+const Diagonal operator*(const double &scale, const Diagonal &D);
+const Diagonal operator*(const Diagonal &D, const double &scale);
+const Diagonal operator-(const Diagonal &D);
+
+const Diagonal operator+(const Diagonal &D, const Diagonal &E);
+const Diagonal operator-(const Diagonal &D, const Diagonal &E);
+/// Entrywise product.
+const Diagonal operator*(const Diagonal &D, const Diagonal &E);
+
+/// A + D and A - D, with D a diagonal or a scaled identity, copy A and
+/// update its diagonal.
+const Matrix operator+(const Matrix &A, const Diagonal &D);
+const Matrix operator-(const Matrix &A, const Diagonal &D);
+const Matrix operator+(const Diagonal &D, const Matrix &A);
+const Matrix operator-(const Diagonal &D, const Matrix &A);
+const Matrix operator+(const Matrix &A, const ScaledIdentity &S);
+const Matrix operator-(const Matrix &A, const ScaledIdentity &S);
+const Matrix operator+(const ScaledIdentity &S, const Matrix &A);
+const Matrix operator-(const ScaledIdentity &S, const Matrix &A);
+
+/// In place, these only touch the n diagonal entries of A.
+void operator+=(Matrix &A, const Diagonal &D);
+void operator-=(Matrix &A, const Diagonal &D);
+void operator+=(Matrix &A, const ScaledIdentity &S);
+void operator-=(Matrix &A, const ScaledIdentity &S);
+
+/// D * A scales row i of A by D(i); A * D scales column i.
+const Matrix operator*(const Diagonal &D, const Matrix &A);
+const Matrix operator*(const Matrix &A, const Diagonal &D);
+const Matrix operator*(const ScaledIdentity &S, const Matrix &A);
+const Matrix operator*(const Matrix &A, const ScaledIdentity &S);
+}; // namespace basic_matrix
@@ -1,81 +1,481 @@
 #include "eigenvalues.hpp"
 #include "qr_factorization.hpp"
 #include "scalar.hpp"
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <math.h>
 
 namespace basic_matrix {
 namespace {
-void hessenbergReduction(Matrix &A) {
-  int n = A.height();
-  if (n > 2) {
-    Matrix a1(MatrixROI(0, 1, 1, A.height() - 1, &A));
-    Matrix a1_reflected(MatrixROI(1, 0, A.width() - 1, 1, &A));
-    Matrix a11(MatrixROI(1, 1, A.width() - 1, A.height() - 1, &A));
-    Matrix e1(1, n - 1);
-    auto sgn = sign(a1(0, 0));
-    e1(0, 0) = 1;
-    Matrix v = (a1 + sgn * a1.norm() * e1);
-    v /= v.norm();
-    Matrix Q1 = identity(n - 1) - 2 * (v * v.transpose());
-    a1 = Q1 * a1;
-    a1_reflected = (Q1 * a1_reflected.transpose()).transpose();
-    a11 = Q1 * a11 * Q1.transposeROI();
-    if (n > 1) {
-      hessenbergReduction(a11);
+/// Columns reduced per block by hessenbergReduction, as long as the
+/// trailing matrix is larger than kHessenbergUnblockedSize; the last
+/// columns are reduced one at a time.
+constexpr size_t kHessenbergBlockSize = 32;
+constexpr size_t kHessenbergUnblockedSize = 128;
+
+/// The dot product of the n values at a and b, with independent partial
+/// sums so that the loop is not bound by the latency of one addition.
+double dot(const double *a, const double *b, const size_t &n) {
+  double s[4] = {0., 0., 0., 0.};
+  size_t r = 0;
+  for (; r + 4 <= n; r += 4) {
+    for (size_t q = 0; q < 4; q++) {
+      s[q] += a[r + q] * b[r + q];
     }
   }
+  for (; r < n; r++) {
+    s[0] += a[r] * b[r];
+  }
+  return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+/// Reduce columns [k_begin, n - 2) of the contiguous n x n matrix a one
+/// reflector at a time, each applied as a rank-1 update from both sides.
+void reduceUnblocked(double *a, const size_t &n, const size_t &k_begin,
+                     Matrix &tau) {
+  std::vector<double> v(n);
+  std::vector<double> w(n);
+  for (size_t k = k_begin; k + 2 < n; k++) {
+    // Reflect column k below the subdiagonal onto the subdiagonal. v acts on
+    // rows/columns k+1, ..., n-1.
+    double t = householderReflector(&a[(k + 1) * n + k], &a[(k + 2) * n + k],
+                                    n - k - 2, n);
+    tau(0, k) = t;
+    if (t == 0.0) {
+      continue;
+    }
+    size_t m = n - k - 1;
+    v[0] = 1.0;
+    for (size_t r = 1; r < m; r++) {
+      v[r] = a[(k + 1 + r) * n + k];
+    }
+    // Left update, A(k+1:n, k+1:n) = H_k * A(k+1:n, k+1:n), as a rank-1
+    // update along the rows: w = v^T * A, A -= t * v * w^T.
+    for (size_t c = k + 1; c < n; c++) {
+      w[c] = 0.0;
+    }
+    for (size_t r = 0; r < m; r++) {
+      const double *row = &a[(k + 1 + r) * n];
+      for (size_t c = k + 1; c < n; c++) {
+        w[c] += v[r] * row[c];
+      }
+    }
+    for (size_t r = 0; r < m; r++) {
+      double *row = &a[(k + 1 + r) * n];
+      double f = t * v[r];
+      for (size_t c = k + 1; c < n; c++) {
+        row[c] -= f * w[c];
+      }
+    }
+    // Right update, A(0:n, k+1:n) = A(0:n, k+1:n) * H_k, one row at a time.
+    for (size_t i = 0; i < n; i++) {
+      double *row = &a[i * n + k + 1];
+      double s = t * dot(row, v.data(), m);
+      for (size_t r = 0; r < m; r++) {
+        row[r] -= s * v[r];
+      }
+    }
+  }
+}
+
+/// Reduce the nb columns from k of the contiguous n x n matrix a, as
+/// LAPACK's xLAHR2. The reflectors of the block, acting on rows k+1, ...,
+/// n-1, are returned in compact WY form, Q = I - V * T * V^T, along with
+/// Y = A * V * T for the A at the start of the block. Each column of the
+/// panel is brought up to date with the reflectors before it just before
+/// it is reduced; the columns after the panel are left for the caller.
+void reducePanel(double *a, const size_t &n, const size_t &k,
+                 const size_t &nb, Matrix &tau, BlockReflector &block,
+                 Matrix &Y) {
+  size_t m = n - k - 1;
+  block.Vt = Matrix(m, nb);
+  block.T = Matrix(nb, nb);
+  Y = Matrix(nb, n);
+  double *vt = block.Vt.data();
+  double *t = block.T.data();
+  double *y = Y.data();
+  std::vector<double> u(nb);
+  std::vector<double> x(m);
+  for (size_t i = 0; i < nb; i++) {
+    size_t j = k + i;
+    // Column j of A * Q: A(:, j) -= Y * V(j, :)^T. Row j of V is row i - 1
+    // of the reflectors.
+    for (size_t p = 0; i > 0 && p < n; p++) {
+      double s = 0.;
+      for (size_t l = 0; l < i; l++) {
+        s += y[p * nb + l] * vt[l * m + i - 1];
+      }
+      a[p * n + j] -= s;
+    }
+    // Then Q^T from the left, on rows k+1, ..., n-1:
+    // A(k+1:n, j) -= V * T^T * V^T * A(k+1:n, j). The column is strided in
+    // a, so work on a contiguous copy of it.
+    for (size_t r = 0; i > 0 && r < m; r++) {
+      x[r] = a[(k + 1 + r) * n + j];
+    }
+    for (size_t l = 0; l < i; l++) {
+      // v_l is zero above row l.
+      u[l] = dot(&vt[l * m + l], &x[l], m - l);
+    }
+    // T^T is lower triangular; walk up so u is still unmodified.
+    for (size_t p = i; p-- > 0;) {
+      double s = 0.;
+      for (size_t l = 0; l <= p; l++) {
+        s += t[l * nb + p] * u[l];
+      }
+      u[p] = s;
+    }
+    for (size_t l = 0; l < i; l++) {
+      const double *v_l = &vt[l * m];
+      for (size_t r = l; r < m; r++) {
+        x[r] -= v_l[r] * u[l];
+      }
+    }
+    for (size_t r = 0; i > 0 && r < m; r++) {
+      a[(k + 1 + r) * n + j] = x[r];
+    }
+    double tau_j = householderReflector(&a[(j + 1) * n + j],
+                                        &a[(j + 2) * n + j], n - j - 2, n);
+    tau(0, j) = tau_j;
+    double *v = &vt[i * m];
+    std::fill(v, v + i, 0.0);
+    v[i] = 1.0;
+    for (size_t r = i + 1; r < m; r++) {
+      v[r] = a[(k + 1 + r) * n + j];
+    }
+    // Extend T as in xLARFT: u = V^T * v, and
+    // T(0:i, i) = -tau_j * T(0:i, 0:i) * u.
+    for (size_t l = 0; l < i; l++) {
+      u[l] = dot(&vt[l * m + i], &v[i], m - i);
+    }
+    t[i * nb + i] = tau_j;
+    for (size_t l = 0; l < i; l++) {
+      double s = 0.;
+      for (size_t p = l; p < i; p++) {
+        s += t[l * nb + p] * u[p];
+      }
+      t[l * nb + i] = -tau_j * s;
+    }
+    // Y(:, i) = tau_j * (A * v - Y(:, 0:i) * u). The columns of A after j
+    // are still those from the start of the block.
+    for (size_t p = 0; p < n; p++) {
+      double s = dot(&a[p * n + k + 1 + i], &v[i], m - i);
+      for (size_t l = 0; l < i; l++) {
+        s -= y[p * nb + l] * u[l];
+      }
+      y[p * nb + i] = tau_j * s;
+    }
+  }
+  block.V = block.Vt.transpose();
+}
+
+/// Copy rows [y0, n) of columns [x0, n) of the contiguous n x n matrix a.
+Matrix copyTrailing(const double *a, const size_t &n, const size_t &x0,
+                    const size_t &y0) {
+  Matrix block(n - x0, n - y0);
+  for (size_t y = y0; y < n; y++) {
+    std::copy(&a[y * n + x0], &a[y * n + n],
+              block.data() + (y - y0) * (n - x0));
+  }
+  return block;
+}
+
+/// Write the output of copyTrailing back.
+void storeTrailing(double *a, const size_t &n, const size_t &x0,
+                   const size_t &y0, const Matrix &block) {
+  for (size_t y = y0; y < n; y++) {
+    const double *row = block.data() + (y - y0) * (n - x0);
+    std::copy(row, row + (n - x0), &a[y * n + x0]);
+  }
 }
 }; // namespace
 
-/// This function currently only uses the QR algorithm. It would be better
-/// to have multiple methods that switch based on matrix size.
-Matrix eigenvalues(const Matrix &A, const double &convergence_threshold,
-                   const size_t &max_iterations) {
+void hessenbergReduction(Matrix &A, Matrix &tau) {
   if (A.height() != A.width()) {
     throw std::runtime_error(
-        "Cannot compute eigenvalues for non-square matrix.");
+        "Cannot compute the Hessenberg form of a non-square matrix.");
+  }
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    hessenbergReduction(A_contiguous, tau);
+    A = A_contiguous;
+    return;
+  }
+  size_t n = A.height();
+  tau = Matrix(1, n > 2 ? n - 2 : 0);
+  double *a = A.data();
+  size_t k = 0;
+  for (; n - k > kHessenbergUnblockedSize; k += kHessenbergBlockSize) {
+    size_t nb = kHessenbergBlockSize;
+    BlockReflector block;
+    Matrix Y;
+    reducePanel(a, n, k, nb, tau, block, Y);
+    // The trailing columns, A(:, k+nb:n) = Q^T * A(:, k+nb:n) * Q, with
+    // two matrix multiplications. From the right:
+    // A(:, k+nb:n) -= Y * V(k+nb:n, :)^T.
+    size_t x0 = k + nb;
+    size_t m = n - k - 1;
+    Matrix Vt_trailing(n - x0, nb);
+    for (size_t l = 0; l < nb; l++) {
+      const double *v = block.Vt.data() + l * m + nb - 1;
+      std::copy(v, v + (n - x0), Vt_trailing.data() + l * (n - x0));
+    }
+    Matrix YVt = Y * Vt_trailing;
+    for (size_t y = 0; y < n; y++) {
+      const double *update = YVt.data() + y * (n - x0);
+      double *row = &a[y * n + x0];
+      for (size_t x = 0; x < n - x0; x++) {
+        row[x] -= update[x];
+      }
+    }
+    // From the left, on rows k+1, ..., n-1.
+    Matrix C = copyTrailing(a, n, x0, k + 1);
+    applyBlockReflector(block, C, true);
+    storeTrailing(a, n, x0, k + 1, C);
   }
-  // Make A upper diagonal while retaining eigenvalues.
-  Matrix RQ = A;
-  Matrix Q;
+  reduceUnblocked(a, n, k, tau);
+}
 
-  // Initialize.
-  Matrix eigenvalues(1, RQ.height());
+Matrix formHessenbergQ(const Matrix &H, const Matrix &tau) {
+  size_t n = H.height();
+  Matrix Q = identity(n);
+  double *q = Q.data();
+  std::vector<double> v(n);
+  std::vector<double> w(n);
+  // Q = H_0 * H_1 * ... ; applying the last reflector first means each one
+  // only touches the trailing block of Q.
+  for (size_t k = tau.height(); k-- > 0;) {
+    double t = tau(0, k);
+    if (t == 0.0) {
+      continue;
+    }
+    size_t m = n - k - 1;
+    v[0] = 1.0;
+    for (size_t r = 1; r < m; r++) {
+      v[r] = H(k, k + 1 + r);
+    }
+    for (size_t c = k + 1; c < n; c++) {
+      w[c] = 0.0;
+    }
+    for (size_t r = 0; r < m; r++) {
+      const double *row = &q[(k + 1 + r) * n];
+      for (size_t c = k + 1; c < n; c++) {
+        w[c] += v[r] * row[c];
+      }
+    }
+    for (size_t r = 0; r < m; r++) {
+      double *row = &q[(k + 1 + r) * n];
+      double f = t * v[r];
+      for (size_t c = k + 1; c < n; c++) {
+        row[c] -= f * w[c];
+      }
+    }
+  }
+  return Q;
+}
 
-  for (int n = RQ.height() - 1; n >= 0; n--) {
-    Matrix eye = identity(n + 1);
-    Matrix A_focus(MatrixROI(0, 0, n + 1, n + 1, &RQ));
-    hessenbergReduction(A_focus);
-    double num_iter = 0;
-    while (fabs(RQ(n - 1, n)) > convergence_threshold &&
-           num_iter < max_iterations) {
-      if (n > 0) {
-        // Calculate Wilkinson shift
-        double a_minus = A_focus(n - 1, n - 1);
-        double a = A_focus(n, n);
-        double b = A_focus(n, n - 1);
-        double delta = (a_minus - a) / 2.0;
-        double mu =
-            a -
-            pow(b, 2) / (delta + sign(delta) * sqrt(pow(delta, 2) + pow(b, 2)));
-        if (delta < 1e-5) {
-          mu = a - fabs(b);
+Matrix complexEigenvalues(const Matrix &A,
+                          const double &convergence_threshold,
+                          const size_t &max_iterations) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error(
+        "Cannot compute eigenvalues for non-square matrix.");
+  }
+  int n = A.height();
+  Matrix result(2, n);
+  if (n == 0) {
+    return result;
+  }
+  Matrix H = A;
+  Matrix tau;
+  hessenbergReduction(H, tau);
+  double *a = H.data();
+  auto h = [&](const int &y, const int &x) -> double & {
+    return a[y * n + x];
+  };
+  double norm = 0.;
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      if (x + 1 < y) {
+        h(y, x) = 0.0;
+      }
+      norm += fabs(h(y, x));
+    }
+  }
+  // Implicit double-shift QR (Francis' algorithm), after EISPACK's hqr.
+  // Each sweep chases a 3x3 bulge down the active window [l, nn] of H, so
+  // it costs O(n^2).
+  int nn = n - 1;
+  // Accumulated exceptional shifts.
+  double t = 0.;
+  while (nn >= 0) {
+    size_t num_iter = 0;
+    int l;
+    do {
+      // Look for a negligible subdiagonal element to split the problem at.
+      for (l = nn; l >= 1; l--) {
+        double s = fabs(h(l - 1, l - 1)) + fabs(h(l, l));
+        if (s == 0.0) {
+          s = norm;
         }
-        if (A_focus.height() < 3) {
-          mu = 0;
+        if (fabs(h(l, l - 1)) <= convergence_threshold * s) {
+          h(l, l - 1) = 0.0;
+          break;
         }
-        Matrix Q;
-        A_focus -= mu * eye;
-        qrFactorize(Q, A_focus);
-        A_focus = A_focus * Q + mu * eye;
+      }
+      double x = h(nn, nn);
+      if (l == nn) {
+        // One eigenvalue has converged.
+        result(0, nn) = x + t;
+        result(1, nn) = 0.0;
+        nn--;
+        num_iter = 0;
+        continue;
+      }
+      double y = h(nn - 1, nn - 1);
+      double w = h(nn, nn - 1) * h(nn - 1, nn);
+      if (l == nn - 1) {
+        // A 2x2 block has converged; solve for its eigenvalues directly.
+        double p = 0.5 * (y - x);
+        double q = p * p + w;
+        double z = sqrt(fabs(q));
+        x += t;
+        if (q >= 0.0) {
+          z = p + sign(p) * z;
+          result(0, nn - 1) = x + z;
+          result(0, nn) = (z != 0.0) ? x - w / z : x + z;
+          result(1, nn - 1) = 0.0;
+          result(1, nn) = 0.0;
+        } else {
+          // A complex conjugate pair.
+          result(0, nn - 1) = x + p;
+          result(0, nn) = x + p;
+          result(1, nn - 1) = z;
+          result(1, nn) = -z;
+        }
+        nn -= 2;
+        num_iter = 0;
+        continue;
+      }
+      if (num_iter >= max_iterations) {
+        return Matrix();
+      }
+      if (num_iter > 0 && num_iter % 10 == 0) {
+        // Exceptional shift, to break out of cycles.
+        t += x;
+        for (int i = 0; i <= nn; i++) {
+          h(i, i) -= x;
+        }
+        double s = fabs(h(nn, nn - 1)) + fabs(h(nn - 1, nn - 2));
+        x = 0.75 * s;
+        y = x;
+        w = -0.4375 * s * s;
       }
       num_iter++;
-    }
-    if (num_iter >= max_iterations) {
+      // The double shift uses the eigenvalues of the trailing 2x2 block.
+      // Find where to start the bulge: two consecutive small subdiagonal
+      // elements allow starting below l.
+      int m;
+      double p = 0., q = 0., r = 0., z = 0.;
+      for (m = nn - 2; m >= l; m--) {
+        z = h(m, m);
+        r = x - z;
+        double s = y - z;
+        p = (r * s - w) / h(m + 1, m) + h(m, m + 1);
+        q = h(m + 1, m + 1) - z - r - s;
+        r = h(m + 2, m + 1);
+        s = fabs(p) + fabs(q) + fabs(r);
+        p /= s;
+        q /= s;
+        r /= s;
+        if (m == l) {
+          break;
+        }
+        double u = fabs(h(m, m - 1)) * (fabs(q) + fabs(r));
+        double v = fabs(p) * (fabs(h(m - 1, m - 1)) + fabs(z) +
+                              fabs(h(m + 1, m + 1)));
+        if (u <= std::numeric_limits<double>::epsilon() * v) {
+          break;
+        }
+      }
+      for (int i = m + 2; i <= nn; i++) {
+        h(i, i - 2) = 0.0;
+        if (i != m + 2) {
+          h(i, i - 3) = 0.0;
+        }
+      }
+      // Chase the bulge with 3x3 Householder reflectors.
+      for (int k = m; k <= nn - 1; k++) {
+        if (k != m) {
+          p = h(k, k - 1);
+          q = h(k + 1, k - 1);
+          r = (k != nn - 1) ? h(k + 2, k - 1) : 0.0;
+          x = fabs(p) + fabs(q) + fabs(r);
+          if (x != 0.0) {
+            p /= x;
+            q /= x;
+            r /= x;
+          }
+        }
+        double s = sign(p) * sqrt(p * p + q * q + r * r);
+        if (s == 0.0) {
+          continue;
+        }
+        if (k == m) {
+          if (l != m) {
+            h(k, k - 1) = -h(k, k - 1);
+          }
+        } else {
+          h(k, k - 1) = -s * x;
+        }
+        p += s;
+        x = p / s;
+        y = q / s;
+        z = r / s;
+        q /= p;
+        r /= p;
+        // Row modification.
+        for (int j = k; j <= nn; j++) {
+          p = h(k, j) + q * h(k + 1, j);
+          if (k != nn - 1) {
+            p += r * h(k + 2, j);
+            h(k + 2, j) -= p * z;
+          }
+          h(k + 1, j) -= p * y;
+          h(k, j) -= p * x;
+        }
+        // Column modification.
+        int i_max = std::min(nn, k + 3);
+        for (int i = l; i <= i_max; i++) {
+          p = x * h(i, k) + y * h(i, k + 1);
+          if (k != nn - 1) {
+            p += z * h(i, k + 2);
+            h(i, k + 2) -= p * r;
+          }
+          h(i, k + 1) -= p * q;
+          h(i, k) -= p;
+        }
+      }
+    } while (nn >= 0 && l < nn - 1);
+  }
+  return result;
+}
+
+Matrix eigenvalues(const Matrix &A, const double &convergence_threshold,
+                   const size_t &max_iterations) {
+  Matrix values = complexEigenvalues(A, convergence_threshold, max_iterations);
+  if (!values.ok()) {
+    return Matrix();
+  }
+  Matrix result(1, values.height());
+  for (size_t i = 0; i < values.height(); i++) {
+    if (values(1, i) != 0.0) {
+      // Complex eigenvalues are only reported by complexEigenvalues.
       return Matrix();
     }
-    eigenvalues(0, n) = RQ(n, n);
+    result(0, i) = values(0, i);
   }
-  return eigenvalues;
+  return result;
 }
 }; // namespace basic_matrix
@@ -1,12 +1,57 @@
 #pragma once
 #include "matrix.hpp"
+#include <limits>
 
 namespace basic_matrix {
+/// Reduce A to upper Hessenberg form, H = Q^T * A * Q, in place.
+///
+/// Q = H_0 * H_1 * ... * H_(n-3) is a product of Householder reflectors,
+/// for a total of (10/3)*n^3 flops. Large matrices are reduced in panels of
+/// columns whose reflectors are applied to the rest of A together, in
+/// compact WY form, as matrix multiplications; the last columns take one
+/// rank-1 update from each side per reflector. On output, H is stored on
+/// and above the first subdiagonal of A, and the vector of reflector H_k
+/// below the subdiagonal of column k. The leading element of each vector
+/// is an implicit 1.
+///
+/// in/out: A, which must be square.
+/// out: tau, an (n-2) x 1 column of reflector scales.
+void hessenbergReduction(Matrix &A, Matrix &tau);
+
+/// Explicitly form Q from the output of hessenbergReduction.
+Matrix formHessenbergQ(const Matrix &H, const Matrix &tau);
+
+/// Calculate the eigenvalues of A, which may be complex, with the implicit
+/// double-shift QR algorithm (Francis' algorithm).
+///
+/// A is reduced to Hessenberg form once. Every QR step then chases a bulge
+/// down the Hessenberg matrix with 3x3 Householder reflectors, which costs
+/// O(n^2) instead of the O(n^3) of an explicit QR step, and real arithmetic
+/// is enough to produce complex conjugate pairs.
+///
+/// A subdiagonal element is treated as zero, splitting the problem in two,
+/// once it is smaller than convergence_threshold times the sum of the
+/// neighboring diagonal elements. At most max_iterations QR steps are spent
+/// on each eigenvalue.
+///
+/// Returns an n x 2 matrix, one row per eigenvalue, whose column 0 holds
+/// the real parts and column 1 the imaginary parts. Complex conjugate
+/// pairs are stored in adjacent rows. A matrix that is not ok() is
+/// returned if the algorithm does not converge.
+Matrix complexEigenvalues(const Matrix &A,
+                          const double &convergence_threshold =
+                              std::numeric_limits<double>::epsilon(),
+                          const size_t &max_iterations = 1000);
+
 /// Calculate Eigenvalues through the QR algorithm.
 /// returns an N x 1 matrix that contains eigenvalues.
 /// Note: the input to this function must be a square matrix.
 /// This function will not calculate complex eigenvalues. A
-/// matrix that is not ok() will be returned in that case.
-Matrix eigenvalues(const Matrix &A, const double &convergence_threshold = 1e-3,
+/// matrix that is not ok() will be returned in that case; use
+/// complexEigenvalues to get them. See complexEigenvalues for the meaning
+/// of the parameters.
+Matrix eigenvalues(const Matrix &A,
+                   const double &convergence_threshold =
+                       std::numeric_limits<double>::epsilon(),
                    const size_t &max_iterations = 1000);
 }; // namespace basic_matrix
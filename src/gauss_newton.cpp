@@ -1,45 +1,77 @@
 #include "gauss_newton.hpp"
 #include "gaussian_elimination.hpp"
+#include "kernel_helpers.hpp"
 #include <iostream>
 
 namespace basic_matrix {
+namespace {
+/// Throw if mat is not width x height. The loops below index without bounds
+/// checks, so this stands in for the checks of the Matrix operators.
+void checkSize(const Matrix &mat, const size_t &width, const size_t &height,
+               const std::string &name) {
+  if (mat.width() != width || mat.height() != height) {
+    throw std::runtime_error(name + " is " + std::to_string(mat.width()) +
+                             "x" + std::to_string(mat.height()) +
+                             " but should be " + std::to_string(width) + "x" +
+                             std::to_string(height) + ".");
+  }
+}
+}; // namespace
 
 void gaussNewton(OptimizationProblem &problem) {
-  Matrix J;
+  GaussNewtonWorkspace workspace;
+  gaussNewton(problem, workspace);
+}
+
+void gaussNewton(OptimizationProblem &problem,
+                 GaussNewtonWorkspace &workspace) {
+  size_t num_params = problem.inputs.num_params;
+  Matrix &theta = problem.outputs.theta;
   if (!problem.config.use_initial_condition ||
-      problem.outputs.theta.height() != problem.inputs.num_params) {
-    problem.outputs.theta = Matrix(1, problem.inputs.num_params);
-    for (size_t i = 0; i < problem.inputs.num_params; i++) {
-      problem.outputs.theta(0, i) = 1.0;
+      theta.height() != num_params) {
+    theta = Matrix(1, num_params);
+    for (size_t i = 0; i < num_params; i++) {
+      theta(0, i) = 1.0;
     }
   }
+  const Matrix &y_target = problem.inputs.y;
+  Matrix &J = workspace.J;
+  Matrix &r = workspace.r;
+  Matrix &delta = workspace.delta;
+  sampleColumns(problem.inputs.X, workspace.samples);
   for (size_t step = 0; step < problem.config.max_iterations; step++) {
     if (problem.inputs.jacobian.has_value()) {
-      problem.inputs.jacobian.value()(problem.outputs.theta, problem.inputs.X,
-                                      problem.inputs.y, J);
+      problem.inputs.jacobian.value()(theta, problem.inputs.X, y_target, J);
     } else {
-      estimateJacobian(problem, J);
+      estimateJacobian(problem, workspace.samples, J,
+                       workspace.theta_perturbed, workspace.y_i);
     }
     problem.outputs.num_iterations++;
-    Matrix y;
     if (problem.inputs.function.has_value()) {
-      y = evaluate(problem.inputs.function.value(), problem.outputs.theta,
-                   problem.inputs.X);
+      evaluate(problem.inputs.function.value(), theta, workspace.samples,
+               workspace.y, workspace.y_i);
     } else if (problem.inputs.vector_function.has_value()) {
-      problem.inputs.vector_function.value()(problem.outputs.theta,
-                                             problem.inputs.X, y);
+      problem.inputs.vector_function.value()(theta, problem.inputs.X,
+                                             workspace.y);
     } else {
       throw std::runtime_error(
           "Optimization problem needs either a scalar or vector evaluator.");
     }
-    Matrix r = problem.inputs.y - y;
+    checkSize(workspace.y, y_target.width(), y_target.height(),
+              "The model output y");
     double cost = 0;
     if (problem.inputs.cost_function.has_value()) {
-      cost = problem.inputs.cost_function.value()(
-          problem.outputs.theta, problem.inputs.X, problem.inputs.y);
-      r = Matrix({cost});
+      cost = problem.inputs.cost_function.value()(theta, problem.inputs.X,
+                                                  y_target);
+      resizeIfNeeded(r, 1, 1);
+      r(0, 0) = cost;
     } else {
-      r = problem.inputs.y - y;
+      resizeIfNeeded(r, y_target.width(), y_target.height());
+      for (size_t y = 0; y < r.height(); y++) {
+        for (size_t x = 0; x < r.width(); x++) {
+          r(x, y) = y_target(x, y) - workspace.y(x, y);
+        }
+      }
       cost = r.norm();
     }
     if (cost < problem.config.cost_threshold) {
@@ -49,9 +81,33 @@ void gaussNewton(OptimizationProblem &problem) {
     // Gauss-Newton update:
     // (https://en.wikipedia.org/wiki/Gauss%E2%80%93Newton_algorithm)
     // theta_(k+1) = theta_k + (J_f_t*J_f)^(-1)*J_f_t*r
-    Matrix delta = J.transposeROI() * r;
-    solveByGaussianElimination(J.transposeROI() * J, delta);
-    problem.outputs.theta = problem.outputs.theta + delta;
+    // J^T*J is symmetric and, when J has full column rank, positive
+    // definite, so it is formed with the SYRK kernel, packed and solved
+    // with Cholesky.
+    // Gaussian elimination is the fallback for a rank-deficient J.
+    checkSize(J, num_params, r.height(), "The Jacobian");
+    checkSize(r, theta.width(), J.height(), "The residual");
+    resizeIfNeeded(delta, r.width(), J.width());
+    for (size_t x = 0; x < J.width(); x++) {
+      for (size_t c = 0; c < r.width(); c++) {
+        double sum = 0.0;
+        for (size_t y = 0; y < J.height(); y++) {
+          sum += J(x, y) * r(c, y);
+        }
+        delta(c, x) = sum;
+      }
+    }
+    gramMatrix(J, workspace.JtJ);
+    if (choleskyFactorize(workspace.JtJ, workspace.L)) {
+      solveCholesky(workspace.L, delta);
+    } else {
+      solveByGaussianElimination(workspace.JtJ.toDense(), delta);
+    }
+    for (size_t y = 0; y < theta.height(); y++) {
+      for (size_t x = 0; x < theta.width(); x++) {
+        theta(x, y) += delta(x, y);
+      }
+    }
   }
 }
 }; // namespace basic_matrix
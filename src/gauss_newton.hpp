@@ -1,8 +1,38 @@
 #pragma once
 #include "optimization_problem.hpp"
+#include "packed_matrix.hpp"
+#include <vector>
 
 namespace basic_matrix {
+/// The storage for every step of gaussNewton. It is sized on the first
+/// iteration and reused by the later ones, so an iteration allocates
+/// nothing beyond what the model functions themselves allocate. Reusing
+/// one workspace across fits of the same size does the same for whole
+/// fits.
+struct GaussNewtonWorkspace {
+  /// The rows of X, as the column vectors the model functions take.
+  std::vector<Matrix> samples;
+  /// The Jacobian, num_samples x num_params.
+  Matrix J;
+  /// The model outputs and the residuals, inputs.y - y.
+  Matrix y;
+  Matrix r;
+  /// J^T * r, and then the step that solves the normal equations.
+  Matrix delta;
+  /// The normal equations, J^T * J, and their Cholesky factor.
+  SymmetricMatrix JtJ;
+  LowerTriangular L;
+  /// Scratch space for the model functions.
+  Matrix theta_perturbed;
+  Matrix y_i;
+};
+
 /// Use the Gauss-Newton method to solve an optimization
 /// problem.
 void gaussNewton(OptimizationProblem &problem);
+
+/// gaussNewton with caller-owned storage, for running many fits without
+/// allocating.
+void gaussNewton(OptimizationProblem &problem,
+                 GaussNewtonWorkspace &workspace);
 };
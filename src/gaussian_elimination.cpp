@@ -1,65 +1,96 @@
 #include "gaussian_elimination.hpp"
+#include "parallel.hpp"
+#include <algorithm>
 #include <iostream>
+#include <math.h>
 
 namespace basic_matrix {
 
 namespace {
-void addRow(Matrix &mat, const size_t &y_from, const size_t &y_to) {
-  for (size_t x = 0; x < mat.width(); x++) {
-    mat(x, y_to) += mat(x, y_from);
-  }
-}
-
-void multiplyRow(Matrix &mat, const size_t &y, const double &factor) {
-  for (size_t x = 0; x < mat.width(); x++) {
-    mat(x, y) *= factor;
-  }
-}
-
-void eliminateAlongColumn(Matrix &mat, const size_t &x_target,
-                          const size_t &y_target) {
-  {
-    // Make mat(x_target, y_target) 1.0
-    double factor = 1.0 / mat(x_target, y_target);
-    multiplyRow(mat, y_target, factor);
-  }
-  for (size_t y = 0; y < mat.height(); y++) {
-    if (y == y_target || fabs(mat(x_target, y)) < 1e-9) {
+/// Gauss-Jordan elimination on the rows of a contiguous, row-major matrix.
+void eliminate(double *a, const size_t &width, const size_t &height) {
+  for (size_t focus_x = 0; focus_x < width && focus_x < height; focus_x++) {
+    size_t focus_y = focus_x;
+    // Partial pivoting: the largest remaining entry of the column.
+    size_t pivot_y = focus_y;
+    for (size_t y = focus_y + 1; y < height; y++) {
+      if (fabs(a[y * width + focus_x]) > fabs(a[pivot_y * width + focus_x])) {
+        pivot_y = y;
+      }
+    }
+    if (fabs(a[pivot_y * width + focus_x]) <= 1e-9) {
       continue;
     }
-    // Make x_target, y -1.0
-    double factor = -1.0 / mat(x_target, y);
-    multiplyRow(mat, y, factor);
-    // Add the target (now 1.0) row to this one (not -1.0),
-    // zeroing this element out.
-    addRow(mat, y_target, y);
-    multiplyRow(mat, y, 1. / factor);
+    if (pivot_y != focus_y) {
+      std::swap_ranges(&a[focus_y * width], &a[focus_y * width] + width,
+                       &a[pivot_y * width]);
+    }
+    // Entries left of focus_x are already zero in every row but the earlier
+    // pivot rows, so the row operations start at focus_x.
+    double *pivot_row = &a[focus_y * width];
+    double factor = 1.0 / pivot_row[focus_x];
+    for (size_t x = focus_x; x < width; x++) {
+      pivot_row[x] *= factor;
+    }
+    pivot_row[focus_x] = 1.0;
+    // Zero out the column in every other row with one AXPY each. The rows
+    // are independent.
+    size_t length = width - focus_x;
+    parallelFor(
+        0, height,
+        [&](const size_t &y) {
+          double *row = &a[y * width];
+          double f = row[focus_x];
+          if (y == focus_y || f == 0.0) {
+            return;
+          }
+          for (size_t x = focus_x + 1; x < width; x++) {
+            row[x] -= f * pivot_row[x];
+          }
+          row[focus_x] = 0.0;
+        },
+        std::max<size_t>(1, 16384 / length));
   }
 }
 } // namespace
 
 void gaussianElimination(Matrix &mat) {
-  for (size_t focus_x = 0; focus_x < mat.width(); focus_x++) {
-    size_t focus_y = focus_x;
-    for (size_t y = focus_y; y < mat.height(); y++) {
-      if (fabs(mat(focus_x, y)) > 1e-9) {
-        if (y != focus_y) {
-          mat.swapRows(focus_y, y);
-        }
-        eliminateAlongColumn(mat, focus_x, focus_y);
-        break;
-      }
-    }
+  if (!mat.contiguous()) {
+    Matrix mat_contiguous = mat;
+    gaussianElimination(mat_contiguous);
+    mat = mat_contiguous;
+    return;
   }
+  eliminate(mat.data(), mat.width(), mat.height());
 }
 
 void solveByGaussianElimination(const basic_matrix::Matrix &A,
                                 basic_matrix::Matrix &b) {
-  Matrix A_copy = A;
-  Matrix Ab_wrapped;
-  Ab_wrapped.addROI(MatrixROI(0, 0, A.width(), A.height(), &A_copy));
-  Ab_wrapped.addROI(MatrixROI(0, 0, 1, A.height(), &b, A.width(), 0));
-  // A and b will be mutated in place, A is temporary, b was passed in.
-  gaussianElimination(Ab_wrapped);
+  if (A.width() != A.height() || b.height() != A.height()) {
+    throw std::runtime_error(
+        "Cannot solve a system with a " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) + " A and a " + std::to_string(b.width()) +
+        "x" + std::to_string(b.height()) + " b.");
+  }
+  size_t n = A.width();
+  size_t w = b.width();
+  // The augmented matrix [A b], contiguous, so every row operation is a
+  // single span.
+  Matrix Ab(n + w, n);
+  double *ab = Ab.data();
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      ab[y * (n + w) + x] = A(x, y);
+    }
+    for (size_t x = 0; x < w; x++) {
+      ab[y * (n + w) + n + x] = b(x, y);
+    }
+  }
+  eliminate(ab, n + w, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < w; x++) {
+      b(x, y) = ab[y * (n + w) + n + x];
+    }
+  }
 }
 }; // namespace basic_matrix
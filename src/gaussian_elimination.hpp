@@ -2,12 +2,15 @@
 #include "matrix.hpp"
 
 namespace basic_matrix {
-/// Perform Gaussian elimination in place on A.
+/// Perform Gauss-Jordan elimination in place on A, with partial pivoting.
+/// Each row operation is a single fused AXPY over a contiguous row, and the
+/// rows are updated in parallel for large matrices.
 void gaussianElimination(basic_matrix::Matrix &mat);
 
 /// Solve the system of equations A * x = b, where A is square and A.height() ==
 /// b.height(),
-/// by Gaussian elimination.
+/// by Gaussian elimination. b may have several columns, which are solved
+/// together.
 /// @in A - the A matrix.
 /// @in/out b = the b matrix. Replaced by x during computation.
 void solveByGaussianElimination(const basic_matrix::Matrix &A,
@@ -1,4 +1,5 @@
 #include "io.hpp"
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
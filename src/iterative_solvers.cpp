@@ -0,0 +1,502 @@
+#include "iterative_solvers.hpp"
+#include <math.h>
+#include <memory>
+
+namespace basic_matrix {
+namespace {
+double dot(const std::vector<double> &x, const std::vector<double> &y) {
+  double s = 0.0;
+  for (size_t i = 0; i < x.size(); i++) {
+    s += x[i] * y[i];
+  }
+  return s;
+}
+
+double norm(const std::vector<double> &x) { return sqrt(dot(x, x)); }
+
+/// y += alpha * x
+void axpy(const double &alpha, const std::vector<double> &x,
+          std::vector<double> &y) {
+  for (size_t i = 0; i < x.size(); i++) {
+    y[i] += alpha * x[i];
+  }
+}
+
+/// y = op(x), checking that op returns an n x 1 vector.
+void apply(const LinearOperator &op, const std::vector<double> &x,
+           std::vector<double> &y) {
+  size_t n = x.size();
+  Matrix x_matrix(1, n);
+  std::copy(x.begin(), x.end(), x_matrix.data());
+  Matrix y_matrix = op(x_matrix);
+  if (y_matrix.width() != 1 || y_matrix.height() != n) {
+    throw std::runtime_error(
+        "The linear operator must return an n x 1 column vector.");
+  }
+  y.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    y[i] = y_matrix(0, i);
+  }
+}
+
+/// y = M^-1 * x, or a copy of x without a preconditioner.
+void precondition(const IterativeSolverOptions &options,
+                  const std::vector<double> &x, std::vector<double> &y) {
+  if (options.preconditioner) {
+    apply(options.preconditioner, x, y);
+  } else {
+    y = x;
+  }
+}
+
+/// The state shared by the solvers: b, the current x and its residual.
+struct Problem {
+  Problem(const LinearOperator &A_in, const Matrix &b_in, const Matrix &x_in,
+          const IterativeSolverOptions &options)
+      : A(A_in) {
+    if (b_in.width() != 1) {
+      throw std::runtime_error("b must be an n x 1 column vector.");
+    }
+    n = b_in.height();
+    b.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      b[i] = b_in(0, i);
+    }
+    x.assign(n, 0.0);
+    if (x_in.ok() && x_in.width() == 1 && x_in.height() == n) {
+      for (size_t i = 0; i < n; i++) {
+        x[i] = x_in(0, i);
+      }
+    }
+    b_norm = norm(b);
+    max_iterations =
+        options.max_iterations > 0 ? options.max_iterations : 10 * n;
+    tolerance = options.tolerance * b_norm;
+  }
+
+  /// r = b - A * x
+  void residual(std::vector<double> &r) {
+    apply(A, x, r);
+    for (size_t i = 0; i < n; i++) {
+      r[i] = b[i] - r[i];
+    }
+  }
+
+  /// Write x out, and fill in the result from the residual norm.
+  IterativeSolverResult finish(Matrix &x_out, const double &r_norm) {
+    x_out = Matrix(1, n);
+    std::copy(x.begin(), x.end(), x_out.data());
+    result.relative_residual = b_norm > 0.0 ? r_norm / b_norm : r_norm;
+    result.converged = r_norm <= tolerance;
+    return result;
+  }
+
+  const LinearOperator &A;
+  size_t n;
+  std::vector<double> b;
+  std::vector<double> x;
+  double b_norm;
+  double tolerance;
+  size_t max_iterations;
+  IterativeSolverResult result;
+};
+
+LinearOperator matrixOperator(const Matrix &A) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error("Cannot solve a system with a non-square " +
+                             std::to_string(A.width()) + "x" +
+                             std::to_string(A.height()) + " matrix.");
+  }
+  return [&A](const Matrix &x) { return A * x; };
+}
+
+/// Sparse rows of a square matrix: the nonzeros of row y are
+/// values[row_start[y]..row_start[y + 1]), in columns cols[...], sorted.
+struct SparseRows {
+  std::vector<size_t> row_start;
+  std::vector<size_t> cols;
+  std::vector<double> values;
+  /// Index of the diagonal entry of each row.
+  std::vector<size_t> diagonal;
+};
+
+/// The nonzeros of A, or of its lower triangle only, plus the diagonal.
+SparseRows sparseRows(const Matrix &A, const bool &lower_only) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error(
+        "Preconditioners are only defined for square matrices.");
+  }
+  size_t n = A.height();
+  SparseRows rows;
+  rows.row_start.push_back(0);
+  rows.diagonal.resize(n);
+  for (size_t y = 0; y < n; y++) {
+    size_t end = lower_only ? y + 1 : n;
+    for (size_t x = 0; x < end; x++) {
+      if (A(x, y) != 0.0 || x == y) {
+        if (x == y) {
+          rows.diagonal[y] = rows.cols.size();
+        }
+        rows.cols.push_back(x);
+        rows.values.push_back(A(x, y));
+      }
+    }
+    rows.row_start.push_back(rows.cols.size());
+  }
+  return rows;
+}
+
+/// Solve L * y = x in place for the lower triangle of rows (with a unit
+/// diagonal if unit is set).
+void solveLower(const SparseRows &rows, const bool &unit,
+                std::vector<double> &x) {
+  size_t n = x.size();
+  for (size_t y = 0; y < n; y++) {
+    double sum = x[y];
+    for (size_t i = rows.row_start[y]; i < rows.diagonal[y]; i++) {
+      sum -= rows.values[i] * x[rows.cols[i]];
+    }
+    x[y] = unit ? sum : sum / rows.values[rows.diagonal[y]];
+  }
+}
+
+/// Solve U * y = x in place for the upper triangle of rows.
+void solveUpper(const SparseRows &rows, std::vector<double> &x) {
+  size_t n = x.size();
+  for (size_t y = n; y-- > 0;) {
+    double sum = x[y];
+    for (size_t i = rows.diagonal[y] + 1; i < rows.row_start[y + 1]; i++) {
+      sum -= rows.values[i] * x[rows.cols[i]];
+    }
+    x[y] = sum / rows.values[rows.diagonal[y]];
+  }
+}
+
+/// Solve L^T * y = x in place, for L the lower triangle of rows, by
+/// scattering each solved entry into the entries above it.
+void solveLowerTransposed(const SparseRows &rows, std::vector<double> &x) {
+  size_t n = x.size();
+  for (size_t y = n; y-- > 0;) {
+    x[y] /= rows.values[rows.diagonal[y]];
+    for (size_t i = rows.row_start[y]; i < rows.diagonal[y]; i++) {
+      x[rows.cols[i]] -= rows.values[i] * x[y];
+    }
+  }
+}
+
+LinearOperator vectorOperator(
+    const std::function<void(std::vector<double> &)> &solve) {
+  return [solve](const Matrix &x_in) {
+    std::vector<double> x(x_in.height());
+    for (size_t i = 0; i < x.size(); i++) {
+      x[i] = x_in(0, i);
+    }
+    solve(x);
+    Matrix result(1, x.size());
+    std::copy(x.begin(), x.end(), result.data());
+    return result;
+  };
+}
+
+/// Apply the Givens rotation (c, s) to (a, b).
+void rotate(const double &c, const double &s, double &a, double &b) {
+  double t = c * a + s * b;
+  b = -s * a + c * b;
+  a = t;
+}
+}; // namespace
+
+IterativeSolverResult conjugateGradient(const LinearOperator &A,
+                                        const Matrix &b, Matrix &x,
+                                        const IterativeSolverOptions &options) {
+  Problem problem(A, b, x, options);
+  size_t n = problem.n;
+  std::vector<double> r(n);
+  std::vector<double> z(n);
+  std::vector<double> Ap(n);
+  problem.residual(r);
+  double r_norm = norm(r);
+  precondition(options, r, z);
+  std::vector<double> p = z;
+  double rz = dot(r, z);
+  IterativeSolverResult &result = problem.result;
+  while (r_norm > problem.tolerance &&
+         result.iterations < problem.max_iterations) {
+    apply(A, p, Ap);
+    result.iterations++;
+    double pAp = dot(p, Ap);
+    if (pAp <= 0.0) {
+      // A (or the preconditioner) is not positive definite.
+      break;
+    }
+    double alpha = rz / pAp;
+    axpy(alpha, p, problem.x);
+    axpy(-alpha, Ap, r);
+    r_norm = norm(r);
+    precondition(options, r, z);
+    double rz_next = dot(r, z);
+    double beta = rz_next / rz;
+    rz = rz_next;
+    for (size_t i = 0; i < n; i++) {
+      p[i] = z[i] + beta * p[i];
+    }
+  }
+  // The recurrence for r drifts from b - A * x; report the true residual.
+  problem.residual(r);
+  return problem.finish(x, norm(r));
+}
+
+IterativeSolverResult conjugateGradient(const Matrix &A, const Matrix &b,
+                                        Matrix &x,
+                                        const IterativeSolverOptions &options) {
+  return conjugateGradient(matrixOperator(A), b, x, options);
+}
+
+IterativeSolverResult gmres(const LinearOperator &A, const Matrix &b,
+                            Matrix &x, const IterativeSolverOptions &options) {
+  Problem problem(A, b, x, options);
+  size_t n = problem.n;
+  size_t m = std::max<size_t>(1, std::min(options.restart, n));
+  IterativeSolverResult &result = problem.result;
+  // The basis V, the Hessenberg matrix H (column j in H[j]), already
+  // rotated to upper triangular, the rotations, and the rotated residual g.
+  std::vector<std::vector<double>> V(m + 1, std::vector<double>(n));
+  std::vector<std::vector<double>> H(m, std::vector<double>(m + 1));
+  std::vector<double> c(m);
+  std::vector<double> s(m);
+  std::vector<double> g(m + 1);
+  std::vector<double> z(n);
+  std::vector<double> w(n);
+  std::vector<double> r(n);
+  problem.residual(r);
+  double r_norm = norm(r);
+  while (r_norm > problem.tolerance &&
+         result.iterations < problem.max_iterations) {
+    for (size_t i = 0; i < n; i++) {
+      V[0][i] = r[i] / r_norm;
+    }
+    std::fill(g.begin(), g.end(), 0.0);
+    g[0] = r_norm;
+    size_t j = 0;
+    while (j < m && result.iterations < problem.max_iterations) {
+      precondition(options, V[j], z);
+      apply(A, z, w);
+      result.iterations++;
+      // Modified Gram-Schmidt.
+      for (size_t i = 0; i <= j; i++) {
+        H[j][i] = dot(w, V[i]);
+        axpy(-H[j][i], V[i], w);
+      }
+      H[j][j + 1] = norm(w);
+      for (size_t i = 0; i < j; i++) {
+        rotate(c[i], s[i], H[j][i], H[j][i + 1]);
+      }
+      double h = hypot(H[j][j], H[j][j + 1]);
+      bool breakdown = H[j][j + 1] == 0.0;
+      if (!breakdown) {
+        for (size_t i = 0; i < n; i++) {
+          V[j + 1][i] = w[i] / H[j][j + 1];
+        }
+      }
+      c[j] = h > 0.0 ? H[j][j] / h : 1.0;
+      s[j] = h > 0.0 ? H[j][j + 1] / h : 0.0;
+      rotate(c[j], s[j], H[j][j], H[j][j + 1]);
+      rotate(c[j], s[j], g[j], g[j + 1]);
+      j++;
+      // |g[j]| is the norm of the residual of the current least squares
+      // solution.
+      if (fabs(g[j]) <= problem.tolerance || breakdown) {
+        break;
+      }
+    }
+    // Solve the triangular system H * y = g and update x += M^-1 * V * y.
+    std::vector<double> y(j);
+    for (size_t i = j; i-- > 0;) {
+      double sum = g[i];
+      for (size_t k = i + 1; k < j; k++) {
+        sum -= H[k][i] * y[k];
+      }
+      y[i] = H[i][i] != 0.0 ? sum / H[i][i] : 0.0;
+    }
+    std::fill(w.begin(), w.end(), 0.0);
+    for (size_t i = 0; i < j; i++) {
+      axpy(y[i], V[i], w);
+    }
+    precondition(options, w, z);
+    axpy(1.0, z, problem.x);
+    double last_norm = r_norm;
+    problem.residual(r);
+    r_norm = norm(r);
+    if (r_norm >= last_norm) {
+      // Stagnation: another restart would build the same subspace.
+      break;
+    }
+  }
+  return problem.finish(x, r_norm);
+}
+
+IterativeSolverResult gmres(const Matrix &A, const Matrix &b, Matrix &x,
+                            const IterativeSolverOptions &options) {
+  return gmres(matrixOperator(A), b, x, options);
+}
+
+IterativeSolverResult bicgstab(const LinearOperator &A, const Matrix &b,
+                               Matrix &x,
+                               const IterativeSolverOptions &options) {
+  Problem problem(A, b, x, options);
+  size_t n = problem.n;
+  IterativeSolverResult &result = problem.result;
+  std::vector<double> r(n);
+  problem.residual(r);
+  double r_norm = norm(r);
+  std::vector<double> r_hat = r;
+  std::vector<double> p(n, 0.0);
+  std::vector<double> v(n, 0.0);
+  std::vector<double> p_hat(n);
+  std::vector<double> s_hat(n);
+  std::vector<double> t(n);
+  double rho = 1.0;
+  double alpha = 1.0;
+  double omega = 1.0;
+  while (r_norm > problem.tolerance &&
+         result.iterations < problem.max_iterations) {
+    double rho_next = dot(r_hat, r);
+    if (rho_next == 0.0 || omega == 0.0) {
+      // Breakdown.
+      break;
+    }
+    double beta = (rho_next / rho) * (alpha / omega);
+    rho = rho_next;
+    for (size_t i = 0; i < n; i++) {
+      p[i] = r[i] + beta * (p[i] - omega * v[i]);
+    }
+    precondition(options, p, p_hat);
+    apply(A, p_hat, v);
+    result.iterations++;
+    double r_hat_v = dot(r_hat, v);
+    if (r_hat_v == 0.0) {
+      break;
+    }
+    alpha = rho / r_hat_v;
+    // r becomes s = r - alpha * v.
+    axpy(alpha, p_hat, problem.x);
+    axpy(-alpha, v, r);
+    r_norm = norm(r);
+    if (r_norm <= problem.tolerance ||
+        result.iterations >= problem.max_iterations) {
+      break;
+    }
+    precondition(options, r, s_hat);
+    apply(A, s_hat, t);
+    result.iterations++;
+    double tt = dot(t, t);
+    omega = tt > 0.0 ? dot(t, r) / tt : 0.0;
+    axpy(omega, s_hat, problem.x);
+    axpy(-omega, t, r);
+    r_norm = norm(r);
+  }
+  problem.residual(r);
+  return problem.finish(x, norm(r));
+}
+
+IterativeSolverResult bicgstab(const Matrix &A, const Matrix &b, Matrix &x,
+                               const IterativeSolverOptions &options) {
+  return bicgstab(matrixOperator(A), b, x, options);
+}
+
+LinearOperator jacobiPreconditioner(const Matrix &A) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error(
+        "Preconditioners are only defined for square matrices.");
+  }
+  auto inverse_diagonal = std::make_shared<std::vector<double>>(A.height());
+  for (size_t i = 0; i < A.height(); i++) {
+    if (A(i, i) == 0.0) {
+      throw std::runtime_error("The Jacobi preconditioner needs a nonzero "
+                               "diagonal; A(" +
+                               std::to_string(i) + ", " + std::to_string(i) +
+                               ") is zero.");
+    }
+    (*inverse_diagonal)[i] = 1.0 / A(i, i);
+  }
+  return vectorOperator([inverse_diagonal](std::vector<double> &x) {
+    for (size_t i = 0; i < x.size(); i++) {
+      x[i] *= (*inverse_diagonal)[i];
+    }
+  });
+}
+
+LinearOperator incompleteCholeskyPreconditioner(const Matrix &A) {
+  auto L = std::make_shared<SparseRows>(sparseRows(A, true));
+  size_t n = A.height();
+  // Row by row: L(y, x) = (A(y, x) - sum_k L(y, k) * L(x, k)) / L(x, x),
+  // summing over the columns k < x that rows x and y share.
+  for (size_t y = 0; y < n; y++) {
+    for (size_t i = L->row_start[y]; i <= L->diagonal[y]; i++) {
+      size_t x = L->cols[i];
+      double sum = L->values[i];
+      size_t j = L->row_start[y];
+      size_t k = L->row_start[x];
+      while (j < i && k < L->diagonal[x]) {
+        if (L->cols[j] < L->cols[k]) {
+          j++;
+        } else if (L->cols[j] > L->cols[k]) {
+          k++;
+        } else {
+          sum -= L->values[j++] * L->values[k++];
+        }
+      }
+      if (x < y) {
+        L->values[i] = sum / L->values[L->diagonal[x]];
+      } else if (sum <= 0.0) {
+        throw std::runtime_error(
+            "Incomplete Cholesky broke down at row " + std::to_string(y) +
+            "; the matrix is not positive definite enough.");
+      } else {
+        L->values[i] = sqrt(sum);
+      }
+    }
+  }
+  return vectorOperator([L](std::vector<double> &x) {
+    solveLower(*L, false, x);
+    solveLowerTransposed(*L, x);
+  });
+}
+
+LinearOperator incompleteLUPreconditioner(const Matrix &A) {
+  auto LU = std::make_shared<SparseRows>(sparseRows(A, false));
+  size_t n = A.height();
+  // IKJ Gaussian elimination restricted to the pattern of A. position[x]
+  // is the index of column x in the current row, or nnz if it is not there.
+  size_t nnz = LU->values.size();
+  std::vector<size_t> position(n, nnz);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t i = LU->row_start[y]; i < LU->row_start[y + 1]; i++) {
+      position[LU->cols[i]] = i;
+    }
+    for (size_t i = LU->row_start[y]; i < LU->diagonal[y]; i++) {
+      size_t k = LU->cols[i];
+      double pivot = LU->values[LU->diagonal[k]];
+      LU->values[i] /= pivot;
+      double l = LU->values[i];
+      for (size_t j = LU->diagonal[k] + 1; j < LU->row_start[k + 1]; j++) {
+        size_t p = position[LU->cols[j]];
+        if (p != nnz) {
+          LU->values[p] -= l * LU->values[j];
+        }
+      }
+    }
+    if (LU->values[LU->diagonal[y]] == 0.0) {
+      throw std::runtime_error("Incomplete LU has a zero pivot at row " +
+                               std::to_string(y) + ".");
+    }
+    for (size_t i = LU->row_start[y]; i < LU->row_start[y + 1]; i++) {
+      position[LU->cols[i]] = nnz;
+    }
+  }
+  return vectorOperator([LU](std::vector<double> &x) {
+    solveLower(*LU, true, x);
+    solveUpper(*LU, x);
+  });
+}
+}; // namespace basic_matrix
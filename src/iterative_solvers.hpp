@@ -0,0 +1,109 @@
+#pragma once
+#include "krylov.hpp"
+#include "matrix.hpp"
+
+namespace basic_matrix {
+struct IterativeSolverOptions {
+  /// The solve has converged once ||b - A * x|| is below
+  /// tolerance * ||b||.
+  double tolerance = 1e-10;
+
+  /// Maximum number of iterations (products with A). 0 picks 10 * n.
+  size_t max_iterations = 0;
+
+  /// GMRES only: the dimension of the Krylov subspace built before
+  /// restarting. GMRES stores restart + 1 vectors of length n.
+  size_t restart = 30;
+
+  /// Applies M^-1, an approximation of A^-1, to an n x 1 vector. Empty for
+  /// no preconditioning. See jacobiPreconditioner,
+  /// incompleteCholeskyPreconditioner and incompleteLUPreconditioner.
+  LinearOperator preconditioner;
+};
+
+/// The result of an iterative solver.
+struct IterativeSolverResult {
+  /// Number of iterations performed.
+  size_t iterations = 0;
+
+  /// ||b - A * x|| / ||b|| for the returned x.
+  double relative_residual = 0.0;
+
+  /// Whether the relative residual met the tolerance.
+  bool converged = false;
+};
+
+/// Solve A * x = b for a symmetric positive definite n x n operator A with
+/// the (preconditioned) conjugate gradient method. The preconditioner must
+/// be symmetric positive definite too.
+///
+/// Each iteration costs one product with A, one application of the
+/// preconditioner and O(n) vector work; only four vectors of length n are
+/// stored.
+///
+/// @in A - the operator, applied to n x 1 vectors.
+/// @in b - the n x 1 right-hand side.
+/// @in/out x - the starting guess, if it is an ok() n x 1 vector (a warm
+///             start, e.g. from a previous solve), or zero otherwise.
+///             Replaced by the solution.
+IterativeSolverResult conjugateGradient(
+    const LinearOperator &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// conjugateGradient for an explicit matrix.
+IterativeSolverResult conjugateGradient(
+    const Matrix &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// Solve A * x = b for a general n x n operator A with restarted GMRES,
+/// GMRES(m) with m = options.restart.
+///
+/// An orthonormal basis of the Krylov subspace is built with modified
+/// Gram-Schmidt, and the least squares problem for the residual is updated
+/// with Givens rotations, so its norm is known every iteration without
+/// forming x. The preconditioner is applied on the right, so the residual
+/// that is monitored is the true residual. Arguments as for
+/// conjugateGradient.
+IterativeSolverResult gmres(
+    const LinearOperator &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// gmres for an explicit matrix.
+IterativeSolverResult gmres(
+    const Matrix &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// Solve A * x = b for a general n x n operator A with BiCGSTAB, van der
+/// Vorst's stabilized biconjugate gradient method, preconditioned on the
+/// right.
+///
+/// Each iteration costs two products with A and stores a fixed number of
+/// vectors, unlike GMRES, but the residual does not decrease monotonically
+/// and the method can break down. An iteration counts as one product with
+/// A. Arguments as for conjugateGradient.
+IterativeSolverResult bicgstab(
+    const LinearOperator &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// bicgstab for an explicit matrix.
+IterativeSolverResult bicgstab(
+    const Matrix &A, const Matrix &b, Matrix &x,
+    const IterativeSolverOptions &options = IterativeSolverOptions());
+
+/// The Jacobi preconditioner, M = diag(A). Throws if a diagonal entry of A
+/// is zero.
+LinearOperator jacobiPreconditioner(const Matrix &A);
+
+/// The incomplete Cholesky preconditioner IC(0), M = L * L^T, where L has
+/// the sparsity pattern of the lower triangle of A. Only the nonzeros of A
+/// are stored, and applying M^-1 takes two triangular solves, O(nnz(A)).
+/// A must be symmetric positive definite; throws if the factorization
+/// breaks down with a non-positive pivot.
+LinearOperator incompleteCholeskyPreconditioner(const Matrix &A);
+
+/// The incomplete LU preconditioner ILU(0), M = L * U, where L and U have
+/// the sparsity pattern of A. Only the nonzeros of A are stored, and
+/// applying M^-1 takes two triangular solves, O(nnz(A)). There is no
+/// pivoting; throws if a pivot is zero.
+LinearOperator incompleteLUPreconditioner(const Matrix &A);
+}; // namespace basic_matrix
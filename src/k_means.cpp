@@ -1,11 +1,53 @@
 #include "k_means.hpp"
+#include <algorithm>
 #include <unordered_set>
 
 namespace basic_matrix {
 namespace k_means {
 namespace {
+/// The points, one after the other, each flattened row by row to
+/// dimension doubles. The distance computations then run over contiguous
+/// memory instead of going through a Matrix temporary per point.
+struct FlatPoints {
+  FlatPoints(const std::vector<Matrix> &points)
+      : count(points.size()),
+        dimension(points.empty() ? 0
+                                 : points[0].width() * points[0].height()),
+        values(count * dimension) {
+    for (size_t i = 0; i < count; i++) {
+      const Matrix &point = points[i];
+      if (point.width() * point.height() != dimension) {
+        throw std::runtime_error("All points must have the same dimensions.");
+      }
+      double *out = &values[i * dimension];
+      for (size_t y = 0; y < point.height(); y++) {
+        for (size_t x = 0; x < point.width(); x++) {
+          *out++ = point(x, y);
+        }
+      }
+    }
+  }
+  const double *operator[](const size_t &i) const {
+    return &values[i * dimension];
+  }
+
+  size_t count;
+  size_t dimension;
+  std::vector<double> values;
+};
+
+double squaredDistance(const double *a, const double *b, const size_t &n) {
+  double sum = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
 std::vector<KMeansCluster>
-pickInitialClusters(const std::vector<Matrix> &points, const size_t &num_points,
+pickInitialClusters(const std::vector<Matrix> &points, const FlatPoints &flat,
+                    const size_t &num_points,
                     const size_t &num_attempts = 100) {
   std::vector<KMeansCluster> result;
   if (num_points == 0) {
@@ -27,11 +69,11 @@ pickInitialClusters(const std::vector<Matrix> &points, const size_t &num_points,
       while (selected_set.find(candidate_idx) != selected_set.end()) {
         candidate_idx = rand() % points.size();
       }
-      auto point = points[candidate_idx];
       double min_distance = std::numeric_limits<double>::max();
       for (const auto &existing_centroid_idx : result_indices) {
-        auto existing_centroid_pt = points[existing_centroid_idx];
-        double distance = (existing_centroid_pt - point).norm();
+        double distance =
+            squaredDistance(flat[existing_centroid_idx], flat[candidate_idx],
+                            flat.dimension);
         if (distance < min_distance) {
           min_distance = distance;
         }
@@ -51,24 +93,38 @@ pickInitialClusters(const std::vector<Matrix> &points, const size_t &num_points,
   return result;
 }
 
-void assignNearestClusterCenters(const std::vector<Matrix> &points,
+void assignNearestClusterCenters(const FlatPoints &points,
                                  KMeansClustering &result) {
   // Clear all cluster members
   for (auto &cluster : result.clusters) {
     cluster.member_indices.clear();
   }
+  size_t k = result.clusters.size();
+  size_t d = points.dimension;
+  if (k == 0) {
+    return;
+  }
+  // The centroids, flattened like the points, so that every distance is
+  // computed exactly over contiguous memory.
+  std::vector<double> centroids(k * d);
+  for (size_t c = 0; c < k; c++) {
+    const Matrix &centroid = result.clusters[c].centroid;
+    double *out = &centroids[c * d];
+    for (size_t y = 0; y < centroid.height(); y++) {
+      for (size_t x = 0; x < centroid.width(); x++) {
+        *out++ = centroid(x, y);
+      }
+    }
+  }
   // Assign points to nearest centroid
-  for (size_t i = 0; i < points.size(); i++) {
-    const Matrix &point = points[i];
+  for (size_t i = 0; i < points.count; i++) {
     size_t nearest_idx = 0;
     double lowest_distance = std::numeric_limits<double>::max();
-    for (size_t cluster_idx = 0; cluster_idx < result.clusters.size();
-         cluster_idx++) {
-      const auto &cluster = result.clusters[cluster_idx];
-      double distance = (cluster.centroid - point).norm();
+    for (size_t c = 0; c < k; c++) {
+      double distance = squaredDistance(points[i], &centroids[c * d], d);
       if (distance < lowest_distance) {
         lowest_distance = distance;
-        nearest_idx = cluster_idx;
+        nearest_idx = c;
       }
     }
     result.clusters[nearest_idx].member_indices.push_back(i);
@@ -84,17 +140,30 @@ double aggregateMovement(const KMeansClustering &c1,
   return sum;
 }
 void recalculateCentroid(KMeansClustering &clustering,
-                         const std::vector<Matrix> &points) {
+                         const std::vector<Matrix> &points,
+                         const FlatPoints &flat) {
+  std::vector<double> sum(flat.dimension);
   for (auto &cluster : clustering.clusters) {
     if (cluster.member_indices.size() == 0) {
       continue;
     }
+    std::fill(sum.begin(), sum.end(), 0.0);
+    for (const auto &idx : cluster.member_indices) {
+      const double *point = flat[idx];
+      for (size_t i = 0; i < flat.dimension; i++) {
+        sum[i] += point[i];
+      }
+    }
+    // The centroid takes the shape of the points.
     Matrix centroid = points[cluster.member_indices[0]];
-    for (size_t i = 1; i < cluster.member_indices.size(); i++) {
-      centroid = centroid + points[cluster.member_indices[i]];
+    double scale = 1.0 / static_cast<double>(cluster.member_indices.size());
+    const double *value = sum.data();
+    for (size_t y = 0; y < centroid.height(); y++) {
+      for (size_t x = 0; x < centroid.width(); x++) {
+        centroid(x, y) = *value++ * scale;
+      }
     }
-    cluster.centroid =
-        centroid * (1.0 / static_cast<double>(cluster.member_indices.size()));
+    cluster.centroid = centroid;
   }
 }
 
@@ -102,13 +171,14 @@ void recalculateCentroid(KMeansClustering &clustering,
 KMeansClustering clusterByNaiveKMeans(const std::vector<Matrix> &points,
                                       const KMeansOptions &options) {
   KMeansClustering result;
-  result.clusters = pickInitialClusters(points, options.k);
+  FlatPoints flat(points);
+  result.clusters = pickInitialClusters(points, flat, options.k);
   result.movement = std::numeric_limits<size_t>::max();
   while (result.movement > options.movement_threshold &&
          result.num_iterations < options.max_iterations) {
-    assignNearestClusterCenters(points, result);
+    assignNearestClusterCenters(flat, result);
     auto clusters_before = result;
-    recalculateCentroid(result, points);
+    recalculateCentroid(result, points, flat);
     result.movement = aggregateMovement(clusters_before, result);
     result.num_iterations++;
   }
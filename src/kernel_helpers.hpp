@@ -0,0 +1,39 @@
+#pragma once
+#include "matrix.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace basic_matrix {
+/// Indices per parallelFor chunk so that each chunk does roughly 2^14
+/// flops, when count indices do flops in total.
+inline size_t indicesPerChunk(const size_t &count, const size_t &flops) {
+  return std::max<size_t>(1, (count << 14) / std::max<size_t>(flops, 1));
+}
+
+/// Make mat a width x height matrix, keeping its storage if it already has
+/// that size.
+inline void resizeIfNeeded(Matrix &mat, const size_t &width,
+                           const size_t &height) {
+  if (mat.width() != width || mat.height() != height) {
+    mat = Matrix(width, height);
+  }
+}
+
+/// Call fn(b) if b is contiguous, so that fn can work on b.data().
+/// Otherwise call it on a contiguous copy and copy the result back into b.
+/// Returns what fn returns.
+template <typename Fn> auto onContiguous(Matrix &b, const Fn &fn) {
+  if (b.contiguous()) {
+    return fn(b);
+  }
+  Matrix b_contiguous = b;
+  if constexpr (std::is_void_v<decltype(fn(b_contiguous))>) {
+    fn(b_contiguous);
+    b = b_contiguous;
+  } else {
+    auto result = fn(b_contiguous);
+    b = b_contiguous;
+    return result;
+  }
+}
+}; // namespace basic_matrix
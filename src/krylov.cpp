@@ -0,0 +1,445 @@
+#include "krylov.hpp"
+#include "eigenvalues.hpp"
+#include "qr_factorization.hpp"
+#include "symmetric_eigenvalues.hpp"
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <math.h>
+#include <numeric>
+#include <random>
+
+namespace basic_matrix {
+namespace {
+constexpr size_t kMinSubspaceSize = 20;
+// ||f|| below this fraction of ||A * v|| means the Krylov subspace is
+// (numerically) invariant.
+constexpr double kBreakdownTolerance = 1e-12;
+
+/// An m-step Arnoldi factorization A * V^T = V^T * H + f * e_m^T. Row j of
+/// V is basis vector j. H is upper Hessenberg (tridiagonal for Lanczos)
+/// until the first restart, after which its leading block is full.
+struct ArnoldiFactorization {
+  ArnoldiFactorization(const size_t &n_in, const size_t &m_in,
+                       const size_t &seed)
+      : n(n_in), m(m_in), V(n_in, m_in), H(m_in, m_in), f(n_in), b(m_in),
+        gen(seed) {}
+
+  size_t n;
+  size_t m;
+  Matrix V;
+  Matrix H;
+  std::vector<double> f;
+  /// The residual row: A * V^T = V^T * H + f * b^T. b = e_m right after
+  /// extend, but not after a restart.
+  std::vector<double> b;
+  size_t num_matvecs = 0;
+  std::mt19937 gen;
+};
+
+/// Ritz values, and the eigenvectors of H belonging to them, as real and
+/// imaginary parts of unit vectors of length m.
+struct RitzPair {
+  double re = 0.0;
+  double im = 0.0;
+  std::vector<double> y_re;
+  std::vector<double> y_im;
+};
+
+double norm(const std::vector<double> &x) {
+  double s = 0.0;
+  for (const auto &xi : x) {
+    s += xi * xi;
+  }
+  return sqrt(s);
+}
+
+/// Classical Gram-Schmidt, twice, against rows 0..j-1 of V. The
+/// coefficients are added to h.
+void orthogonalize(const ArnoldiFactorization &af, const size_t &j,
+                   std::vector<double> &w, std::vector<double> &h) {
+  const double *v = af.V.data();
+  std::vector<double> c(j);
+  for (size_t pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < j; i++) {
+      const double *vi = &v[i * af.n];
+      double s = 0.0;
+      for (size_t x = 0; x < af.n; x++) {
+        s += vi[x] * w[x];
+      }
+      c[i] = s;
+      h[i] += s;
+    }
+    for (size_t i = 0; i < j; i++) {
+      const double *vi = &v[i * af.n];
+      for (size_t x = 0; x < af.n; x++) {
+        w[x] -= c[i] * vi[x];
+      }
+    }
+  }
+}
+
+/// Replace f with a random vector orthogonal to the first j basis vectors.
+void randomResidual(ArnoldiFactorization &af, const size_t &j) {
+  std::normal_distribution<double> dist;
+  for (auto &fi : af.f) {
+    fi = dist(af.gen);
+  }
+  std::vector<double> h(j);
+  orthogonalize(af, j, af.f, h);
+}
+
+/// Extend the factorization from j0 to m steps.
+void extend(ArnoldiFactorization &af, const LinearOperator &A,
+            const size_t &j0, const bool &symmetric) {
+  double *v = af.V.data();
+  double *H = af.H.data();
+  size_t n = af.n;
+  size_t m = af.m;
+  double scale = 0.0;
+  for (size_t j = j0; j < m; j++) {
+    double beta = norm(af.f);
+    if (j > 0 && beta <= kBreakdownTolerance * scale) {
+      // The subspace is invariant; continue with a fresh direction.
+      randomResidual(af, j);
+      beta = 0.0;
+      double f_norm = norm(af.f);
+      for (auto &fi : af.f) {
+        fi /= f_norm;
+      }
+    } else {
+      for (auto &fi : af.f) {
+        fi /= beta;
+      }
+    }
+    for (size_t i = 0; i < j; i++) {
+      H[j * m + i] = beta * af.b[i];
+    }
+    std::copy(af.f.begin(), af.f.end(), &v[j * n]);
+    Matrix x(1, n);
+    std::copy(af.f.begin(), af.f.end(), x.data());
+    Matrix y = A(x);
+    af.num_matvecs++;
+    if (y.height() != n || y.width() != 1) {
+      throw std::runtime_error(
+          "The linear operator must return an n x 1 column vector.");
+    }
+    for (size_t i = 0; i < n; i++) {
+      af.f[i] = y(0, i);
+    }
+    scale = norm(af.f);
+    std::vector<double> h(j + 1, 0.0);
+    orthogonalize(af, j + 1, af.f, h);
+    for (size_t i = 0; i <= j; i++) {
+      H[i * m + j] = h[i];
+    }
+    if (symmetric) {
+      // Lanczos: H is symmetric, and the difference between the computed
+      // column and the mirrored row is rounding error of the
+      // reorthogonalization.
+      for (size_t i = 0; i < j; i++) {
+        H[i * m + j] = H[j * m + i];
+      }
+    }
+    std::fill(af.b.begin(), af.b.end(), 0.0);
+    af.b[j] = 1.0;
+  }
+}
+
+/// Eigenvector of the m x m matrix H for the eigenvalue (re, im), by
+/// inverse iteration with complex LU and partial pivoting.
+void smallEigenvector(const Matrix &H, RitzPair &pair) {
+  using complex = std::complex<double>;
+  size_t m = H.height();
+  double h_norm = 0.0;
+  for (size_t y = 0; y < m; y++) {
+    for (size_t x = 0; x < m; x++) {
+      h_norm = std::max(h_norm, fabs(H(x, y)));
+    }
+  }
+  double tiny = std::numeric_limits<double>::epsilon() * std::max(h_norm, 1.0);
+  complex lambda(pair.re, pair.im);
+  std::vector<complex> lu(m * m);
+  for (size_t y = 0; y < m; y++) {
+    for (size_t x = 0; x < m; x++) {
+      lu[y * m + x] = H(x, y) - (x == y ? lambda : complex(0.0));
+    }
+  }
+  std::vector<size_t> pivot(m);
+  for (size_t c = 0; c < m; c++) {
+    size_t p = c;
+    for (size_t r = c + 1; r < m; r++) {
+      if (std::abs(lu[r * m + c]) > std::abs(lu[p * m + c])) {
+        p = r;
+      }
+    }
+    pivot[c] = p;
+    if (p != c) {
+      std::swap_ranges(&lu[c * m], &lu[c * m] + m, &lu[p * m]);
+    }
+    if (std::abs(lu[c * m + c]) < tiny) {
+      lu[c * m + c] = tiny;
+    }
+    for (size_t r = c + 1; r < m; r++) {
+      complex l = lu[r * m + c] / lu[c * m + c];
+      lu[r * m + c] = l;
+      for (size_t x = c + 1; x < m; x++) {
+        lu[r * m + x] -= l * lu[c * m + x];
+      }
+    }
+  }
+  std::vector<complex> y(m, 1.0);
+  for (size_t iteration = 0; iteration < 2; iteration++) {
+    for (size_t c = 0; c < m; c++) {
+      std::swap(y[c], y[pivot[c]]);
+    }
+    for (size_t c = 0; c < m; c++) {
+      for (size_t r = c + 1; r < m; r++) {
+        y[r] -= lu[r * m + c] * y[c];
+      }
+    }
+    for (size_t c = m; c-- > 0;) {
+      for (size_t x = c + 1; x < m; x++) {
+        y[c] -= lu[c * m + x] * y[x];
+      }
+      y[c] /= lu[c * m + c];
+    }
+    double y_norm = 0.0;
+    for (const auto &yi : y) {
+      y_norm += std::norm(yi);
+    }
+    y_norm = sqrt(y_norm);
+    for (auto &yi : y) {
+      yi /= y_norm;
+    }
+  }
+  pair.y_re.resize(m);
+  pair.y_im.resize(m);
+  for (size_t i = 0; i < m; i++) {
+    pair.y_re[i] = y[i].real();
+    pair.y_im[i] = y[i].imag();
+  }
+}
+
+/// The Ritz pairs of the factorization, most wanted first. Eigenvectors of
+/// H are only computed for the first num_vectors pairs.
+std::vector<RitzPair> ritzPairs(const ArnoldiFactorization &af,
+                                const bool &symmetric,
+                                const EigenvalueOrder &order,
+                                const size_t &num_vectors) {
+  size_t m = af.m;
+  std::vector<RitzPair> pairs(m);
+  Matrix vectors;
+  if (symmetric) {
+    Matrix values;
+    if (!symmetricEigen(af.H, values, vectors)) {
+      throw std::runtime_error("Lanczos failed to diagonalize its projection.");
+    }
+    for (size_t i = 0; i < m; i++) {
+      pairs[i].re = values(0, i);
+    }
+  } else {
+    Matrix values = complexEigenvalues(af.H);
+    if (!values.ok()) {
+      throw std::runtime_error(
+          "Arnoldi failed to compute the eigenvalues of its projection.");
+    }
+    for (size_t i = 0; i < m; i++) {
+      pairs[i].re = values(0, i);
+      pairs[i].im = values(1, i);
+    }
+  }
+  std::vector<size_t> index(m);
+  std::iota(index.begin(), index.end(), 0);
+  auto key = [&](const RitzPair &p) {
+    switch (order) {
+    case EigenvalueOrder::LargestMagnitude:
+      return hypot(p.re, p.im);
+    case EigenvalueOrder::LargestReal:
+      return p.re;
+    case EigenvalueOrder::SmallestReal:
+      return -p.re;
+    }
+    return 0.0;
+  };
+  // Ties are broken so that complex conjugates end up next to each other,
+  // positive imaginary part first.
+  std::stable_sort(index.begin(), index.end(),
+                   [&](const size_t &a, const size_t &b) {
+                     double ka = key(pairs[a]);
+                     double kb = key(pairs[b]);
+                     if (ka != kb) {
+                       return ka > kb;
+                     }
+                     if (pairs[a].re != pairs[b].re) {
+                       return pairs[a].re > pairs[b].re;
+                     }
+                     return pairs[a].im > pairs[b].im;
+                   });
+  std::vector<RitzPair> sorted(m);
+  for (size_t i = 0; i < m; i++) {
+    sorted[i] = pairs[index[i]];
+    if (i >= num_vectors) {
+      continue;
+    }
+    if (symmetric) {
+      sorted[i].y_re.resize(m);
+      sorted[i].y_im.assign(m, 0.0);
+      for (size_t r = 0; r < m; r++) {
+        sorted[i].y_re[r] = vectors(index[i], r);
+      }
+    } else {
+      smallEigenvector(af.H, sorted[i]);
+    }
+  }
+  return sorted;
+}
+
+/// Thick restart: compress the factorization onto the wanted Ritz vectors
+/// ritz[0:kk]. This is equivalent to implicit restarting with the unwanted
+/// Ritz values as exact shifts, but it never runs shifted QR steps on H,
+/// which lose the structure of H (and with it the Arnoldi relation) once
+/// the shifts are close to converged eigenvalues.
+///
+/// With W an orthonormal basis of the wanted Ritz vectors of H,
+/// A * V^T * W = V^T * W * (W^T * H * W) + f * (W^T * e_m)^T, a Krylov
+/// decomposition of size kk whose residual row is no longer a multiple of
+/// e_kk. extend picks it up from b.
+void thickRestart(ArnoldiFactorization &af,
+                  const std::vector<RitzPair> &ritz, const size_t &kk) {
+  size_t m = af.m;
+  size_t n = af.n;
+  Matrix W(kk, m);
+  for (size_t i = 0; i < kk; i++) {
+    // The real and imaginary parts of a complex pair span the same real
+    // invariant subspace as the pair.
+    bool second_of_pair =
+        ritz[i].im < 0.0 && i > 0 && ritz[i - 1].im == -ritz[i].im;
+    for (size_t r = 0; r < m; r++) {
+      W(i, r) = second_of_pair ? ritz[i - 1].y_im[r] : ritz[i].y_re[r];
+    }
+  }
+  Matrix tau;
+  householderQR(W, tau);
+  W = formQ(W, tau, true);
+  Matrix S = W.transpose() * af.H * W;
+  Matrix V = W.transpose() * af.V;
+  af.H = Matrix(m, m);
+  af.V = Matrix(n, m);
+  for (size_t y = 0; y < kk; y++) {
+    for (size_t x = 0; x < kk; x++) {
+      af.H(x, y) = S(x, y);
+    }
+    af.b[y] = W(y, m - 1);
+  }
+  std::copy(V.data(), V.data() + kk * n, af.V.data());
+}
+
+KrylovEigenpairs krylovEigen(const LinearOperator &A, const size_t &n,
+                             const size_t &k, const KrylovOptions &options,
+                             const bool &symmetric) {
+  if (k == 0 || k > n) {
+    throw std::runtime_error(
+        "The number of eigenpairs must be between 1 and n.");
+  }
+  size_t m = options.subspace_size;
+  if (m == 0) {
+    m = std::max(2 * k + 1, kMinSubspaceSize);
+  }
+  m = std::min(m, n);
+  if (m < std::min(k + 2, n)) {
+    throw std::runtime_error(
+        "The Krylov subspace must be at least 2 larger than k.");
+  }
+  const double eps = std::numeric_limits<double>::epsilon();
+  ArnoldiFactorization af(n, m, options.seed);
+  randomResidual(af, 0);
+  extend(af, A, 0, symmetric);
+
+  KrylovEigenpairs result;
+  std::vector<RitzPair> ritz;
+  size_t kk = k;
+  // Restarts keep the wanted pairs plus half of the others, the nearest
+  // ones first; they make up most of the error in the wanted ones.
+  size_t keep = k + (m - k) / 2;
+  while (true) {
+    ritz = ritzPairs(af, symmetric, options.order, std::min(keep + 1, m));
+    // Keep complex conjugate pairs together.
+    auto splitsPair = [&](const size_t &count) {
+      return !symmetric && count < m && ritz[count - 1].im > 0.0;
+    };
+    kk = splitsPair(k) ? k + 1 : k;
+    double f_norm = norm(af.f);
+    bool converged = true;
+    for (size_t i = 0; i < kk; i++) {
+      double last = hypot(ritz[i].y_re[m - 1], ritz[i].y_im[m - 1]);
+      double magnitude = std::max(hypot(ritz[i].re, ritz[i].im),
+                                  pow(eps, 2.0 / 3.0));
+      if (f_norm * last > options.tolerance * magnitude) {
+        converged = false;
+        break;
+      }
+    }
+    // With m == n the factorization is complete and the Ritz pairs exact.
+    if (converged || m == n) {
+      result.converged = true;
+      break;
+    }
+    size_t num_kept = std::max(kk, splitsPair(keep) ? keep + 1 : keep);
+    if (result.num_restarts == options.max_restarts || num_kept + 1 > m) {
+      break;
+    }
+    thickRestart(af, ritz, num_kept);
+    extend(af, A, num_kept, symmetric);
+    result.num_restarts++;
+  }
+
+  result.num_matvecs = af.num_matvecs;
+  result.values = Matrix(symmetric ? 1 : 2, kk);
+  Matrix Y(kk, m);
+  for (size_t i = 0; i < kk; i++) {
+    result.values(0, i) = ritz[i].re;
+    if (!symmetric) {
+      result.values(1, i) = ritz[i].im;
+    }
+    // For a conjugate pair, the second column holds the imaginary part of
+    // the first eigenvector.
+    bool second_of_pair = !symmetric && ritz[i].im < 0.0 && i > 0 &&
+                          ritz[i - 1].im == -ritz[i].im;
+    for (size_t r = 0; r < m; r++) {
+      Y(i, r) = second_of_pair ? ritz[i - 1].y_im[r] : ritz[i].y_re[r];
+    }
+  }
+  result.vectors = af.V.transpose() * Y;
+  return result;
+}
+
+LinearOperator matrixOperator(const Matrix &A) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error(
+        "Cannot compute eigenvalues for non-square matrix.");
+  }
+  return [&A](const Matrix &x) { return A * x; };
+}
+}; // namespace
+
+KrylovEigenpairs lanczosEigen(const LinearOperator &A, const size_t &n,
+                              const size_t &k, const KrylovOptions &options) {
+  return krylovEigen(A, n, k, options, true);
+}
+
+KrylovEigenpairs lanczosEigen(const Matrix &A, const size_t &k,
+                              const KrylovOptions &options) {
+  return krylovEigen(matrixOperator(A), A.height(), k, options, true);
+}
+
+KrylovEigenpairs arnoldiEigen(const LinearOperator &A, const size_t &n,
+                              const size_t &k, const KrylovOptions &options) {
+  return krylovEigen(A, n, k, options, false);
+}
+
+KrylovEigenpairs arnoldiEigen(const Matrix &A, const size_t &k,
+                              const KrylovOptions &options) {
+  return krylovEigen(matrixOperator(A), A.height(), k, options, false);
+}
+}; // namespace basic_matrix
@@ -0,0 +1,95 @@
+#pragma once
+#include "matrix.hpp"
+#include <functional>
+
+namespace basic_matrix {
+/// A linear operator, y = A * x, on n x 1 column vectors. Lets solvers work
+/// on matrices that are never formed explicitly.
+using LinearOperator = std::function<Matrix(const Matrix &)>;
+
+/// Which end of the spectrum a Krylov eigensolver converges to.
+enum class EigenvalueOrder {
+  LargestMagnitude,
+  LargestReal,
+  SmallestReal,
+};
+
+struct KrylovOptions {
+  /// Which eigenvalues to find. Eigenpairs are returned in this order.
+  EigenvalueOrder order = EigenvalueOrder::LargestMagnitude;
+
+  /// Dimension of the Krylov subspace built between restarts. 0 picks
+  /// max(2k + 1, 20), limited to n. Larger subspaces need fewer restarts
+  /// but store more vectors of length n.
+  size_t subspace_size = 0;
+
+  /// A Ritz pair (lambda, x) has converged once ||A * x - lambda * x|| is
+  /// below tolerance * |lambda|.
+  double tolerance = 1e-10;
+
+  /// Maximum number of restarts.
+  size_t max_restarts = 1000;
+
+  /// Seed of the random starting vector.
+  size_t seed = 0;
+};
+
+/// The result of a Krylov eigensolver.
+struct KrylovEigenpairs {
+  /// For lanczosEigen, a k x 1 matrix of eigenvalues. For arnoldiEigen, a
+  /// k x 2 matrix with real parts in the first column and imaginary parts
+  /// in the second, like complexEigenvalues.
+  Matrix values;
+
+  /// n x k unit eigenvectors, the one for eigenvalue i in column i. For a
+  /// complex conjugate pair in rows i and i + 1 (positive imaginary part
+  /// first), columns i and i + 1 hold the real and imaginary parts of the
+  /// eigenvector of eigenvalue i, as in LAPACK's xGEEV.
+  Matrix vectors;
+
+  /// Number of restarts performed.
+  size_t num_restarts = 0;
+
+  /// Number of times the operator was applied.
+  size_t num_matvecs = 0;
+
+  /// Whether all requested eigenpairs met the tolerance.
+  bool converged = false;
+};
+
+/// Find k eigenpairs of the symmetric n x n operator A with the restarted
+/// Lanczos method.
+///
+/// A Krylov subspace of dimension m (options.subspace_size) is built with
+/// the Lanczos recurrence, with full reorthogonalization, and the Ritz
+/// pairs are read off the small m x m projection of A. The subspace is then
+/// compressed onto the wanted Ritz vectors and half of the others (a thick
+/// restart, which is equivalent to implicit restarting with exact shifts
+/// but numerically stable) and extended again. The cost is dominated by
+/// the products with A and O(n * m^2) work per restart; nothing of size
+/// n x n is formed.
+KrylovEigenpairs lanczosEigen(const LinearOperator &A, const size_t &n,
+                              const size_t &k,
+                              const KrylovOptions &options = KrylovOptions());
+
+/// lanczosEigen for an explicit symmetric matrix.
+KrylovEigenpairs lanczosEigen(const Matrix &A, const size_t &k,
+                              const KrylovOptions &options = KrylovOptions());
+
+/// Find k eigenpairs of the general n x n operator A with the restarted
+/// Arnoldi method.
+///
+/// Works like lanczosEigen, but the projection of A is not symmetric. Its
+/// Ritz values come from complexEigenvalues, and restarts keep an
+/// orthonormal basis of the real and imaginary parts of the kept Ritz
+/// vectors (as in Stewart's Krylov-Schur method), so everything stays in
+/// real arithmetic. If the k-th eigenvalue is one of a complex conjugate
+/// pair, the pair is kept together and k + 1 eigenpairs are returned.
+KrylovEigenpairs arnoldiEigen(const LinearOperator &A, const size_t &n,
+                              const size_t &k,
+                              const KrylovOptions &options = KrylovOptions());
+
+/// arnoldiEigen for an explicit matrix.
+KrylovEigenpairs arnoldiEigen(const Matrix &A, const size_t &k,
+                              const KrylovOptions &options = KrylovOptions());
+}; // namespace basic_matrix
@@ -1,20 +1,52 @@
 #include "lup_decomposition.hpp"
 #include "gaussian_elimination.hpp"
+#include "parallel.hpp"
+#include "tile_factorization.hpp"
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <math.h>
 
 namespace basic_matrix {
 
 namespace {
-const double lupDeterminant(const Matrix &L, const Matrix &U,
-                            const size_t &num_pivots) {
-  double det = pow(-1.0, num_pivots);
-  for (size_t x = 0; x < L.width(); x++) {
-    det *= L(x, x);
+/// The size from which lupDecomposition factors with the task graph of
+/// tileLUFactorize, if there is more than one thread. Below it, the panels
+/// are too few to keep the threads busy.
+const size_t kTileLUMinSize = 512;
+
+/// Solve A^T * x = b for a single column b, using the output of
+/// luFactorize. A^T = U^T * L^T * P, so this is a forward substitution with
+/// U^T, a back substitution with the unit L^T, and the row swaps undone in
+/// reverse order.
+void solveLUTransposed(const Matrix &LU, const std::vector<size_t> &pivots,
+                       std::vector<double> &x) {
+  size_t n = LU.height();
+  for (size_t y = 0; y < n; y++) {
+    double sum = x[y];
+    for (size_t k = 0; k < y; k++) {
+      sum -= LU(y, k) * x[k];
+    }
+    x[y] = sum / LU(y, y);
+  }
+  for (size_t y = n; y-- > 0;) {
+    double sum = x[y];
+    for (size_t k = y + 1; k < n; k++) {
+      sum -= LU(y, k) * x[k];
+    }
+    x[y] = sum;
+  }
+  for (size_t y = n; y-- > 0;) {
+    std::swap(x[y], x[pivots[y]]);
   }
-  for (size_t x = 0; x < U.width(); x++) {
-    det *= U(x, x);
+}
+
+double norm1(const std::vector<double> &x) {
+  double sum = 0.0;
+  for (const auto &xi : x) {
+    sum += fabs(xi);
   }
-  return det;
+  return sum;
 }
 }; // namespace
 
@@ -61,14 +93,38 @@ size_t pivot(const basic_matrix::Matrix &A, basic_matrix::Matrix &P) {
 }
 
 bool lupDecomposition(const Matrix &A, Matrix &L, Matrix &U, Matrix &P) {
-  size_t num_pivots = pivot(A, P);
-  Matrix PA = P * A;
-  if (!luDecomposition(PA, L, U)) {
+  Matrix LU = A;
+  std::vector<size_t> pivots;
+  bool factored = A.height() >= kTileLUMinSize && numThreads() > 1
+                      ? tileLUFactorize(LU, pivots)
+                      : luFactorize(LU, pivots);
+  if (!factored ||
+      luRcond(LU, pivots, norm1(A)) < std::numeric_limits<double>::epsilon()) {
     return false;
   }
-  double det = lupDeterminant(L, U, num_pivots);
-  if (fabs(det) < 1e-4) {
-    return false;
+  size_t n = A.height();
+  L = Matrix(n, n);
+  U = Matrix(n, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < y; x++) {
+      L(x, y) = LU(x, y);
+    }
+    L(y, y) = 1.0;
+    for (size_t x = y; x < n; x++) {
+      U(x, y) = LU(x, y);
+    }
+  }
+  // Apply the swaps to the row labels to find where each row of A ends up.
+  std::vector<size_t> rows(n);
+  for (size_t y = 0; y < n; y++) {
+    rows[y] = y;
+  }
+  for (size_t y = 0; y < n; y++) {
+    std::swap(rows[y], rows[pivots[y]]);
+  }
+  P = Matrix(n, n);
+  for (size_t y = 0; y < n; y++) {
+    P(rows[y], y) = 1.0;
   }
   return true;
 }
@@ -122,28 +178,27 @@ void solveL(const Matrix &L, Matrix &b) {
                              " matrix is not square. solveL only works on a "
                              "square lower-triangular matrix.");
   }
-  if (L.height() == 0) {
-    return;
-  }
-  b(0, 0) = b(0, 0) / L(0, 0);
-  for (size_t y = 1; y < L.height(); y++) {
-    double b_result = b(0, y);
-    for (size_t x = 0; x < y; x++) {
-      b_result -= L(x, y) * b(0, x);
+  for (size_t col = 0; col < b.width(); col++) {
+    for (size_t y = 0; y < L.height(); y++) {
+      double b_result = b(col, y);
+      for (size_t x = 0; x < y; x++) {
+        b_result -= L(x, y) * b(col, x);
+      }
+      b(col, y) = b_result / L(y, y);
     }
-    b(0, y) = b_result / L(y, y);
   }
 }
 
 void solveU(const Matrix &U, Matrix &b) {
   int start_y = std::min(U.height(), U.width()) - 1;
-  b(0, start_y) = b(start_y, 0) / U(start_y, start_y);
-  for (int y = start_y - 1; y >= 0; y--) {
-    double b_result = b(0, y);
-    for (int x = start_y; x > y; x--) {
-      b_result -= U(x, y) * b(0, x);
+  for (size_t col = 0; col < b.width(); col++) {
+    for (int y = start_y; y >= 0; y--) {
+      double b_result = b(col, y);
+      for (int x = start_y; x > y; x--) {
+        b_result -= U(x, y) * b(col, x);
+      }
+      b(col, y) = b_result / U(y, y);
     }
-    b(0, y) = b_result / U(y, y);
   }
 }
 
@@ -153,14 +208,219 @@ void solveLUP(const Matrix &L, const Matrix &U, const Matrix &P, Matrix &b) {
   solveU(U, b);
 }
 
+bool luFactorize(Matrix &A, std::vector<size_t> &pivots) {
+  if (A.width() != A.height()) {
+    throw std::runtime_error(
+        "Input matrix was " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) +
+        " but a square matrix is required for lu factorization.");
+  }
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    bool result = luFactorize(A_contiguous, pivots);
+    A = A_contiguous;
+    return result;
+  }
+  size_t n = A.height();
+  pivots.resize(n);
+  double *a = A.data();
+  for (size_t k = 0; k < n; k++) {
+    size_t p = k;
+    for (size_t y = k + 1; y < n; y++) {
+      if (fabs(a[y * n + k]) > fabs(a[p * n + k])) {
+        p = y;
+      }
+    }
+    pivots[k] = p;
+    if (a[p * n + k] == 0.0) {
+      return false;
+    }
+    if (p != k) {
+      std::swap_ranges(&a[k * n], &a[k * n] + n, &a[p * n]);
+    }
+    // Rows below the pivot are independent of each other.
+    const double *pivot_row = &a[k * n];
+    size_t length = n - k - 1;
+    parallelFor(
+        k + 1, n,
+        [&](const size_t &y) {
+          double *row = &a[y * n];
+          double l = row[k] / pivot_row[k];
+          row[k] = l;
+          for (size_t x = k + 1; x < n; x++) {
+            row[x] -= l * pivot_row[x];
+          }
+        },
+        std::max<size_t>(1, 16384 / std::max<size_t>(length, 1)));
+  }
+  return true;
+}
+
+void solveLU(const Matrix &LU, const std::vector<size_t> &pivots,
+             Matrix &b) {
+  size_t n = LU.height();
+  if (b.height() != n) {
+    throw std::runtime_error("b has height " + std::to_string(b.height()) +
+                             " but the factored matrix is " +
+                             std::to_string(n) + "x" + std::to_string(n));
+  }
+  if (!b.contiguous()) {
+    Matrix b_contiguous = b;
+    solveLU(LU, pivots, b_contiguous);
+    b = b_contiguous;
+    return;
+  }
+  size_t w = b.width();
+  double *x = b.data();
+  for (size_t y = 0; y < n; y++) {
+    if (pivots[y] != y) {
+      std::swap_ranges(&x[y * w], &x[y * w] + w, &x[pivots[y] * w]);
+    }
+  }
+  // Forward substitution with the unit lower triangle, then back
+  // substitution with the upper triangle, a row of b at a time.
+  for (size_t y = 1; y < n; y++) {
+    for (size_t k = 0; k < y; k++) {
+      double l = LU(k, y);
+      for (size_t c = 0; c < w; c++) {
+        x[y * w + c] -= l * x[k * w + c];
+      }
+    }
+  }
+  for (size_t y = n; y-- > 0;) {
+    for (size_t k = y + 1; k < n; k++) {
+      double u = LU(k, y);
+      for (size_t c = 0; c < w; c++) {
+        x[y * w + c] -= u * x[k * w + c];
+      }
+    }
+    double d = LU(y, y);
+    for (size_t c = 0; c < w; c++) {
+      x[y * w + c] /= d;
+    }
+  }
+}
+
+double norm1(const Matrix &A) {
+  double result = 0.0;
+  for (size_t x = 0; x < A.width(); x++) {
+    double sum = 0.0;
+    for (size_t y = 0; y < A.height(); y++) {
+      sum += fabs(A(x, y));
+    }
+    result = std::max(result, sum);
+  }
+  return result;
+}
+
+double luRcond(const Matrix &LU, const std::vector<size_t> &pivots,
+               const double &A_norm1) {
+  size_t n = LU.height();
+  if (n == 0) {
+    return 1.0;
+  }
+  if (A_norm1 == 0.0) {
+    return 0.0;
+  }
+  // Hager's method, as refined by Higham (LAPACK's xLACON): a few steps of
+  // a gradient ascent of ||A^-1 * x||_1 over the unit ball of the 1-norm,
+  // which ends on a vertex e_j. Each step is one solve with A and one with
+  // A^T.
+  std::vector<double> x(n, 1.0 / n);
+  Matrix y(1, n);
+  std::vector<double> z(n);
+  double estimate = 0.0;
+  size_t last_j = n;
+  for (size_t iteration = 0; iteration < 5; iteration++) {
+    std::copy(x.begin(), x.end(), y.data());
+    solveLU(LU, pivots, y);
+    std::copy(y.data(), y.data() + n, z.begin());
+    double new_estimate = norm1(z);
+    if (iteration > 0 && new_estimate <= estimate) {
+      break;
+    }
+    estimate = new_estimate;
+    for (auto &zi : z) {
+      zi = zi >= 0.0 ? 1.0 : -1.0;
+    }
+    solveLUTransposed(LU, pivots, z);
+    size_t j = 0;
+    for (size_t i = 1; i < n; i++) {
+      if (fabs(z[i]) > fabs(z[j])) {
+        j = i;
+      }
+    }
+    double ztx = 0.0;
+    for (size_t i = 0; i < n; i++) {
+      ztx += z[i] * x[i];
+    }
+    if (j == last_j || fabs(z[j]) <= ztx) {
+      break;
+    }
+    std::fill(x.begin(), x.end(), 0.0);
+    x[j] = 1.0;
+    last_j = j;
+  }
+  // Higham's extra test vector, with alternating signs and growing
+  // entries, catches the matrices that fool the gradient steps.
+  for (size_t i = 0; i < n; i++) {
+    y(0, i) = ((i % 2 == 0) ? 1.0 : -1.0) *
+              (1.0 + (n > 1 ? double(i) / double(n - 1) : 0.0));
+  }
+  solveLU(LU, pivots, y);
+  double alternating = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    alternating += fabs(y(0, i));
+  }
+  estimate = std::max(estimate, 2.0 * alternating / (3.0 * n));
+  return 1.0 / (A_norm1 * estimate);
+}
+
+double luDeterminant(const Matrix &LU, const std::vector<size_t> &pivots) {
+  // det = mantissa * 2^exponent, renormalized after every factor.
+  double mantissa = 1.0;
+  long exponent = 0;
+  for (size_t i = 0; i < LU.height(); i++) {
+    if (pivots[i] != i) {
+      mantissa = -mantissa;
+    }
+    int e;
+    mantissa = frexp(mantissa * LU(i, i), &e);
+    exponent += e;
+  }
+  if (exponent > std::numeric_limits<int>::max()) {
+    return copysign(std::numeric_limits<double>::infinity(), mantissa);
+  }
+  if (exponent < std::numeric_limits<int>::min()) {
+    return copysign(0.0, mantissa);
+  }
+  return ldexp(mantissa, int(exponent));
+}
+
+double luLogAbsDeterminant(const Matrix &LU, const std::vector<size_t> &pivots,
+                           double &sign) {
+  sign = 1.0;
+  double log_abs_det = 0.0;
+  for (size_t i = 0; i < LU.height(); i++) {
+    double u = LU(i, i);
+    if ((pivots[i] != i) != (u < 0.0)) {
+      sign = -sign;
+    }
+    log_abs_det += log(fabs(u));
+  }
+  return log_abs_det;
+}
+
 double lupDeterminant(const basic_matrix::Matrix &A) {
+  // The empty product, as in slogdet().
   if (A.width() == 0) {
+    return 1.0;
+  }
+  Matrix LU = A;
+  std::vector<size_t> pivots;
+  if (!luFactorize(LU, pivots)) {
     return 0.0;
   }
-  Matrix P, L, U;
-  size_t num_pivots = pivot(A, P);
-  Matrix PA = P * A;
-  luDecomposition(PA, L, U);
-  return lupDeterminant(L, U, num_pivots);
+  return luDeterminant(LU, pivots);
 }
 }; // namespace basic_matrix
@@ -1,5 +1,6 @@
 #pragma once
 #include "matrix.hpp"
+#include <vector>
 
 namespace basic_matrix {
 ///
@@ -15,6 +16,12 @@ namespace basic_matrix {
 ///    linear systems A*x = b_i for the i rows of matrix A.
 ///
 /// 2. Computing the determinant in a computationally-efficient manner.
+///
+/// A is factored with luFactorize or, if it is large and there is more
+/// than one thread, with the task graph of tileLUFactorize.
+/// L has a unit diagonal. Returns false if A is singular to working
+/// precision, i.e. its estimated reciprocal condition number (luRcond) is
+/// below machine epsilon.
 bool lupDecomposition(const basic_matrix::Matrix &A, basic_matrix::Matrix &L,
                       basic_matrix::Matrix &U, basic_matrix::Matrix &P);
 
@@ -25,19 +32,21 @@ size_t pivot(const basic_matrix::Matrix &A, basic_matrix::Matrix &P);
 bool luDecomposition(const basic_matrix::Matrix &A, basic_matrix::Matrix &L,
                      basic_matrix::Matrix &U);
 
-/// Compute the determinant using LUP decomposition.
+/// Compute the determinant using LUP decomposition. A is factored in place
+/// with luFactorize, on a copy; P, L and U are never formed.
 double lupDeterminant(const basic_matrix::Matrix &A);
 
 /// Solve the linear system L*x = b, where L is a lower-diagonal matrix,  using
 /// back substitution. This will produce the same result to Gaussian elimination
-/// with less computation.
+/// with less computation. Each column of b is solved separately.
 /// @in L - a lower triangular matrix.
 /// @in/out b - b in L*x = b. x is stored in b as the result.
 void solveL(const Matrix &L, Matrix &b);
 
 /// Solve a linear system U*x = b, where U is an upper-diagonal matrix, using
 /// back substitution. Again, this produces the same result as Gaussian
-/// elimination with less computation.
+/// elimination with less computation. Each column of b is solved separately.
+/// Only the upper triangle of U is read.
 /// @in U - an upper triangular matrix.
 /// @in/out b - b in L*x = b. x is stored in b as the result.
 void solveU(const Matrix &L, Matrix &b);
@@ -49,4 +58,48 @@ void solveU(const Matrix &L, Matrix &b);
 /// @in/out b - right-hand side of equation. Output is stored here.
 void solveLUP(const Matrix &L, const Matrix &U, const Matrix &P, Matrix &b);
 
+/// Factor the square matrix A in place with partial pivoting, P*A = L*U,
+/// without forming P, L or U separately. Rows are eliminated with one AXPY
+/// over contiguous memory per row, so this is much cheaper than
+/// lupDecomposition.
+/// @in/out A - on output, U is stored on and above the diagonal and the
+///             multipliers of the unit lower-triangular L below it.
+/// @out pivots - row i was swapped with row pivots[i] at step i, as in
+///               LAPACK's xGETRF.
+/// Returns false if a pivot is exactly zero, i.e. A is singular. A and
+/// pivots are then only partially factored.
+bool luFactorize(Matrix &A, std::vector<size_t> &pivots);
+
+/// Solve A*x = b using the output of luFactorize. Each column of b is
+/// solved; the cost is O(n^2) per column.
+/// @in LU, pivots - result of luFactorize.
+/// @in/out b - right-hand side of equation. Output is stored here.
+void solveLU(const Matrix &LU, const std::vector<size_t> &pivots, Matrix &b);
+
+/// The 1-norm of A, the largest sum of absolute values of a column.
+double norm1(const Matrix &A);
+
+/// Estimate the reciprocal condition number of A in the 1-norm,
+/// 1 / (||A||_1 * ||A^-1||_1), from the output of luFactorize, with
+/// Hager's method as refined by Higham (LAPACK's xGECON). ||A^-1||_1 is
+/// estimated from a handful of solves with the factors, O(n^2) in total,
+/// and is almost always exact or within a factor of 3.
+/// Near 1 for a well-conditioned A, and near machine epsilon or below for
+/// one that is singular to working precision. Unlike the determinant, it
+/// does not change when A is scaled.
+/// @in LU, pivots - result of luFactorize.
+/// @in A_norm1 - norm1 of the matrix that was factored.
+double luRcond(const Matrix &LU, const std::vector<size_t> &pivots,
+               const double &A_norm1);
+
+/// The determinant of A from the output of luFactorize, in O(n). The
+/// product of the diagonal is accumulated with a separate exponent, so it
+/// only overflows if the determinant itself does.
+double luDeterminant(const Matrix &LU, const std::vector<size_t> &pivots);
+
+/// log(|det(A)|) from the output of luFactorize, in O(n).
+/// @out sign - the sign of the determinant, 1 or -1.
+double luLogAbsDeterminant(const Matrix &LU, const std::vector<size_t> &pivots,
+                           double &sign);
+
 }; // namespace basic_matrix
@@ -3,6 +3,7 @@
 #include <cassert>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 namespace basic_matrix {
 
@@ -166,7 +167,7 @@ const double &Matrix::operator()(const size_t &x, const size_t &y) const {
 
 Matrix::Matrix(const Matrix &other)
     : m_width(other.width()), m_height(other.height()),
-      m_storage(other.width() * other.height()) {
+      m_storage(other.width() * other.height()), m_ok(other.ok()) {
   for (size_t x = 0; x < width(); x++) {
     for (size_t y = 0; y < height(); y++) {
       operator()(x, y) = other(x, y);
@@ -255,6 +256,19 @@ double Matrix::det() const {
   return lupDeterminant(*this);
 }
 
+double Matrix::logAbsDet() const { return slogdet().second; }
+
+std::pair<double, double> Matrix::slogdet() const {
+  Matrix LU = *this;
+  std::vector<size_t> pivots;
+  if (!luFactorize(LU, pivots)) {
+    return {0.0, -std::numeric_limits<double>::infinity()};
+  }
+  double sign;
+  double log_abs_det = luLogAbsDeterminant(LU, pivots, sign);
+  return {sign, log_abs_det};
+}
+
 Matrix::Matrix(const std::vector<double> &input) { init({input}); }
 Matrix::Matrix(const std::initializer_list<double> &input) { init({input}); }
 
@@ -3,6 +3,7 @@
 #include <random>
 #include <stddef.h>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace basic_matrix {
@@ -156,6 +157,8 @@ public:
   /// that are to be modified in-place. The result of this constructor
   /// is not ok() and can be used to return failure.
   Matrix();
+  /// A contiguous copy of other's entries, with other's ok(), so a copy of
+  /// a failed result is a failure too.
   Matrix(const Matrix &other);
   Matrix(const size_t &width, const size_t &height);
 
@@ -171,6 +174,10 @@ public:
   size_t height() const;
   const double &operator()(const size_t &x, const size_t &y) const;
   double &operator()(const size_t &x, const size_t &y);
+  /// Copy the entries of mat. A matrix with its own storage takes mat's
+  /// size and ok(), so assigning a failed result keeps it failed. An ROI
+  /// must match mat's size, writes through to its source, and keeps its
+  /// own ok().
   Matrix &operator=(const Matrix &mat);
   Matrix transpose() const;
 
@@ -248,15 +255,31 @@ public:
   const Matrix dot(const Matrix &other) const;
 
   /// Return the inverse of a square matrix. Returns a matrix
-  /// that is not ok() if the matrix is singular.
+  /// that is not ok() if the matrix is singular to working precision,
+  /// i.e. rcond() is below machine epsilon.
   Matrix inverse() const;
 
+  /// Estimate of the reciprocal condition number of a square matrix in the
+  /// 1-norm, 1 / (||A||_1 * ||A^-1||_1), between 0 (singular) and 1. See
+  /// luRcond. Costs one LU factorization.
+  double rcond() const;
+
   void swapRows(const size_t i, const size_t j);
   void swapCols(const size_t i, const size_t j);
 
-  /// Matrix determinant
+  /// Matrix determinant, from an in-place LU factorization. Returns 0 for
+  /// an exactly singular matrix and 1 for a 0x0 one.
   double det() const;
 
+  /// log(|det()|), which does not overflow or underflow for large matrices
+  /// the way the determinant does. Returns -infinity for an exactly singular
+  /// matrix.
+  double logAbsDet() const;
+
+  /// The sign (1, -1, or 0 if singular) and logAbsDet() of the determinant,
+  /// from a single factorization: det() = sign * exp(log_abs_det).
+  std::pair<double, double> slogdet() const;
+
   /// Whether or not this matrix is valid. This method is
   /// is used to implement the optional return pattern
   /// for operations for which a result is not assured - for
@@ -301,6 +324,27 @@ void naiveMultiply(const Matrix &A, const Matrix &B, Matrix &C);
 /// Multiplication with CPU vectorization.
 void simdMultiply(const Matrix &A, const Matrix &B, Matrix &C);
 
+/// Symmetric rank-k update (SYRK). Computes
+/// C = alpha * A^T * A + beta * C  (transpose == true), or
+/// C = alpha * A * A^T + beta * C  (transpose == false).
+/// Only the upper triangle is computed, which halves the work compared to
+/// a general multiplication. If mirror is true, the lower triangle is then
+/// copied from the upper one; otherwise it is left untouched. If beta is 0,
+/// C is resized as needed and its previous contents are ignored.
+void symmetricRankKUpdate(const Matrix &A, Matrix &C,
+                          const bool &transpose = true,
+                          const double &alpha = 1.0, const double &beta = 0.0,
+                          const bool &mirror = true);
+
+/// symmetricRankKUpdate into packed storage: c holds the lower triangle of
+/// the n x n result row by row, row y being the y + 1 entries from
+/// y(y+1)/2, as in SymmetricMatrix. The blocks are written straight into
+/// the packed rows, so no n x n matrix is formed.
+void packedSymmetricRankKUpdate(const Matrix &A, double *c,
+                                const bool &transpose = true,
+                                const double &alpha = 1.0,
+                                const double &beta = 0.0);
+
 basic_matrix::Matrix operator*(const double &a, const basic_matrix::Matrix &b);
 basic_matrix::Matrix operator+(const double &a, const basic_matrix::Matrix &b);
 basic_matrix::Matrix operator-(const double &a, const basic_matrix::Matrix &b);
@@ -0,0 +1,210 @@
+#include "mixed_precision.hpp"
+#include "lup_decomposition.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <vector>
+
+namespace basic_matrix {
+namespace {
+/// luFactorize on a contiguous n x n float matrix.
+bool floatLUFactorize(std::vector<float> &a, const size_t &n,
+                      std::vector<size_t> &pivots) {
+  pivots.resize(n);
+  for (size_t k = 0; k < n; k++) {
+    size_t p = k;
+    for (size_t y = k + 1; y < n; y++) {
+      if (fabsf(a[y * n + k]) > fabsf(a[p * n + k])) {
+        p = y;
+      }
+    }
+    pivots[k] = p;
+    if (a[p * n + k] == 0.0f) {
+      return false;
+    }
+    if (p != k) {
+      std::swap_ranges(&a[k * n], &a[k * n] + n, &a[p * n]);
+    }
+    const float *pivot_row = &a[k * n];
+    size_t length = n - k - 1;
+    parallelFor(
+        k + 1, n,
+        [&](const size_t &y) {
+          float *row = &a[y * n];
+          float l = row[k] / pivot_row[k];
+          row[k] = l;
+          for (size_t x = k + 1; x < n; x++) {
+            row[x] -= l * pivot_row[x];
+          }
+        },
+        std::max<size_t>(1, 32768 / std::max<size_t>(length, 1)));
+  }
+  return true;
+}
+
+/// solveLU with float factors on a contiguous, row-major n x w float
+/// right-hand side.
+void floatSolveLU(const std::vector<float> &lu, const size_t &n,
+                  const std::vector<size_t> &pivots, std::vector<float> &x,
+                  const size_t &w) {
+  for (size_t y = 0; y < n; y++) {
+    if (pivots[y] != y) {
+      std::swap_ranges(&x[y * w], &x[y * w] + w, &x[pivots[y] * w]);
+    }
+  }
+  for (size_t y = 1; y < n; y++) {
+    for (size_t k = 0; k < y; k++) {
+      float l = lu[y * n + k];
+      for (size_t c = 0; c < w; c++) {
+        x[y * w + c] -= l * x[k * w + c];
+      }
+    }
+  }
+  for (size_t y = n; y-- > 0;) {
+    for (size_t k = y + 1; k < n; k++) {
+      float u = lu[y * n + k];
+      for (size_t c = 0; c < w; c++) {
+        x[y * w + c] -= u * x[k * w + c];
+      }
+    }
+    float d = lu[y * n + y];
+    for (size_t c = 0; c < w; c++) {
+      x[y * w + c] /= d;
+    }
+  }
+}
+
+/// The infinity norm of A, the largest sum of absolute values of a row.
+double normInf(const Matrix &A) {
+  double result = 0.0;
+  for (size_t y = 0; y < A.height(); y++) {
+    double sum = 0.0;
+    for (size_t x = 0; x < A.width(); x++) {
+      sum += fabs(A(x, y));
+    }
+    result = std::max(result, sum);
+  }
+  return result;
+}
+
+/// Whether every entry of A fits in a float without overflowing.
+bool fitsInFloat(const Matrix &A) {
+  for (size_t y = 0; y < A.height(); y++) {
+    for (size_t x = 0; x < A.width(); x++) {
+      if (!(fabs(A(x, y)) <= std::numeric_limits<float>::max())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Whether every column of r is small enough relative to the same column
+/// of x.
+bool refinementConverged(const Matrix &r, const Matrix &x,
+                         const double &threshold) {
+  for (size_t c = 0; c < x.width(); c++) {
+    double r_max = 0.0;
+    double x_max = 0.0;
+    for (size_t y = 0; y < x.height(); y++) {
+      r_max = std::max(r_max, fabs(r(c, y)));
+      x_max = std::max(x_max, fabs(x(c, y)));
+    }
+    if (!(r_max <= x_max * threshold)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Solve with a double factorization, as Matrix::inverse() does.
+bool solveDouble(const Matrix &A, Matrix &b) {
+  Matrix LU = A;
+  std::vector<size_t> pivots;
+  if (!luFactorize(LU, pivots) ||
+      luRcond(LU, pivots, norm1(A)) < std::numeric_limits<double>::epsilon()) {
+    return false;
+  }
+  solveLU(LU, pivots, b);
+  return true;
+}
+}; // namespace
+
+bool solveMixedPrecision(const Matrix &A, Matrix &b,
+                         MixedPrecisionResult *result,
+                         const MixedPrecisionOptions &options) {
+  if (A.width() != A.height() || b.height() != A.height()) {
+    throw std::runtime_error(
+        "Cannot solve a system with a " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) + " A and a " + std::to_string(b.width()) +
+        "x" + std::to_string(b.height()) + " b.");
+  }
+  MixedPrecisionResult local_result;
+  MixedPrecisionResult &info = result ? *result : local_result;
+  info = MixedPrecisionResult();
+  size_t n = A.height();
+  size_t w = b.width();
+  if (n == 0) {
+    return true;
+  }
+  std::vector<float> lu(n * n);
+  std::vector<size_t> pivots;
+  bool factored = fitsInFloat(A);
+  if (factored) {
+    for (size_t y = 0; y < n; y++) {
+      for (size_t x = 0; x < n; x++) {
+        lu[y * n + x] = float(A(x, y));
+      }
+    }
+    factored = floatLUFactorize(lu, n, pivots);
+  }
+  if (factored) {
+    double threshold =
+        normInf(A) * std::numeric_limits<double>::epsilon() * sqrt(double(n));
+    // The float solution, then corrections until the double residual is
+    // as small as a backward stable double solve would leave it.
+    std::vector<float> d(n * w);
+    Matrix x(w, n);
+    Matrix r = b;
+    for (size_t iteration = 0; iteration <= options.max_iterations;
+         iteration++) {
+      for (size_t y = 0; y < n; y++) {
+        for (size_t c = 0; c < w; c++) {
+          d[y * w + c] = float(r(c, y));
+        }
+      }
+      floatSolveLU(lu, n, pivots, d, w);
+      double *x_data = x.data();
+      for (size_t i = 0; i < n * w; i++) {
+        x_data[i] += d[i];
+      }
+      r = b - A * x;
+      info.iterations = iteration;
+      if (refinementConverged(r, x, threshold)) {
+        b = x;
+        return true;
+      }
+      if (!std::isfinite(r.norm())) {
+        break;
+      }
+    }
+  }
+  info.used_double = true;
+  return solveDouble(A, b);
+}
+
+Matrix inverseMixedPrecision(const Matrix &A,
+                             const MixedPrecisionOptions &options) {
+  if (A.width() != A.height()) {
+    throw std::runtime_error(
+        "Inverse only makes sense for square matrices; this matrix is " +
+        std::to_string(A.width()) + "x" + std::to_string(A.height()));
+  }
+  Matrix result = identity(A.width());
+  if (!solveMixedPrecision(A, result, nullptr, options)) {
+    return Matrix();
+  }
+  return result;
+}
+}; // namespace basic_matrix
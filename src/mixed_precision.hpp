@@ -0,0 +1,51 @@
+#pragma once
+#include "matrix.hpp"
+
+namespace basic_matrix {
+struct MixedPrecisionOptions {
+  /// Maximum number of refinement steps before giving up on the float
+  /// factorization and falling back to a double one.
+  size_t max_iterations = 30;
+};
+
+/// What solveMixedPrecision did.
+struct MixedPrecisionResult {
+  /// Number of refinement steps, each one residual in double and one solve
+  /// with the float factors.
+  size_t iterations = 0;
+
+  /// Whether refinement failed to converge, or A did not fit in a float,
+  /// so the system was solved with a double factorization instead.
+  bool used_double = false;
+};
+
+/// Solve A*x = b to double precision, doing the O(n^3) work in float.
+///
+/// A is rounded to float and factored with partial pivoting, which moves
+/// half as many bytes and fits twice as many entries in a SIMD register as
+/// luFactorize. The float solution is then improved by iterative
+/// refinement, as in LAPACK's xSGESV: the residual r = b - A*x is computed
+/// in double and the correction solved for with the float factors, O(n^2)
+/// per step. A column has converged once
+///   ||r||_inf <= ||x||_inf * ||A||_inf * eps * sqrt(n).
+/// This converges whenever A is comfortably better conditioned than
+/// 1 / float epsilon (about 10^7). Otherwise the system is solved with
+/// luFactorize and solveLU.
+///
+/// @in A - a square matrix.
+/// @in/out b - right-hand side of equation, which may have several columns.
+///             Output is stored here.
+/// @out result - if not null, how the solution was found.
+/// Returns false, leaving b unchanged, if A is singular to working
+/// precision, as for Matrix::inverse().
+bool solveMixedPrecision(
+    const Matrix &A, Matrix &b, MixedPrecisionResult *result = nullptr,
+    const MixedPrecisionOptions &options = MixedPrecisionOptions());
+
+/// Matrix::inverse() through solveMixedPrecision, with the identity as the
+/// right-hand side. Returns a matrix that is not ok() if A is singular to
+/// working precision.
+Matrix inverseMixedPrecision(
+    const Matrix &A,
+    const MixedPrecisionOptions &options = MixedPrecisionOptions());
+}; // namespace basic_matrix
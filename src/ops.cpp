@@ -1,4 +1,5 @@
 #include "matrix.hpp"
+#include "parallel.hpp"
 #include <iostream>
 #include <math.h>
 #include <random>
@@ -80,18 +81,26 @@ inline void naiveMatmul(const Matrix &M1, const Matrix &M2, Matrix &out, int m,
 inline void dot4x16(const Matrix &M1, const Matrix &M2, Matrix &out,
                     const int &u_offset, const int &v_offset, const int &j,
                     const int &block_width) {
+  // The operands are contiguous; index their storage directly rather than
+  // going through operator() in the inner loop.
+  const double *a = &M1(u_offset, v_offset);
+  size_t lda = M1.width();
+  const double *b = &M2(j, u_offset);
+  size_t ldb = M2.width();
+  double *c = &out(j, v_offset);
+  size_t ldc = out.width();
   // Storage for accumlation.
   float8 ctmp07[4] = {0.0};
   float8 ctmp815[4] = {0.0};
   for (int p = 0; p < block_width; p++) {
     // Broadcast 4 elements of matrix A into registers.
-    float8 a0p = broadcastFloat8(M1(p + u_offset, 0 + v_offset));
-    float8 a1p = broadcastFloat8(M1(p + u_offset, 1 + v_offset));
-    float8 a2p = broadcastFloat8(M1(p + u_offset, 2 + v_offset));
-    float8 a3p = broadcastFloat8(M1(p + u_offset, 3 + v_offset));
+    float8 a0p = broadcastFloat8(a[0 * lda + p]);
+    float8 a1p = broadcastFloat8(a[1 * lda + p]);
+    float8 a2p = broadcastFloat8(a[2 * lda + p]);
+    float8 a3p = broadcastFloat8(a[3 * lda + p]);
     // Load 2 blocks of 8 in a row.
-    float8 bp0p7 = loadUnalignedFloat8(&M2(0 + j, p + u_offset));
-    float8 bp8p15 = loadUnalignedFloat8(&M2(8 + j, p + u_offset));
+    float8 bp0p7 = loadUnalignedFloat8(&b[p * ldb]);
+    float8 bp8p15 = loadUnalignedFloat8(&b[p * ldb + 8]);
     // Multiply each broadcasted value by the two blocks and
     // accumulate the results.
     ctmp07[0] += a0p * bp0p7;
@@ -104,14 +113,10 @@ inline void dot4x16(const Matrix &M1, const Matrix &M2, Matrix &out,
     ctmp815[3] += a3p * bp8p15;
   }
   // Store the accumulated results for this column.
-  AdduFloat8(&out(0 + j, 0 + v_offset), ctmp07[0]);
-  AdduFloat8(&out(0 + j, 1 + v_offset), ctmp07[1]);
-  AdduFloat8(&out(0 + j, 2 + v_offset), ctmp07[2]);
-  AdduFloat8(&out(0 + j, 3 + v_offset), ctmp07[3]);
-  AdduFloat8(&out(8 + j, 0 + v_offset), ctmp815[0]);
-  AdduFloat8(&out(8 + j, 1 + v_offset), ctmp815[1]);
-  AdduFloat8(&out(8 + j, 2 + v_offset), ctmp815[2]);
-  AdduFloat8(&out(8 + j, 3 + v_offset), ctmp815[3]);
+  for (size_t r = 0; r < 4; r++) {
+    AdduFloat8(&c[r * ldc], ctmp07[r]);
+    AdduFloat8(&c[r * ldc + 8], ctmp815[r]);
+  }
 }
 
 /// Tiled matrix multiplication. Multiply 4x16 blocks until that becomes
@@ -151,6 +156,173 @@ inline void tiledMatrixMult(const Matrix &M1, const Matrix &M2, Matrix &out,
                 0 + u_offset, i + v_offset, j);
   }
 }
+
+/// Pack kc steps of the inner dimension of a symmetric rank-k update,
+/// starting at k0, into a contiguous kc x n panel. Row p of the panel holds
+/// the p-th inner element of every output row, so that both operands of the
+/// update can be streamed from the same contiguous row.
+inline void packSyrkPanel(const Matrix &A, const bool &transpose,
+                          const size_t &k0, const size_t &kc,
+                          std::vector<double> &panel) {
+  size_t n = transpose ? A.width() : A.height();
+  panel.resize(kc * n);
+  if (transpose) {
+    // A^T * A: the inner dimension runs along the rows of A.
+    for (size_t p = 0; p < kc; p++) {
+      for (size_t i = 0; i < n; i++) {
+        panel[p * n + i] = A(i, k0 + p);
+      }
+    }
+  } else {
+    // A * A^T: the inner dimension runs along the columns of A.
+    for (size_t i = 0; i < n; i++) {
+      for (size_t p = 0; p < kc; p++) {
+        panel[p * n + i] = A(k0 + p, i);
+      }
+    }
+  }
+}
+
+/// Where row r of the output of a symmetric rank-k update starts in c: at
+/// r * n for the upper triangle of a dense n x n matrix, or at r(r+1)/2
+/// for packed lower rows.
+template <bool kPacked>
+inline size_t syrkRowStart(const size_t &r, const size_t &n) {
+  return kPacked ? r * (r + 1) / 2 : r * n;
+}
+
+/// Compute a 4x16 block of a symmetric rank-k update from a packed panel.
+/// This is the same register blocking as dot4x16. Blocks that straddle
+/// the diagonal only write the elements of the triangle being computed.
+template <bool kPacked>
+inline void syrkDot4x16(const double *panel, const size_t &n,
+                        const size_t &kc, const size_t &i, const size_t &j,
+                        const double &alpha, double *c,
+                        const bool &on_diagonal) {
+  float8 ctmp07[4] = {0.0};
+  float8 ctmp815[4] = {0.0};
+  for (size_t p = 0; p < kc; p++) {
+    const double *row = panel + p * n;
+    float8 a0p = broadcastFloat8(row[i + 0]);
+    float8 a1p = broadcastFloat8(row[i + 1]);
+    float8 a2p = broadcastFloat8(row[i + 2]);
+    float8 a3p = broadcastFloat8(row[i + 3]);
+    float8 bp0p7 = loadUnalignedFloat8(row + j);
+    float8 bp8p15 = loadUnalignedFloat8(row + j + 8);
+    ctmp07[0] += a0p * bp0p7;
+    ctmp07[1] += a1p * bp0p7;
+    ctmp07[2] += a2p * bp0p7;
+    ctmp07[3] += a3p * bp0p7;
+    ctmp815[0] += a0p * bp8p15;
+    ctmp815[1] += a1p * bp8p15;
+    ctmp815[2] += a2p * bp8p15;
+    ctmp815[3] += a3p * bp8p15;
+  }
+  float8 alpha8 = broadcastFloat8(alpha);
+  if (!on_diagonal) {
+    for (size_t r = 0; r < 4; r++) {
+      double *c_row = c + syrkRowStart<kPacked>(i + r, n);
+      AdduFloat8(c_row + j, alpha8 * ctmp07[r]);
+      AdduFloat8(c_row + j + 8, alpha8 * ctmp815[r]);
+    }
+    return;
+  }
+  double tmp[4][16];
+  for (size_t r = 0; r < 4; r++) {
+    storeUnalignedFloat8(&tmp[r][0], alpha8 * ctmp07[r]);
+    storeUnalignedFloat8(&tmp[r][8], alpha8 * ctmp815[r]);
+  }
+  for (size_t r = 0; r < 4; r++) {
+    double *c_row = c + syrkRowStart<kPacked>(i + r, n);
+    for (size_t col = 0; col < 16; col++) {
+      if (kPacked ? j + col <= i + r : j + col >= i + r) {
+        c_row[j + col] += tmp[r][col];
+      }
+    }
+  }
+}
+
+/// Accumulate alpha * panel^T * panel into columns [col_begin, col_end) of
+/// output row r.
+template <bool kPacked>
+inline void syrkNaiveRow(const double *panel, const size_t &n,
+                         const size_t &kc, const size_t &r,
+                         const size_t &col_begin, const size_t &col_end,
+                         const double &alpha, double *c) {
+  double *c_row = c + syrkRowStart<kPacked>(r, n);
+  for (size_t p = 0; p < kc; p++) {
+    const double *row = panel + p * n;
+    double a = alpha * row[r];
+    for (size_t col = col_begin; col < col_end; col++) {
+      c_row[col] += a * row[col];
+    }
+  }
+}
+
+/// Tiled triangular update from a packed panel: the upper triangle of a
+/// contiguous n x n matrix, or packed lower rows, which are the same
+/// entries. Multiply 4x16 blocks along each block row up to (packed) or
+/// from (dense) the diagonal, and finish the edges conventionally.
+template <bool kPacked>
+inline void tiledSyrk(const double *panel, const size_t &n, const size_t &kc,
+                      const double &alpha, double *c) {
+  constexpr size_t tile_height = 4;
+  constexpr size_t tile_width = 16;
+  size_t i = 0;
+  for (; i + tile_height <= n; i += tile_height) {
+    if (kPacked) {
+      // The last row of the block ends at column i + 3.
+      size_t j = 0;
+      for (; j + tile_width <= i + tile_height; j += tile_width) {
+        syrkDot4x16<kPacked>(panel, n, kc, i, j, alpha, c,
+                             j + tile_width > i + 1);
+      }
+      for (size_t r = i; r < i + tile_height; r++) {
+        syrkNaiveRow<kPacked>(panel, n, kc, r, j, r + 1, alpha, c);
+      }
+    } else {
+      size_t j = i;
+      for (; j + tile_width <= n; j += tile_width) {
+        syrkDot4x16<kPacked>(panel, n, kc, i, j, alpha, c, j == i);
+      }
+      for (size_t r = i; r < i + tile_height; r++) {
+        // Without a full tile, the diagonal block is also done here.
+        syrkNaiveRow<kPacked>(panel, n, kc, r, std::max(j, r), n, alpha, c);
+      }
+    }
+  }
+  for (; i < n; i++) {
+    if (kPacked) {
+      syrkNaiveRow<kPacked>(panel, n, kc, i, 0, i + 1, alpha, c);
+    } else {
+      syrkNaiveRow<kPacked>(panel, n, kc, i, i, n, alpha, c);
+    }
+  }
+}
+
+/// Accumulate alpha * A^T * A or alpha * A * A^T into the triangle c, in
+/// kc-deep panels. Rows of a contiguous A are already the panel of A^T * A
+/// and are read in place.
+template <bool kPacked>
+void syrkPanels(const Matrix &A, const bool &transpose, const double &alpha,
+                double *c) {
+  size_t n = transpose ? A.width() : A.height();
+  size_t k = transpose ? A.height() : A.width();
+  // Same inner-dimension blocking as simdMultiply.
+  constexpr size_t kc = 128;
+  std::vector<double> panel;
+  for (size_t p = 0; p < k; p += kc) {
+    size_t block_width = std::min(k - p, kc);
+    const double *panel_data;
+    if (transpose && A.contiguous()) {
+      panel_data = A.data() + p * n;
+    } else {
+      packSyrkPanel(A, transpose, p, block_width, panel);
+      panel_data = panel.data();
+    }
+    tiledSyrk<kPacked>(panel_data, n, block_width, alpha, c);
+  }
+}
 }; // namespace
 
 void naiveMultiply(const Matrix &A, const Matrix &B, Matrix &C) {
@@ -174,14 +346,83 @@ void simdMultiply(const Matrix &M1, const Matrix &M2, Matrix &out) {
   // from the cache.
   constexpr size_t mc = 256;
   constexpr size_t kc = 128;
+  // Row blocks of the output are independent, so they are spread over
+  // threads, but only when there is enough work to pay for starting them.
+  constexpr double kMinParallelFlops = 1 << 24;
+  size_t num_blocks = (out.height() + mc - 1) / mc;
+  double flops = 2.0 * out.height() * out.width() * M1.width();
+  size_t min_chunk = flops >= kMinParallelFlops ? 1 : num_blocks;
   for (size_t p = 0; p < M1.width(); p += kc) {
     // full size if there's room left, otherwise the remaining width.
     int block_width = std::min(M1.width() - p, kc);
-    for (size_t i = 0; i < out.height(); i += mc) {
-      int block_height = std::min(out.height() - i, mc);
-      tiledMatrixMult(M1, M2, out, p, block_width, i, block_height);
+    parallelFor(
+        0, num_blocks,
+        [&](const size_t &block) {
+          size_t i = block * mc;
+          int block_height = std::min(out.height() - i, mc);
+          tiledMatrixMult(M1, M2, out, p, block_width, i, block_height);
+        },
+        std::max<size_t>(min_chunk, 1));
+  }
+}
+
+void symmetricRankKUpdate(const Matrix &A, Matrix &C, const bool &transpose,
+                          const double &alpha, const double &beta,
+                          const bool &mirror) {
+  size_t n = transpose ? A.width() : A.height();
+  if (!C.contiguous()) {
+    // The kernel writes through the raw storage; work on a copy and write
+    // the result back through the mapping.
+    Matrix C_contiguous = (beta == 0.0) ? Matrix(n, n) : Matrix(C);
+    symmetricRankKUpdate(A, C_contiguous, transpose, alpha, beta, mirror);
+    C = C_contiguous;
+    return;
+  }
+  if (beta == 0.0) {
+    if (C.width() != n || C.height() != n) {
+      C = Matrix(n, n);
+    }
+  } else if (C.width() != n || C.height() != n) {
+    throw std::runtime_error(
+        "Tried to accumulate a " + std::to_string(n) + "x" +
+        std::to_string(n) + " symmetric rank-k update into a " +
+        std::to_string(C.width()) + "x" + std::to_string(C.height()) +
+        " matrix; C must be square and match the update.");
+  }
+  if (n == 0) {
+    return;
+  }
+  double *c = C.data();
+  // Scale the upper triangle by beta. A beta of zero overwrites C, even
+  // if it contains NaN or Inf.
+  if (beta != 1.0) {
+    for (size_t r = 0; r < n; r++) {
+      for (size_t col = r; col < n; col++) {
+        c[r * n + col] = (beta == 0.0) ? 0.0 : beta * c[r * n + col];
+      }
+    }
+  }
+  syrkPanels<false>(A, transpose, alpha, c);
+  if (mirror) {
+    for (size_t r = 1; r < n; r++) {
+      for (size_t col = 0; col < r; col++) {
+        c[r * n + col] = c[col * n + r];
+      }
+    }
+  }
+}
+
+void packedSymmetricRankKUpdate(const Matrix &A, double *c,
+                                const bool &transpose, const double &alpha,
+                                const double &beta) {
+  size_t n = transpose ? A.width() : A.height();
+  size_t size = n * (n + 1) / 2;
+  if (beta != 1.0) {
+    for (size_t i = 0; i < size; i++) {
+      c[i] = (beta == 0.0) ? 0.0 : beta * c[i];
     }
   }
+  syrkPanels<true>(A, transpose, alpha, c);
 }
 
 Matrix Matrix::transpose() const {
@@ -270,6 +511,7 @@ Matrix &Matrix::operator=(const Matrix &mat) {
       m_height = mat.height();
       m_storage.resize(m_width * m_height);
     }
+    m_ok = mat.ok();
   }
   for (size_t y = 0; y < mat.height(); y++) {
     for (size_t x = 0; x < mat.width(); x++) {
@@ -452,7 +694,7 @@ void Matrix::swapCols(const size_t i, const size_t j) {
     throw std::out_of_range("Required " + std::to_string(j) + "<" +
                             std::to_string(width()));
   }
-  for (size_t y = 0; y < width(); y++) {
+  for (size_t y = 0; y < height(); y++) {
     double temp = operator()(i, y);
     operator()(i, y) = operator()(j, y);
     operator()(j, y) = temp;
@@ -1,30 +1,55 @@
 #include "optimization_problem.hpp"
+#include "kernel_helpers.hpp"
 #include <iostream>
 
 namespace basic_matrix {
 
 void estimateJacobian(const OptimizationProblem &problem, Matrix &J,
                       const double epsilon) {
+  std::vector<Matrix> samples;
+  sampleColumns(problem.inputs.X, samples);
+  Matrix theta_perturbed;
+  Matrix y_i;
+  estimateJacobian(problem, samples, J, theta_perturbed, y_i, epsilon);
+}
+
+void estimateJacobian(const OptimizationProblem &problem,
+                      const std::vector<Matrix> &samples, Matrix &J,
+                      Matrix &theta_perturbed, Matrix &y_i,
+                      const double epsilon) {
   // #/outputs of the function
   size_t width = problem.inputs.num_params;
   size_t height = problem.inputs.y.height();
-  if (J.width() != width || J.height() != height) {
-    J = Matrix(width, height);
+  resizeIfNeeded(J, width, height);
+  const Matrix &theta = problem.outputs.theta;
+  resizeIfNeeded(theta_perturbed, theta.width(), theta.height());
+  for (size_t y = 0; y < theta.height(); y++) {
+    theta_perturbed(0, y) = theta(0, y);
   }
-  Matrix y0(1, problem.inputs.y.height());
-  Matrix y1(1, problem.inputs.y.height());
+  resizeIfNeeded(y_i, 1, 1);
   // TODO: implement this for vector evaluator. The unchecked
   // value() here is not safe.
-  for (size_t x_i = 0; x_i < problem.outputs.theta.height(); x_i++) {
-    for (size_t y_i = 0; y_i < problem.inputs.X.height(); y_i++) {
-      Matrix theta_perturbed = problem.outputs.theta;
-      theta_perturbed(0, x_i) -= epsilon;
-      problem.inputs.function.value()(
-          theta_perturbed, problem.inputs.X.row(y_i).transposeROI(), y0);
-      theta_perturbed(0, x_i) += 2 * epsilon;
-      problem.inputs.function.value()(
-          theta_perturbed, problem.inputs.X.row(y_i).transposeROI(), y1);
-      J(x_i, y_i) = (y1(0, 0) - y0(0, 0)) / (2.0 * epsilon);
+  const auto &function = problem.inputs.function.value();
+  for (size_t y = 0; y < samples.size(); y++) {
+    for (size_t x = 0; x < theta.height(); x++) {
+      theta_perturbed(0, x) = theta(0, x) - epsilon;
+      function(theta_perturbed, samples[y], y_i);
+      double y0 = y_i(0, 0);
+      theta_perturbed(0, x) = theta(0, x) + epsilon;
+      function(theta_perturbed, samples[y], y_i);
+      double y1 = y_i(0, 0);
+      theta_perturbed(0, x) = theta(0, x);
+      J(x, y) = (y1 - y0) / (2.0 * epsilon);
+    }
+  }
+}
+
+void sampleColumns(const Matrix &X, std::vector<Matrix> &samples) {
+  samples.resize(X.height());
+  for (size_t y = 0; y < X.height(); y++) {
+    resizeIfNeeded(samples[y], 1, X.width());
+    for (size_t x = 0; x < X.width(); x++) {
+      samples[y](0, x) = X(x, y);
     }
   }
 }
@@ -43,4 +68,17 @@ evaluate(const std::function<void(const Matrix &, const Matrix &, Matrix &)>
   }
   return y;
 }
+
+void evaluate(
+    const std::function<void(const Matrix &, const Matrix &, Matrix &)>
+        &function,
+    const Matrix &theta, const std::vector<Matrix> &samples, Matrix &y,
+    Matrix &y_i) {
+  resizeIfNeeded(y, 1, samples.size());
+  resizeIfNeeded(y_i, 1, 1);
+  for (size_t i = 0; i < samples.size(); i++) {
+    function(theta, samples[i], y_i);
+    y(0, i) = y_i(0, 0);
+  }
+}
 }; // namespace basic_matrix
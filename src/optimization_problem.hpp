@@ -3,6 +3,7 @@
 #include "matrix.hpp"
 #include <functional>
 #include <optional>
+#include <vector>
 
 namespace basic_matrix {
 /// A nonlinear least squares problem.
@@ -111,9 +112,32 @@ struct OptimizationProblem {
 void estimateJacobian(const OptimizationProblem &problem, Matrix &J,
                       const double epsilon = 1e-7);
 
+/// estimateJacobian for callers that estimate it over and over, e.g. once
+/// per iteration, without allocating: J and the scratch matrices
+/// theta_perturbed and y_i are reused when they already have the right
+/// size.
+/// @in samples - the rows of problem.inputs.X, from sampleColumns.
+void estimateJacobian(const OptimizationProblem &problem,
+                      const std::vector<Matrix> &samples, Matrix &J,
+                      Matrix &theta_perturbed, Matrix &y_i,
+                      const double epsilon = 1e-7);
+
+/// The rows of X as the column vectors that the model functions take, each
+/// copied once instead of wrapped in a new ROI per call. The matrices
+/// already in samples are reused when they have the right size.
+void sampleColumns(const Matrix &X, std::vector<Matrix> &samples);
+
 /// Calculate y
 Matrix
 evaluate(const std::function<void(const Matrix &, const Matrix &, Matrix &)>
              function,
          const Matrix &theta, const Matrix X);
+
+/// Calculate y in place, from the rows of X given by sampleColumns. y and
+/// the 1x1 scratch y_i are reused when they already have the right size.
+void evaluate(
+    const std::function<void(const Matrix &, const Matrix &, Matrix &)>
+        &function,
+    const Matrix &theta, const std::vector<Matrix> &samples, Matrix &y,
+    Matrix &y_i);
 }; // namespace basic_matrix
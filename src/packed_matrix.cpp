@@ -0,0 +1,393 @@
+#include "packed_matrix.hpp"
+#include "kernel_helpers.hpp"
+#include "parallel.hpp"
+#include "tile_factorization.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+/// The size from which choleskyFactorize uses tileCholeskyFactorize, if
+/// there is more than one thread.
+const size_t kTileCholeskyMinSize = 512;
+
+size_t checkSquare(const Matrix &dense, const std::string &type) {
+  if (dense.width() != dense.height()) {
+    throw std::runtime_error("A " + type + " matrix must be square, but got " +
+                             std::to_string(dense.width()) + "x" +
+                             std::to_string(dense.height()));
+  }
+  return dense.width();
+}
+
+void checkHeight(const size_t &n, const Matrix &b) {
+  if (b.height() != n) {
+    throw std::runtime_error("Cannot use a " + std::to_string(b.width()) +
+                             "x" + std::to_string(b.height()) +
+                             " matrix with a " + std::to_string(n) + "x" +
+                             std::to_string(n) + " packed matrix.");
+  }
+}
+
+/// out += a * in, over k entries.
+inline void axpy(const double &a, const double *in, double *out,
+                 const size_t &k) {
+  for (size_t c = 0; c < k; c++) {
+    out[c] += a * in[c];
+  }
+}
+
+/// The offset of row y of a packed lower triangle.
+inline size_t lowerOffset(const size_t &y) { return y * (y + 1) / 2; }
+}; // namespace
+
+LowerTriangular::LowerTriangular() : LowerTriangular(size_t(0)) {}
+
+LowerTriangular::LowerTriangular(const size_t &n)
+    : m_n(n), m_packed(n * (n + 1) / 2, 0.0) {}
+
+LowerTriangular::LowerTriangular(const Matrix &dense)
+    : LowerTriangular(checkSquare(dense, "lower-triangular")) {
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = 0; x <= y; x++) {
+      m_packed[lowerOffset(y) + x] = dense(x, y);
+    }
+  }
+}
+
+size_t LowerTriangular::size() const { return m_n; }
+
+double LowerTriangular::operator()(const size_t &x, const size_t &y) const {
+  if (x >= m_n || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_n) + "x" + std::to_string(m_n) +
+                            " matrix.");
+  }
+  return x <= y ? m_packed[lowerOffset(y) + x] : 0.0;
+}
+
+double &LowerTriangular::operator()(const size_t &x, const size_t &y) {
+  if (x > y || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) +
+                            ") is outside the lower triangle.");
+  }
+  return m_packed[lowerOffset(y) + x];
+}
+
+const std::vector<double> &LowerTriangular::packed() const {
+  return m_packed;
+}
+
+double *LowerTriangular::data() { return m_packed.data(); }
+
+Matrix LowerTriangular::toDense() const {
+  Matrix result(m_n, m_n);
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = 0; x <= y; x++) {
+      result(x, y) = m_packed[lowerOffset(y) + x];
+    }
+  }
+  return result;
+}
+
+const Matrix LowerTriangular::operator*(const Matrix &dense_in) const {
+  checkHeight(m_n, dense_in);
+  Matrix dense = dense_in;
+  size_t k = dense.width();
+  Matrix result(k, m_n);
+  const double *b = dense.data();
+  double *c = result.data();
+  parallelFor(
+      0, m_n,
+      [&](const size_t &y) {
+        const double *row = &m_packed[lowerOffset(y)];
+        for (size_t x = 0; x <= y; x++) {
+          axpy(row[x], &b[x * k], &c[y * k], k);
+        }
+      },
+      indicesPerChunk(m_n, m_packed.size() * k));
+  return result;
+}
+
+void LowerTriangular::solve(Matrix &b_in, const bool &unit_diagonal) const {
+  checkHeight(m_n, b_in);
+  onContiguous(b_in, [&](Matrix &b_matrix) {
+    double *b = b_matrix.data();
+    size_t k = b_matrix.width();
+    for (size_t y = 0; y < m_n; y++) {
+      const double *row = &m_packed[lowerOffset(y)];
+      double *b_y = &b[y * k];
+      for (size_t x = 0; x < y; x++) {
+        axpy(-row[x], &b[x * k], b_y, k);
+      }
+      if (!unit_diagonal) {
+        for (size_t c = 0; c < k; c++) {
+          b_y[c] /= row[y];
+        }
+      }
+    }
+  });
+}
+
+void LowerTriangular::solveTransposed(Matrix &b_in,
+                                      const bool &unit_diagonal) const {
+  checkHeight(m_n, b_in);
+  onContiguous(b_in, [&](Matrix &b_matrix) {
+    double *b = b_matrix.data();
+    size_t k = b_matrix.width();
+    // Row y of L is column y of L^T: once x_y is known, it is eliminated
+    // from the rows above.
+    for (size_t y = m_n; y-- > 0;) {
+      const double *row = &m_packed[lowerOffset(y)];
+      double *b_y = &b[y * k];
+      if (!unit_diagonal) {
+        for (size_t c = 0; c < k; c++) {
+          b_y[c] /= row[y];
+        }
+      }
+      for (size_t x = 0; x < y; x++) {
+        axpy(-row[x], b_y, &b[x * k], k);
+      }
+    }
+  });
+}
+
+UpperTriangular::UpperTriangular() : UpperTriangular(size_t(0)) {}
+
+UpperTriangular::UpperTriangular(const size_t &n)
+    : m_n(n), m_packed(n * (n + 1) / 2, 0.0) {}
+
+UpperTriangular::UpperTriangular(const Matrix &dense)
+    : UpperTriangular(checkSquare(dense, "upper-triangular")) {
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = y; x < m_n; x++) {
+      m_packed[offset(y) + x - y] = dense(x, y);
+    }
+  }
+}
+
+size_t UpperTriangular::offset(const size_t &y) const {
+  return y * m_n - y * (y - 1) / 2;
+}
+
+size_t UpperTriangular::size() const { return m_n; }
+
+double UpperTriangular::operator()(const size_t &x, const size_t &y) const {
+  if (x >= m_n || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_n) + "x" + std::to_string(m_n) +
+                            " matrix.");
+  }
+  return x >= y ? m_packed[offset(y) + x - y] : 0.0;
+}
+
+double &UpperTriangular::operator()(const size_t &x, const size_t &y) {
+  if (x < y || x >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) +
+                            ") is outside the upper triangle.");
+  }
+  return m_packed[offset(y) + x - y];
+}
+
+const std::vector<double> &UpperTriangular::packed() const {
+  return m_packed;
+}
+
+double *UpperTriangular::data() { return m_packed.data(); }
+
+Matrix UpperTriangular::toDense() const {
+  Matrix result(m_n, m_n);
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = y; x < m_n; x++) {
+      result(x, y) = m_packed[offset(y) + x - y];
+    }
+  }
+  return result;
+}
+
+const Matrix UpperTriangular::operator*(const Matrix &dense_in) const {
+  checkHeight(m_n, dense_in);
+  Matrix dense = dense_in;
+  size_t k = dense.width();
+  Matrix result(k, m_n);
+  const double *b = dense.data();
+  double *c = result.data();
+  parallelFor(
+      0, m_n,
+      [&](const size_t &y) {
+        const double *row = &m_packed[offset(y)];
+        for (size_t x = y; x < m_n; x++) {
+          axpy(row[x - y], &b[x * k], &c[y * k], k);
+        }
+      },
+      indicesPerChunk(m_n, m_packed.size() * k));
+  return result;
+}
+
+void UpperTriangular::solve(Matrix &b_in) const {
+  checkHeight(m_n, b_in);
+  onContiguous(b_in, [&](Matrix &b_matrix) {
+    double *b = b_matrix.data();
+    size_t k = b_matrix.width();
+    for (size_t y = m_n; y-- > 0;) {
+      const double *row = &m_packed[offset(y)];
+      double *b_y = &b[y * k];
+      for (size_t x = y + 1; x < m_n; x++) {
+        axpy(-row[x - y], &b[x * k], b_y, k);
+      }
+      for (size_t c = 0; c < k; c++) {
+        b_y[c] /= row[0];
+      }
+    }
+  });
+}
+
+SymmetricMatrix::SymmetricMatrix() : SymmetricMatrix(size_t(0)) {}
+
+SymmetricMatrix::SymmetricMatrix(const size_t &n)
+    : m_n(n), m_packed(n * (n + 1) / 2, 0.0) {}
+
+SymmetricMatrix::SymmetricMatrix(const Matrix &dense)
+    : SymmetricMatrix(checkSquare(dense, "symmetric")) {
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = 0; x <= y; x++) {
+      m_packed[lowerOffset(y) + x] = dense(x, y);
+    }
+  }
+}
+
+size_t SymmetricMatrix::size() const { return m_n; }
+
+double SymmetricMatrix::operator()(const size_t &x, const size_t &y) const {
+  if (x >= m_n || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_n) + "x" + std::to_string(m_n) +
+                            " matrix.");
+  }
+  return x <= y ? m_packed[lowerOffset(y) + x] : m_packed[lowerOffset(x) + y];
+}
+
+double &SymmetricMatrix::operator()(const size_t &x, const size_t &y) {
+  if (x >= m_n || y >= m_n) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_n) + "x" + std::to_string(m_n) +
+                            " matrix.");
+  }
+  return x <= y ? m_packed[lowerOffset(y) + x] : m_packed[lowerOffset(x) + y];
+}
+
+const std::vector<double> &SymmetricMatrix::packed() const {
+  return m_packed;
+}
+
+double *SymmetricMatrix::data() { return m_packed.data(); }
+
+Matrix SymmetricMatrix::toDense() const {
+  Matrix result(m_n, m_n);
+  for (size_t y = 0; y < m_n; y++) {
+    for (size_t x = 0; x <= y; x++) {
+      result(x, y) = m_packed[lowerOffset(y) + x];
+      result(y, x) = m_packed[lowerOffset(y) + x];
+    }
+  }
+  return result;
+}
+
+const Matrix SymmetricMatrix::operator*(const Matrix &dense_in) const {
+  checkHeight(m_n, dense_in);
+  Matrix dense = dense_in;
+  size_t k = dense.width();
+  Matrix result(k, m_n);
+  const double *b = dense.data();
+  double *c = result.data();
+  // S(x, y) for x < y contributes to rows y and x of the result.
+  for (size_t y = 0; y < m_n; y++) {
+    const double *row = &m_packed[lowerOffset(y)];
+    for (size_t x = 0; x < y; x++) {
+      axpy(row[x], &b[x * k], &c[y * k], k);
+      axpy(row[x], &b[y * k], &c[x * k], k);
+    }
+    axpy(row[y], &b[y * k], &c[y * k], k);
+  }
+  return result;
+}
+
+SymmetricMatrix gramMatrix(const Matrix &A) {
+  SymmetricMatrix result;
+  gramMatrix(A, result);
+  return result;
+}
+
+void gramMatrix(const Matrix &A, SymmetricMatrix &result) {
+  size_t n = A.width();
+  if (result.size() != n) {
+    result = SymmetricMatrix(n);
+  }
+  packedSymmetricRankKUpdate(A, result.data());
+}
+
+bool choleskyFactorize(const SymmetricMatrix &A, LowerTriangular &L) {
+  size_t n = A.size();
+  // Every entry of L is written below, so its storage needs no clearing.
+  if (L.size() != n) {
+    L = LowerTriangular(n);
+  }
+  if (n >= kTileCholeskyMinSize && numThreads() > 1) {
+    // The task graph factors the packed rows of L in place.
+    std::copy(A.packed().begin(), A.packed().end(), L.data());
+    return tileCholeskyFactorize(L);
+  }
+  if (n == 0) {
+    return true;
+  }
+  const double *a = A.packed().data();
+  double *l = L.data();
+  // Row by row: L(x, y) is A(x, y) minus the dot product of the first x
+  // entries of rows x and y of L, both contiguous.
+  for (size_t y = 0; y < n; y++) {
+    double *l_y = &l[lowerOffset(y)];
+    for (size_t x = 0; x <= y; x++) {
+      const double *l_x = &l[lowerOffset(x)];
+      double sum = a[lowerOffset(y) + x];
+      for (size_t j = 0; j < x; j++) {
+        sum -= l_y[j] * l_x[j];
+      }
+      if (x == y) {
+        if (!(sum > 0.0)) {
+          return false;
+        }
+        l_y[y] = sqrt(sum);
+      } else {
+        l_y[x] = sum / l_x[x];
+      }
+    }
+  }
+  return true;
+}
+
+void solveCholesky(const LowerTriangular &L, Matrix &b) {
+  L.solve(b);
+  L.solveTransposed(b);
+}
+
+void unpackLU(const Matrix &LU, LowerTriangular &L, UpperTriangular &U) {
+  size_t n = checkSquare(LU, "LU");
+  L = LowerTriangular(n);
+  U = UpperTriangular(n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < y; x++) {
+      L(x, y) = LU(x, y);
+    }
+    L(y, y) = 1.0;
+    for (size_t x = y; x < n; x++) {
+      U(x, y) = LU(x, y);
+    }
+  }
+}
+}; // namespace basic_matrix
@@ -0,0 +1,155 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// A square n x n lower-triangular matrix in packed storage: the n(n+1)/2
+/// entries on and below the diagonal, row by row, so that row y is the
+/// contiguous span of y + 1 entries starting at y(y+1)/2.
+class LowerTriangular {
+public:
+  /// A 0x0 matrix.
+  LowerTriangular();
+
+  /// An n x n matrix of zeros.
+  explicit LowerTriangular(const size_t &n);
+
+  /// The lower triangle, including the diagonal, of the square matrix
+  /// dense. Entries above the diagonal are ignored.
+  explicit LowerTriangular(const Matrix &dense);
+
+  size_t size() const;
+
+  /// The entry at column x and row y; 0 above the diagonal.
+  double operator()(const size_t &x, const size_t &y) const;
+
+  /// The entry at column x and row y. Throws std::out_of_range above the
+  /// diagonal.
+  double &operator()(const size_t &x, const size_t &y);
+
+  /// The packed entries, as described above.
+  const std::vector<double> &packed() const;
+  double *data();
+
+  Matrix toDense() const;
+
+  /// Triangular times dense, n(n+1) flops per column of dense instead of
+  /// 2n^2. Rows of the result are computed in parallel.
+  const Matrix operator*(const Matrix &dense) const;
+
+  /// Solve L*x = b by forward substitution, for each column of b. If
+  /// unit_diagonal is true, the diagonal is taken to be 1 and is not read,
+  /// as for the L of an LU factorization.
+  void solve(Matrix &b, const bool &unit_diagonal = false) const;
+
+  /// Solve L^T*x = b by back substitution, for each column of b, without
+  /// forming L^T.
+  void solveTransposed(Matrix &b, const bool &unit_diagonal = false) const;
+
+private:
+  size_t m_n;
+  std::vector<double> m_packed;
+};
+
+/// A square n x n upper-triangular matrix in packed storage: the n(n+1)/2
+/// entries on and above the diagonal, row by row, so that row y is the
+/// contiguous span of n - y entries starting at its diagonal.
+class UpperTriangular {
+public:
+  /// A 0x0 matrix.
+  UpperTriangular();
+
+  /// An n x n matrix of zeros.
+  explicit UpperTriangular(const size_t &n);
+
+  /// The upper triangle, including the diagonal, of the square matrix
+  /// dense. Entries below the diagonal are ignored. For the R of a tall
+  /// QR factorization, pass its leading square block, e.g. from a thin
+  /// qrFactorize.
+  explicit UpperTriangular(const Matrix &dense);
+
+  size_t size() const;
+
+  /// The entry at column x and row y; 0 below the diagonal.
+  double operator()(const size_t &x, const size_t &y) const;
+
+  /// The entry at column x and row y. Throws std::out_of_range below the
+  /// diagonal.
+  double &operator()(const size_t &x, const size_t &y);
+
+  /// The packed entries, as described above.
+  const std::vector<double> &packed() const;
+  double *data();
+
+  Matrix toDense() const;
+
+  /// Triangular times dense, n(n+1) flops per column of dense instead of
+  /// 2n^2. Rows of the result are computed in parallel.
+  const Matrix operator*(const Matrix &dense) const;
+
+  /// Solve U*x = b by back substitution, for each column of b.
+  void solve(Matrix &b) const;
+
+private:
+  size_t offset(const size_t &y) const;
+
+  size_t m_n;
+  std::vector<double> m_packed;
+};
+
+/// A symmetric n x n matrix that only stores its lower triangle, packed as
+/// in LowerTriangular. (x, y) and (y, x) refer to the same entry.
+class SymmetricMatrix {
+public:
+  /// A 0x0 matrix.
+  SymmetricMatrix();
+
+  /// An n x n matrix of zeros.
+  explicit SymmetricMatrix(const size_t &n);
+
+  /// The symmetric matrix with the lower triangle of the square matrix
+  /// dense. Entries above the diagonal are ignored.
+  explicit SymmetricMatrix(const Matrix &dense);
+
+  size_t size() const;
+  double operator()(const size_t &x, const size_t &y) const;
+  double &operator()(const size_t &x, const size_t &y);
+
+  /// The packed lower triangle.
+  const std::vector<double> &packed() const;
+  double *data();
+
+  Matrix toDense() const;
+
+  /// Symmetric times dense. Each stored entry is read once per column of
+  /// dense and used for both of the entries it stands for.
+  const Matrix operator*(const Matrix &dense) const;
+
+private:
+  size_t m_n;
+  std::vector<double> m_packed;
+};
+
+/// A^T * A in packed storage, computed with packedSymmetricRankKUpdate in
+/// half the flops of a general product and without a dense n x n matrix.
+SymmetricMatrix gramMatrix(const Matrix &A);
+
+/// gramMatrix into result. Its storage is reused if it already has the
+/// right size, so nothing is allocated then.
+void gramMatrix(const Matrix &A, SymmetricMatrix &result);
+
+/// Cholesky factorization, A = L * L^T, of a symmetric positive definite
+/// matrix, in n^3/3 flops. Large matrices are factored with
+/// tileCholeskyFactorize when there is more than one thread. The storage
+/// of L is reused if it already has the right size.
+/// Returns false if A is not positive definite.
+bool choleskyFactorize(const SymmetricMatrix &A, LowerTriangular &L);
+
+/// Solve A*x = b using the output of choleskyFactorize, with a forward and a
+/// back substitution per column of b.
+void solveCholesky(const LowerTriangular &L, Matrix &b);
+
+/// The L and U of the output of luFactorize, in packed storage. L has a
+/// unit diagonal, which is stored.
+void unpackLU(const Matrix &LU, LowerTriangular &L, UpperTriangular &U);
+}; // namespace basic_matrix
@@ -0,0 +1,318 @@
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace basic_matrix {
+namespace {
+std::atomic<size_t> g_num_threads(0);
+
+/// Ready tasks, by id.
+struct TaskQueue {
+  std::mutex mutex;
+  std::deque<size_t> tasks;
+
+  void push(const size_t &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(task);
+  }
+
+  /// The newest task if newest is true, else the oldest one.
+  bool pop(size_t &task, const bool &newest) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) {
+      return false;
+    }
+    if (newest) {
+      task = tasks.back();
+      tasks.pop_back();
+    } else {
+      task = tasks.front();
+      tasks.pop_front();
+    }
+    return true;
+  }
+};
+
+/// One parallelFor call, split into num_chunks chunks. Everything but the
+/// constant fields is guarded by the mutex of the pool running it.
+struct ParallelJob {
+  const std::function<void(const size_t &)> &fn;
+  size_t begin;
+  size_t count;
+  size_t num_chunks;
+  size_t next_chunk = 0;
+  size_t num_done = 0;
+  std::exception_ptr error;
+};
+
+/// Threads kept alive between parallelFor calls, so that a kernel can call
+/// it once per step without starting and joining threads every time.
+class ThreadPool {
+public:
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  /// Run every chunk of job and wait for them. The calling thread claims
+  /// chunks too, so a parallelFor nested in another one finishes even when
+  /// every pool thread is busy.
+  void run(ParallelJob &job) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_threads.size() + 1 < job.num_chunks) {
+      m_threads.emplace_back([this]() { work(); });
+    }
+    m_jobs.push_back(&job);
+    for (size_t chunk = 1; chunk < job.num_chunks; chunk++) {
+      m_wake.notify_one();
+    }
+    size_t chunk = 0;
+    while (claim(job, chunk)) {
+      runChunk(job, chunk, lock);
+    }
+    m_done.wait(lock, [&]() { return job.num_done == job.num_chunks; });
+  }
+
+private:
+  /// Take the next chunk of job. A job leaves the queue with its last
+  /// chunk, so a pool thread never sees a job whose caller has returned.
+  bool claim(ParallelJob &job, size_t &chunk) {
+    if (job.next_chunk == job.num_chunks) {
+      return false;
+    }
+    chunk = job.next_chunk++;
+    if (job.next_chunk == job.num_chunks) {
+      m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+    }
+    return true;
+  }
+
+  /// Run a claimed chunk with the lock released.
+  void runChunk(ParallelJob &job, const size_t &chunk,
+                std::unique_lock<std::mutex> &lock) {
+    lock.unlock();
+    size_t chunk_begin = job.begin + job.count * chunk / job.num_chunks;
+    size_t chunk_end = job.begin + job.count * (chunk + 1) / job.num_chunks;
+    std::exception_ptr error;
+    try {
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        job.fn(i);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    if (error && !job.error) {
+      job.error = error;
+    }
+    if (++job.num_done == job.num_chunks) {
+      m_done.notify_all();
+    }
+  }
+
+  void work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_wake.wait(lock, [&]() { return m_stop || !m_jobs.empty(); });
+      if (m_stop) {
+        return;
+      }
+      ParallelJob &job = *m_jobs.front();
+      size_t chunk = 0;
+      if (claim(job, chunk)) {
+        runChunk(job, chunk, lock);
+      }
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::deque<ParallelJob *> m_jobs;
+  std::vector<std::thread> m_threads;
+  bool m_stop = false;
+};
+
+ThreadPool &threadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+}; // namespace
+
+size_t numThreads() {
+  size_t num_threads = g_num_threads.load();
+  if (num_threads == 0) {
+    num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  return num_threads;
+}
+
+void setNumThreads(const size_t &num_threads) { g_num_threads = num_threads; }
+
+void parallelFor(const size_t &begin, const size_t &end,
+                 const std::function<void(const size_t &)> &fn,
+                 const size_t &min_chunk_size) {
+  if (end <= begin) {
+    return;
+  }
+  size_t count = end - begin;
+  size_t max_chunks = count / std::max<size_t>(min_chunk_size, 1);
+  size_t num_chunks = std::min(numThreads(), std::max<size_t>(max_chunks, 1));
+  if (num_chunks <= 1) {
+    for (size_t i = begin; i < end; i++) {
+      fn(i);
+    }
+    return;
+  }
+  ParallelJob job{fn, begin, count, num_chunks};
+  threadPool().run(job);
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
+
+size_t TaskGraph::add(const std::function<void()> &fn,
+                      const std::vector<size_t> &dependencies,
+                      const bool &critical) {
+  size_t id = m_tasks.size();
+  std::vector<size_t> unique = dependencies;
+  std::sort(unique.begin(), unique.end());
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+  if (!unique.empty() && unique.back() >= id) {
+    throw std::out_of_range("Task " + std::to_string(id) +
+                            " cannot depend on task " +
+                            std::to_string(unique.back()) +
+                            ", which has not been added yet.");
+  }
+  for (const auto &dependency : unique) {
+    m_tasks[dependency].successors.push_back(id);
+  }
+  m_tasks.push_back(Task{fn, {}, unique.size(), critical});
+  return id;
+}
+
+size_t TaskGraph::size() const { return m_tasks.size(); }
+
+void TaskGraph::run() {
+  size_t num_tasks = m_tasks.size();
+  if (num_tasks == 0) {
+    return;
+  }
+  size_t num_workers = std::min(numThreads(), num_tasks);
+  std::unique_ptr<std::atomic<size_t>[]> waiting_on(
+      new std::atomic<size_t>[num_tasks]);
+  std::vector<TaskQueue> queues(num_workers);
+  TaskQueue critical;
+  // Ready tasks that no worker has taken yet. A worker with nothing to do
+  // sleeps until there is one, instead of polling every queue, so idle
+  // workers do not contend for the locks of busy ones, e.g. while a panel
+  // runs.
+  std::atomic<size_t> num_ready(0);
+  size_t next_queue = 0;
+  for (size_t i = 0; i < num_tasks; i++) {
+    waiting_on[i] = m_tasks[i].num_dependencies;
+    if (m_tasks[i].num_dependencies == 0) {
+      if (m_tasks[i].critical) {
+        critical.push(i);
+      } else {
+        queues[next_queue++ % num_workers].push(i);
+      }
+      num_ready++;
+    }
+  }
+  std::atomic<size_t> num_done(0);
+  std::atomic<size_t> num_sleeping(0);
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  // A sleeper counts itself before it checks num_ready and num_done, and
+  // a waker changes them before it checks for sleepers, so one of the two
+  // always sees the other. Taking the mutex orders the notification after
+  // the sleeper has started waiting.
+  auto wake = [&](const bool &all) {
+    if (num_sleeping.load() == 0) {
+      return;
+    }
+    { std::lock_guard<std::mutex> lock(idle_mutex); }
+    if (all) {
+      idle.notify_all();
+    } else {
+      idle.notify_one();
+    }
+  };
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&](const size_t &w) {
+    while (num_done.load() < num_tasks) {
+      size_t task = 0;
+      bool found = num_ready.load() > 0 && (critical.pop(task, false) ||
+                                            queues[w].pop(task, true));
+      for (size_t i = 1; !found && num_ready.load() > 0 && i < num_workers;
+           i++) {
+        found = queues[(w + i) % num_workers].pop(task, false);
+      }
+      if (!found) {
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        num_sleeping++;
+        idle.wait(lock, [&]() {
+          return num_ready.load() > 0 || num_done.load() == num_tasks;
+        });
+        num_sleeping--;
+        continue;
+      }
+      num_ready--;
+      if (!failed.load()) {
+        try {
+          m_tasks[task].fn();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          failed = true;
+        }
+      }
+      for (const auto &successor : m_tasks[task].successors) {
+        if (--waiting_on[successor] == 0) {
+          if (m_tasks[successor].critical) {
+            critical.push(successor);
+          } else {
+            queues[w].push(successor);
+          }
+          num_ready++;
+          wake(false);
+        }
+      }
+      if (++num_done == num_tasks) {
+        wake(true);
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t w = 1; w < num_workers; w++) {
+    threads.emplace_back(worker, w);
+  }
+  worker(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+}; // namespace basic_matrix
@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <stddef.h>
+#include <vector>
+
+namespace basic_matrix {
+/// The number of threads parallel algorithms are allowed to use. Defaults to
+/// the number of hardware threads.
+size_t numThreads();
+
+/// Override the number of threads parallel algorithms are allowed to use.
+/// 0 restores the default.
+void setNumThreads(const size_t &num_threads);
+
+/// Call fn(i) for every i in [begin, end). The range is split into
+/// contiguous chunks of at least min_chunk_size indices, which are run on
+/// up to numThreads() threads: the calling thread and threads that are
+/// started on first use and kept for later calls, so a kernel may call it
+/// once per step. Small ranges run on the calling thread alone. If fn
+/// throws, the first exception is rethrown on the calling thread once all
+/// chunks are done.
+void parallelFor(const size_t &begin, const size_t &end,
+                 const std::function<void(const size_t &)> &fn,
+                 const size_t &min_chunk_size = 1);
+
+/// A directed acyclic graph of tasks, run by a work-stealing scheduler.
+///
+/// Each task runs once all the tasks it depends on have finished. Every
+/// thread keeps its own queue of ready tasks: it runs the newest task it
+/// made ready, which is likely to touch the data still in its cache, and
+/// an idle thread steals the oldest task of another thread. A thread that
+/// finds nothing to run sleeps until a task becomes ready. Critical tasks,
+/// e.g. the panels on the critical path of a factorization, go to a shared
+/// queue that every thread serves first, so they run as soon as they are
+/// ready and the work they unblock overlaps the work that is left.
+class TaskGraph {
+public:
+  /// Add a task and return its id. The dependencies must be ids of tasks
+  /// that were already added, so the graph is acyclic by construction;
+  /// throws std::out_of_range otherwise. Duplicates are allowed.
+  size_t add(const std::function<void()> &fn,
+             const std::vector<size_t> &dependencies = {},
+             const bool &critical = false);
+
+  /// The number of tasks.
+  size_t size() const;
+
+  /// Run every task on up to numThreads() threads, including the calling
+  /// one, and return once they have all finished. If a task throws, the
+  /// tasks that have not started yet are skipped and the first exception
+  /// is rethrown on the calling thread.
+  void run();
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    std::vector<size_t> successors;
+    size_t num_dependencies;
+    bool critical;
+  };
+  std::vector<Task> m_tasks;
+};
+}; // namespace basic_matrix
@@ -0,0 +1,155 @@
+#include "power_iteration.hpp"
+#include "diagonal_matrix.hpp"
+#include "lup_decomposition.hpp"
+#include <limits>
+#include <math.h>
+#include <random>
+
+namespace basic_matrix {
+namespace {
+double dot(const Matrix &x, const Matrix &y) {
+  double s = 0.0;
+  for (size_t i = 0; i < x.height(); i++) {
+    s += x(0, i) * y(0, i);
+  }
+  return s;
+}
+
+/// The normalized starting vector: options.initial_vector, or a random one.
+Matrix startingVector(const size_t &n, const PowerIterationOptions &options) {
+  Matrix x;
+  if (options.initial_vector.ok()) {
+    if (options.initial_vector.width() != 1 ||
+        options.initial_vector.height() != n) {
+      throw std::runtime_error(
+          "The initial vector must be " + std::to_string(n) + "x1, not " +
+          std::to_string(options.initial_vector.height()) + "x" +
+          std::to_string(options.initial_vector.width()));
+    }
+    x = options.initial_vector;
+  } else {
+    x = Matrix(1, n);
+    std::mt19937 gen(options.seed);
+    std::normal_distribution<double> dist;
+    for (size_t i = 0; i < n; i++) {
+      x(0, i) = dist(gen);
+    }
+  }
+  double norm = x.norm();
+  if (norm == 0.0) {
+    throw std::runtime_error("The initial vector must not be zero.");
+  }
+  x *= 1.0 / norm;
+  return x;
+}
+
+/// Fill in result.value with the Rayleigh quotient of the unit vector x,
+/// given Ax = A * x, and return the norm of the residual Ax - value * x.
+double rayleighQuotient(const Matrix &x, const Matrix &Ax, Eigenpair &result) {
+  result.value = dot(x, Ax);
+  double sum = 0.0;
+  for (size_t i = 0; i < x.height(); i++) {
+    double r = Ax(0, i) - result.value * x(0, i);
+    sum += r * r;
+  }
+  return sqrt(sum);
+}
+
+void checkSquare(const Matrix &A) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error(
+        "Cannot compute eigenvalues for non-square matrix.");
+  }
+}
+
+/// Factor A - shift * I. If the shift is exactly an eigenvalue, the shift
+/// is moved by a rounding error's worth, which leaves the factorization
+/// nearly singular, as inverse iteration wants it.
+void factorShifted(const Matrix &A, double shift, const double &scale,
+                   Matrix &LU, std::vector<size_t> &pivots) {
+  for (size_t attempt = 0; attempt < 8; attempt++) {
+    LU = A - shift * Identity(A.height());
+    if (luFactorize(LU, pivots)) {
+      return;
+    }
+    shift += std::numeric_limits<double>::epsilon() *
+             std::max(scale, 1.0) * double(1 << attempt);
+  }
+  throw std::runtime_error("Could not factor the shifted matrix.");
+}
+}; // namespace
+
+Eigenpair powerIteration(const LinearOperator &A, const size_t &n,
+                         const PowerIterationOptions &options) {
+  Eigenpair result;
+  Matrix x = startingVector(n, options);
+  for (; result.iterations < options.max_iterations; result.iterations++) {
+    Matrix Ax = A(x);
+    double residual = rayleighQuotient(x, Ax, result);
+    if (residual <= options.tolerance * fabs(result.value)) {
+      result.converged = true;
+      break;
+    }
+    double norm = Ax.norm();
+    if (norm == 0.0) {
+      // x is in the null space of A; A is zero on the Krylov subspace.
+      result.converged = true;
+      break;
+    }
+    x = Ax / norm;
+  }
+  result.vector = x;
+  return result;
+}
+
+Eigenpair powerIteration(const Matrix &A,
+                         const PowerIterationOptions &options) {
+  checkSquare(A);
+  return powerIteration([&A](const Matrix &x) { return A * x; }, A.height(),
+                        options);
+}
+
+Eigenpair inverseIteration(const Matrix &A, const double &shift,
+                           const PowerIterationOptions &options) {
+  checkSquare(A);
+  double scale = A.norm();
+  Matrix LU;
+  std::vector<size_t> pivots;
+  factorShifted(A, shift, scale, LU, pivots);
+  Eigenpair result;
+  Matrix x = startingVector(A.height(), options);
+  for (; result.iterations < options.max_iterations; result.iterations++) {
+    double residual = rayleighQuotient(x, A * x, result);
+    if (residual <= options.tolerance * scale) {
+      result.converged = true;
+      break;
+    }
+    solveLU(LU, pivots, x);
+    x *= 1.0 / x.norm();
+  }
+  result.vector = x;
+  return result;
+}
+
+Eigenpair rayleighQuotientIteration(const Matrix &A,
+                                    const PowerIterationOptions &options) {
+  checkSquare(A);
+  double scale = A.norm();
+  Matrix LU;
+  std::vector<size_t> pivots;
+  Eigenpair result;
+  Matrix x = startingVector(A.height(), options);
+  for (; result.iterations < options.max_iterations; result.iterations++) {
+    double residual = rayleighQuotient(x, A * x, result);
+    if (residual <= options.tolerance * scale) {
+      result.converged = true;
+      break;
+    }
+    factorShifted(A, result.value, scale, LU, pivots);
+    solveLU(LU, pivots, x);
+    x *= 1.0 / x.norm();
+  }
+  result.vector = x;
+  return result;
+}
+}; // namespace basic_matrix
@@ -0,0 +1,78 @@
+#pragma once
+#include "krylov.hpp"
+#include "matrix.hpp"
+
+namespace basic_matrix {
+struct PowerIterationOptions {
+  /// Starting vector, n x 1. Pass the vector of a previous solve to warm
+  /// start. If not ok(), a random vector is used.
+  Matrix initial_vector;
+
+  /// An eigenpair (lambda, x) has converged once ||A * x - lambda * x|| is
+  /// below tolerance * ||A||. Power iteration estimates ||A|| by |lambda|;
+  /// the other methods use the Frobenius norm of A.
+  double tolerance = 1e-10;
+
+  /// Maximum number of iterations.
+  size_t max_iterations = 1000;
+
+  /// Seed of the random starting vector.
+  size_t seed = 0;
+};
+
+/// The result of a single-vector eigensolver.
+struct Eigenpair {
+  /// The eigenvalue, the Rayleigh quotient of vector.
+  double value = 0.0;
+
+  /// The unit eigenvector, n x 1.
+  Matrix vector;
+
+  /// Number of iterations performed.
+  size_t iterations = 0;
+
+  /// Whether the residual met the tolerance.
+  bool converged = false;
+};
+
+/// Find the eigenvalue of largest magnitude of the n x n operator A, and
+/// its eigenvector, with the power method.
+///
+/// Each iteration costs one product with A, O(n^2) for a dense matrix, and
+/// reduces the error by a factor of |lambda_2 / lambda_1|. The method does
+/// not converge if the dominant eigenvalue is not unique in magnitude
+/// (e.g. a complex conjugate pair, or +/- lambda).
+Eigenpair powerIteration(
+    const LinearOperator &A, const size_t &n,
+    const PowerIterationOptions &options = PowerIterationOptions());
+
+/// powerIteration for an explicit matrix.
+Eigenpair powerIteration(
+    const Matrix &A,
+    const PowerIterationOptions &options = PowerIterationOptions());
+
+/// Find the eigenvalue of A closest to shift, and its eigenvector, with
+/// shifted inverse iteration: the power method on (A - shift * I)^-1.
+///
+/// A - shift * I is factored once with luFactorize, after which every
+/// iteration is two triangular solves and a product with A, O(n^2). The
+/// error shrinks by |lambda - shift| / |lambda' - shift| per iteration,
+/// where lambda' is the next closest eigenvalue, so a good shift converges
+/// in a few iterations.
+Eigenpair inverseIteration(
+    const Matrix &A, const double &shift,
+    const PowerIterationOptions &options = PowerIterationOptions());
+
+/// Refine an approximate eigenpair of A with Rayleigh quotient iteration:
+/// inverse iteration whose shift is updated to the Rayleigh quotient of the
+/// current vector every iteration.
+///
+/// Convergence is cubic for symmetric A and quadratic otherwise, but
+/// A - shift * I is refactored every iteration, O(n^3). The eigenpair found
+/// is the one options.initial_vector is closest to, so warm start with a
+/// vector from powerIteration, inverseIteration or a previous solve to pick
+/// a specific one. Only real eigenvalues can be found.
+Eigenpair rayleighQuotientIteration(
+    const Matrix &A,
+    const PowerIterationOptions &options = PowerIterationOptions());
+}; // namespace basic_matrix
@@ -1,56 +1,419 @@
 #include "lup_decomposition.hpp"
+#include "parallel.hpp"
 #include "qr_factorization.hpp"
 #include "scalar.hpp"
+#include <math.h>
+#include <string.h>
 
 namespace basic_matrix {
-void qrFactorize(Matrix &Q, Matrix &R) {
-  Matrix A = R;
-  Q = identity(R.height());
-  for (size_t k = 0; k < R.width() && k < R.height(); k++) {
-    size_t m_k = R.height() - k;
-    size_t n_k = R.width() - k;
-    // Consider
-    // H_k = [ I 0               ]
-    //       [ 0 I - 2*v_k*v_k_t ]
-    // H_k is a symmetric matrix, as is identity. Therefore,
-    // H_k*H_k = H_k*H_k_T=I
-    // A = H_1*H_2*...*H_max*H_max*...*H_2*H_1*A
-    // = (H_1*H_2*...*H_max)*R
-    // where R is diagonal.
-    // = Q * R
-
-    // Buid the reflector I - 2*v_k*v_k.transpose()
-    Matrix y(MatrixROI(k, k, 1, m_k, &R));
-    Matrix e1(y.width(), y.height());
-    e1(0, 0) = 1.0;
-    Matrix w = y + (sign(y(0, 0)) * y.norm() * e1);
-    double factor = 1. / w.norm();
-    Matrix v_k = factor * w;
-    Matrix A_roi(MatrixROI(k, k, n_k, m_k, &R));
-
-    // Edit R (whose input was A) in place. Subtracting
-    // 2*v_k*v_k.transpose() is equvalent to pre-multiplying H_k.
-    // We only do it in the region that would be affected
-    // by the multiplication to save on flops
-    A_roi = A_roi - (2.0 * v_k * (v_k.transposeROI() * A_roi));
-    Matrix H_k = identity(Q.height());
-    Matrix H_k_roi(MatrixROI(k, k, m_k, m_k, &H_k));
-    H_k_roi = H_k_roi - (2.0 * v_k * v_k.transposeROI());
-
-    // Perform the next multiplication for building Q
-    Q = Q * H_k;
+namespace {
+/// Number of reflectors that are aggregated into one compact WY block.
+constexpr size_t kBlockSize = 32;
+
+/// solveQR switches to TSQR for problems at least this tall...
+constexpr size_t kTsqrMinRows = 4096;
+/// ...and at least this many times taller than they are wide.
+constexpr size_t kTsqrAspectRatio = 16;
+
+/// Unblocked Householder QR of the panel made of columns [k, k + nb) and
+/// rows [k, height) of a contiguous matrix. Each reflector is applied to
+/// the rest of the panel as a rank-1 update.
+void factorPanel(Matrix &A, const size_t &k, const size_t &nb, double *tau) {
+  size_t w = A.width();
+  size_t h = A.height();
+  double *a = A.data();
+  std::vector<double> work(nb);
+  for (size_t j = k; j < k + nb; j++) {
+    tau[j] =
+        householderReflector(&a[j * w + j], &a[(j + 1) * w + j], h - j - 1, w);
+    size_t c0 = j + 1;
+    size_t nc = k + nb - c0;
+    if (tau[j] == 0.0 || nc == 0) {
+      continue;
+    }
+    // work = v^T * A(j:h, c0:c0+nc), with the implicit v(0) = 1.
+    for (size_t c = 0; c < nc; c++) {
+      work[c] = a[j * w + c0 + c];
+    }
+    for (size_t r = j + 1; r < h; r++) {
+      double v = a[r * w + j];
+      for (size_t c = 0; c < nc; c++) {
+        work[c] += v * a[r * w + c0 + c];
+      }
+    }
+    for (size_t c = 0; c < nc; c++) {
+      a[j * w + c0 + c] -= tau[j] * work[c];
+    }
+    for (size_t r = j + 1; r < h; r++) {
+      double f = tau[j] * a[r * w + j];
+      for (size_t c = 0; c < nc; c++) {
+        a[r * w + c0 + c] -= f * work[c];
+      }
+    }
+  }
+}
+
+/// Copy a block of a contiguous matrix into a new contiguous matrix.
+Matrix copyBlock(const Matrix &A, const size_t &x0, const size_t &y0,
+                 const size_t &width, const size_t &height) {
+  Matrix block(width, height);
+  for (size_t y = 0; y < height; y++) {
+    memcpy(block.data() + y * width, A.data() + (y0 + y) * A.width() + x0,
+           width * sizeof(double));
+  }
+  return block;
+}
+
+/// Write a contiguous block back into a contiguous matrix.
+void storeBlock(Matrix &A, const size_t &x0, const size_t &y0,
+                const Matrix &block) {
+  for (size_t y = 0; y < block.height(); y++) {
+    memcpy(A.data() + (y0 + y) * A.width() + x0,
+           block.data() + y * block.width(), block.width() * sizeof(double));
+  }
+}
+
+/// The compact WY form of the block of reflectors k, ..., k + nb - 1 of
+/// the output of householderQR. V is (height - k) x nb.
+BlockReflector makeBlockReflector(const Matrix &QR, const Matrix &tau,
+                                  const size_t &k, const size_t &nb) {
+  size_t m = QR.height() - k;
+  BlockReflector block{Matrix(nb, m), Matrix(m, nb), Matrix(nb, nb)};
+  for (size_t c = 0; c < nb; c++) {
+    block.V(c, c) = 1.0;
+    for (size_t r = c + 1; r < m; r++) {
+      block.V(c, r) = QR(k + c, k + r);
+    }
+  }
+  block.Vt = block.V.transpose();
+  // Build T column by column (LAPACK's xLARFT):
+  // T(0:i, i) = -tau_i * T(0:i, 0:i) * V(:, 0:i)^T * v_i
+  std::vector<double> t(nb);
+  const double *vt = block.Vt.data();
+  for (size_t i = 0; i < nb; i++) {
+    double tau_i = tau(0, k + i);
+    block.T(i, i) = tau_i;
+    if (tau_i == 0.0) {
+      continue;
+    }
+    for (size_t j = 0; j < i; j++) {
+      double sum = 0.;
+      // v_i is zero above row i.
+      for (size_t r = i; r < m; r++) {
+        sum += vt[j * m + r] * vt[i * m + r];
+      }
+      t[j] = -tau_i * sum;
+    }
+    for (size_t j = 0; j < i; j++) {
+      double sum = 0.;
+      for (size_t l = j; l < i; l++) {
+        sum += block.T(l, j) * t[l];
+      }
+      block.T(i, j) = sum;
+    }
+  }
+  return block;
+}
+
+/// Apply Q or Q^T, stored as reflectors in QR, to a contiguous matrix.
+void applyReflectors(const Matrix &QR, const Matrix &tau, Matrix &B,
+                     const bool &transpose) {
+  if (B.height() != QR.height()) {
+    throw std::runtime_error(
+        "Tried to apply a Q of height " + std::to_string(QR.height()) +
+        " to a matrix of height " + std::to_string(B.height()) +
+        "; heights must match.");
+  }
+  size_t num_reflectors = tau.height();
+  if (num_reflectors == 0 || B.width() == 0) {
+    return;
+  }
+  size_t num_blocks = (num_reflectors + kBlockSize - 1) / kBlockSize;
+  for (size_t b = 0; b < num_blocks; b++) {
+    // Q^T = H_k * ... * H_1 applies the first block first, Q the last.
+    size_t block_idx = transpose ? b : num_blocks - b - 1;
+    size_t k = block_idx * kBlockSize;
+    size_t nb = std::min(kBlockSize, num_reflectors - k);
+    BlockReflector block = makeBlockReflector(QR, tau, k, nb);
+    Matrix C = copyBlock(B, 0, k, B.width(), B.height() - k);
+    applyBlockReflector(block, C, transpose);
+    storeBlock(B, 0, k, C);
+  }
+}
+/// Copy the upper-trapezoidal R out of the output of householderQR.
+Matrix upperTriangle(const Matrix &QR) {
+  size_t w = QR.width();
+  Matrix R(w, std::min(w, QR.height()));
+  for (size_t y = 0; y < R.height(); y++) {
+    memcpy(R.data() + y * w + y, QR.data() + y * w + y,
+           (w - y) * sizeof(double));
+  }
+  return R;
+}
+
+/// The R factor of rows [y0, y1) of the matrix [A b], or of A alone if b is
+/// null.
+Matrix chunkR(const Matrix &A, const Matrix *b, const size_t &y0,
+              const size_t &y1) {
+  size_t a_width = A.width();
+  size_t b_width = b ? b->width() : 0;
+  Matrix chunk(a_width + b_width, y1 - y0);
+  for (size_t y = y0; y < y1; y++) {
+    double *row = chunk.data() + (y - y0) * chunk.width();
+    if (A.contiguous()) {
+      memcpy(row, A.data() + y * a_width, a_width * sizeof(double));
+    } else {
+      for (size_t x = 0; x < a_width; x++) {
+        row[x] = A(x, y);
+      }
+    }
+    for (size_t x = 0; x < b_width; x++) {
+      row[a_width + x] = (*b)(x, y);
+    }
+  }
+  Matrix tau;
+  householderQR(chunk, tau);
+  return upperTriangle(chunk);
+}
+
+/// TSQR: factor row chunks of [A b] independently, then combine pairs of R
+/// factors with a binary reduction tree. Every level of the tree runs in
+/// parallel.
+Matrix tsqrR(const Matrix &A, const Matrix *b, size_t num_chunks) {
+  size_t width = A.width() + (b ? b->width() : 0);
+  if (num_chunks == 0) {
+    num_chunks = numThreads();
+  }
+  // Chunks shorter than they are wide would just be padded with zeros.
+  num_chunks = std::max<size_t>(
+      std::min(num_chunks, A.height() / std::max<size_t>(width, 1)), 1);
+  std::vector<Matrix> Rs(num_chunks);
+  parallelFor(0, num_chunks, [&](const size_t &i) {
+    size_t y0 = A.height() * i / num_chunks;
+    size_t y1 = A.height() * (i + 1) / num_chunks;
+    Rs[i] = chunkR(A, b, y0, y1);
+  });
+  while (Rs.size() > 1) {
+    std::vector<Matrix> next((Rs.size() + 1) / 2);
+    parallelFor(0, next.size(), [&](const size_t &i) {
+      if (2 * i + 1 < Rs.size()) {
+        // [R_1; R_2] = Q_12 * R_12, so R_12 is an R factor for both chunks.
+        Matrix stacked = Rs[2 * i].concatDown(Rs[2 * i + 1]);
+        Matrix tau;
+        householderQR(stacked, tau);
+        next[i] = upperTriangle(stacked);
+      } else {
+        next[i] = Rs[2 * i];
+      }
+    });
+    Rs = next;
+  }
+  return Rs[0];
+}
+}; // namespace
+
+void applyBlockReflector(const BlockReflector &block, Matrix &C,
+                         const bool &transpose_T) {
+  size_t nb = block.T.width();
+  Matrix W = block.Vt * C;
+  size_t nc = W.width();
+  double *w = W.data();
+  if (transpose_T) {
+    // T^T is lower triangular; walk up so rows are still unmodified.
+    for (size_t i = nb; i-- > 0;) {
+      for (size_t c = 0; c < nc; c++) {
+        double sum = 0.;
+        for (size_t l = 0; l <= i; l++) {
+          sum += block.T(i, l) * w[l * nc + c];
+        }
+        w[i * nc + c] = sum;
+      }
+    }
+  } else {
+    for (size_t i = 0; i < nb; i++) {
+      for (size_t c = 0; c < nc; c++) {
+        double sum = 0.;
+        for (size_t l = i; l < nb; l++) {
+          sum += block.T(l, i) * w[l * nc + c];
+        }
+        w[i * nc + c] = sum;
+      }
+    }
+  }
+  Matrix VW = block.V * W;
+  if (!C.contiguous()) {
+    C -= VW;
+    return;
+  }
+  double *c = C.data();
+  const double *vw = VW.data();
+  for (size_t i = 0; i < C.width() * C.height(); i++) {
+    c[i] -= vw[i];
+  }
+}
+
+double householderReflector(double *alpha, double *x, const size_t &n,
+                            const size_t &stride) {
+  double x_norm_squared = 0.;
+  for (size_t i = 0; i < n; i++) {
+    x_norm_squared += x[i * stride] * x[i * stride];
+  }
+  if (x_norm_squared == 0.0) {
+    return 0.0;
+  }
+  double beta = -sign(*alpha) * sqrt(*alpha * *alpha + x_norm_squared);
+  double tau = (beta - *alpha) / beta;
+  double scale = 1.0 / (*alpha - beta);
+  for (size_t i = 0; i < n; i++) {
+    x[i * stride] *= scale;
+  }
+  *alpha = beta;
+  return tau;
+}
+
+Matrix tsqrR(const Matrix &A, const size_t &num_chunks) {
+  return tsqrR(A, nullptr, num_chunks);
+}
+
+void solveTSQR(const Matrix &A, Matrix &b, const size_t &num_chunks) {
+  if (b.height() != A.height()) {
+    throw std::runtime_error("Tried to solve a system with " +
+                             std::to_string(A.height()) + " equations and " +
+                             std::to_string(b.height()) +
+                             " right-hand side rows; heights must match.");
+  }
+  size_t n = A.width();
+  size_t num_rhs = b.width();
+  if (A.height() < n + num_rhs) {
+    // Not tall enough for the augmented R to hold a square R and Q^T * b.
+    solveQR(A, b);
+    return;
+  }
+  // The R factor of [A b] is
+  // [ R Q^T*b ]
+  // [ 0 *     ]
+  // so the least squares solution is R^-1 * (Q^T * b), and Q is never
+  // needed.
+  Matrix R_augmented = tsqrR(A, &b, num_chunks);
+  Matrix R(MatrixROI(0, 0, n, n, &R_augmented));
+  Matrix x(MatrixROI(n, 0, num_rhs, n, &R_augmented));
+  solveU(R, x);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t col = 0; col < num_rhs; col++) {
+      b(col, y) = x(col, y);
+    }
+  }
+}
+
+void householderQR(Matrix &A, Matrix &tau) {
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    householderQR(A_contiguous, tau);
+    A = A_contiguous;
+    return;
+  }
+  size_t w = A.width();
+  size_t h = A.height();
+  size_t num_reflectors = std::min(w, h);
+  tau = Matrix(1, num_reflectors);
+  for (size_t k = 0; k < num_reflectors; k += kBlockSize) {
+    size_t nb = std::min(kBlockSize, num_reflectors - k);
+    factorPanel(A, k, nb, tau.data());
+    // Update the trailing columns with the whole block at once:
+    // A(k:h, k+nb:w) = (I - V * T^T * V^T) * A(k:h, k+nb:w)
+    size_t trailing_x = k + nb;
+    if (trailing_x < w) {
+      BlockReflector block = makeBlockReflector(A, tau, k, nb);
+      Matrix C = copyBlock(A, trailing_x, k, w - trailing_x, h - k);
+      applyBlockReflector(block, C, true);
+      storeBlock(A, trailing_x, k, C);
+    }
+  }
+}
+
+void applyQ(const Matrix &QR, const Matrix &tau, Matrix &B) {
+  if (!B.contiguous()) {
+    Matrix B_contiguous = B;
+    applyQ(QR, tau, B_contiguous);
+    B = B_contiguous;
+    return;
+  }
+  applyReflectors(QR, tau, B, false);
+}
+
+void applyQt(const Matrix &QR, const Matrix &tau, Matrix &B) {
+  if (!B.contiguous()) {
+    Matrix B_contiguous = B;
+    applyQt(QR, tau, B_contiguous);
+    B = B_contiguous;
+    return;
+  }
+  applyReflectors(QR, tau, B, true);
+}
+
+Matrix formQ(const Matrix &QR, const Matrix &tau, const bool &thin) {
+  size_t width = thin ? tau.height() : QR.height();
+  Matrix Q(width, QR.height());
+  for (size_t i = 0; i < width; i++) {
+    Q(i, i) = 1.0;
+  }
+  applyQ(QR, tau, Q);
+  return Q;
+}
+
+void qrFactorize(Matrix &Q, Matrix &R, const bool &thin) {
+  // Consider
+  // H_k = [ I 0                     ]
+  //       [ 0 I - tau_k*v_k*v_k_t   ]
+  // H_k is a symmetric, orthogonal matrix. Therefore,
+  // A = H_1*H_2*...*H_max*H_max*...*H_2*H_1*A
+  // = (H_1*H_2*...*H_max)*R
+  // where R is upper triangular.
+  // = Q * R
+  Matrix tau;
+  householderQR(R, tau);
+  Q = formQ(R, tau, thin);
+  if (thin && R.height() > tau.height()) {
+    // Only the first min(width, height) rows of R are nonzero.
+    Matrix R_thin(R.width(), tau.height());
+    for (size_t y = 0; y < R_thin.height(); y++) {
+      for (size_t x = y; x < R_thin.width(); x++) {
+        R_thin(x, y) = R(x, y);
+      }
+    }
+    R = R_thin;
+    return;
+  }
+  // Clear out the reflectors stored below the diagonal.
+  for (size_t x = 0; x < R.width(); x++) {
+    for (size_t y = x + 1; y < R.height(); y++) {
+      R(x, y) = 0.0;
+    }
   }
 }
 void solveQR(const Matrix &A, Matrix &b) {
-  Matrix R = A;
-  Matrix Q;
-  qrFactorize(Q, R);
+  if (b.height() != A.height()) {
+    throw std::runtime_error("Tried to solve a system with " +
+                             std::to_string(A.height()) + " equations and " +
+                             std::to_string(b.height()) +
+                             " right-hand side rows; heights must match.");
+  }
+  if (numThreads() > 1 && A.height() >= kTsqrMinRows &&
+      A.height() >= kTsqrAspectRatio * (A.width() + b.width())) {
+    solveTSQR(A, b);
+    return;
+  }
+  Matrix QR = A;
+  Matrix tau;
+  householderQR(QR, tau);
   // If Q and R are a QR factorization of A, the least squares solution is equal
   // to: x_hat = (A.transpose()*A).inverse()*A.transpose() * b =
   // R.inverse()*Q.transpose() Therefore: R*x_hat = Q.transpose()*b where
-  // Q.transpose()*b is diagonaol. We can therefore solve it by back
-  // substitution.
-  b = Q.transposeROI() * b;
-  solveU(R, b);
+  // R is upper triangular. We can therefore solve it by back substitution.
+  // Q.transpose()*b is computed from the reflectors, so Q is never formed.
+  applyQt(QR, tau, b);
+  // solveU only reads the upper triangle, so the reflectors below the
+  // diagonal can stay where they are.
+  solveU(QR, b);
 }
 }; // namespace basic_matrix
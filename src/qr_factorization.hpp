@@ -3,6 +3,65 @@
 
 namespace basic_matrix {
 
+/// Generate an elementary reflector H = I - tau * v * v^T such that
+/// H * [alpha; x] = [beta; 0], where v = [1; v_tail].
+///
+/// This works on raw storage so that it can be used on rows and columns of
+/// contiguous matrices alike: x holds n elements, stride apart.
+///
+/// in/out: alpha, overwritten with beta.
+/// in/out: x, overwritten with v_tail.
+/// Returns tau, which is 0 (H = I) if x is already zero.
+double householderReflector(double *alpha, double *x, const size_t &n,
+                            const size_t &stride);
+
+/// The compact WY form of a block of nb reflectors,
+/// H_1 * ... * H_nb = I - V * T * V^T
+/// where V is unit lower trapezoidal and T is upper triangular.
+struct BlockReflector {
+  /// V, m x nb, for reflectors of length m.
+  Matrix V;
+  /// V^T, stored separately so both products are contiguous.
+  Matrix Vt;
+  /// T, nb x nb.
+  Matrix T;
+};
+
+/// C = (I - V * T * V^T) * C, or (I - V * T^T * V^T) * C if transpose_T.
+/// Both large products go through the SIMD multiplication path. C must be
+/// m tall.
+void applyBlockReflector(const BlockReflector &block, Matrix &C,
+                         const bool &transpose_T);
+
+/// Householder QR factorization of A, stored compactly in place.
+///
+/// On output, R is stored on and above the diagonal of A, and the
+/// Householder vector v_k of each reflector H_k = I - tau_k * v_k * v_k^T
+/// is stored below the diagonal of column k. The leading element of each
+/// v_k is an implicit 1. Together they describe
+/// A = Q * R, Q = H_1 * H_2 * ... * H_min(width, height)
+///
+/// Q is never formed. Blocks of reflectors are applied to the trailing
+/// columns at once using the compact WY representation
+/// H_k * ... * H_(k+nb-1) = I - V * T * V^T, so most of the work is matrix
+/// multiplication.
+///
+/// in/out: A
+/// out: tau, a min(width, height) x 1 column of reflector scales.
+void householderQR(Matrix &A, Matrix &tau);
+
+/// Compute B = Q * B in place, where Q is given by the output of
+/// householderQR. B must have the same height as QR.
+void applyQ(const Matrix &QR, const Matrix &tau, Matrix &B);
+
+/// Compute B = Q^T * B in place, where Q is given by the output of
+/// householderQR. B must have the same height as QR.
+void applyQt(const Matrix &QR, const Matrix &tau, Matrix &B);
+
+/// Explicitly form Q from the output of householderQR. Q is
+/// height x height, or height x min(width, height) if thin is true.
+Matrix formQ(const Matrix &QR, const Matrix &tau, const bool &thin = false);
+
 /// Perform QR factorization on the matrix R. Save the result in
 /// R.
 ///
@@ -16,11 +75,16 @@ namespace basic_matrix {
 ///
 /// The Householder method is used here. The method is described
 /// here: http://www.seas.ucla.edu/~vandenbe/ee133a.html
-/// Complexity is 2*height*width^2 - (2/3)*n^3 flops
+/// Complexity is 2*height*width^2 - (2/3)*n^3 flops for R, plus the cost
+/// of forming the full height x height Q. Use householderQR to avoid
+/// forming Q.
+///
+/// If thin is true, the economy-size factorization is computed instead:
+/// Q is height x min(width, height) and R is min(width, height) x width.
 ///
 /// out: Q
 /// in/out: R
-void qrFactorize(Matrix &Q, Matrix &R);
+void qrFactorize(Matrix &Q, Matrix &R, const bool &thin = false);
 
 /// Solve a system of linear equations using QR factorization.
 /// This system does not have to be square. Common applications
@@ -30,9 +94,37 @@ void qrFactorize(Matrix &Q, Matrix &R);
 ///
 /// This implementation uses the Householder method, widely known
 /// to be the most numerically stable. The calculation takes
-/// 2 * height*width^2 flops
+/// 2 * height*width^2 flops and height*width memory: Q^T * b is applied
+/// directly from the Householder reflectors, so Q is never formed.
+///
+/// Each column of b is a separate right-hand side, and all of them are
+/// solved at once. The solution of each column is saved in its first
+/// min(width, height) rows.
+///
+/// Very tall problems are handed to solveTSQR when more than one thread is
+/// available.
 ///
 /// in: A
 /// in/out: b, x is saved here at the end.
 void solveQR(const Matrix &A, Matrix &b);
+
+/// Compute the R factor of A with tall-skinny QR (TSQR).
+///
+/// The rows of A are split into num_chunks chunks that are QR factored
+/// independently on separate threads. The R factors of the chunks are then
+/// stacked in pairs and factored again, level by level, until a single R
+/// remains. R is unique up to the signs of its rows.
+///
+/// num_chunks defaults to numThreads(). Chunks are never made shorter than A
+/// is wide.
+Matrix tsqrR(const Matrix &A, const size_t &num_chunks = 0);
+
+/// Solve a least squares problem A*x = b with TSQR. This is the same as
+/// solveQR, but the work is spread over num_chunks threads, which pays off
+/// when A is much taller than it is wide. The R factor of [A b] holds both R
+/// and Q^T * b, so Q is never formed.
+///
+/// in: A
+/// in/out: b, x is saved in the first width rows at the end.
+void solveTSQR(const Matrix &A, Matrix &b, const size_t &num_chunks = 0);
 }; // namespace basic_matrix
@@ -1,4 +1,5 @@
 #include <ctype.h>
+#include <functional>
 #include <iostream>
 #include <matrix.hpp>
 #include <optional>
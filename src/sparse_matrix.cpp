@@ -0,0 +1,313 @@
+#include "sparse_matrix.hpp"
+#include "kernel_helpers.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+void checkDimensions(const size_t &w1, const size_t &h1, const size_t &w2,
+                     const size_t &h2, const std::string &operation) {
+  if (w1 != w2 || h1 != h2) {
+    throw std::runtime_error(
+        operation + " requires equal dimensions, but got " +
+        std::to_string(w1) + "x" + std::to_string(h1) + " and " +
+        std::to_string(w2) + "x" + std::to_string(h2));
+  }
+}
+}; // namespace
+
+SparseMatrix::SparseMatrix() : SparseMatrix(0, 0) {}
+
+SparseMatrix::SparseMatrix(const size_t &width, const size_t &height)
+    : m_width(width), m_height(height), m_row_start(height + 1, 0) {}
+
+SparseMatrix::SparseMatrix(const size_t &width, const size_t &height,
+                           const std::vector<Triplet> &triplets)
+    : SparseMatrix(width, height) {
+  // Counting sort by row, then sort each row by column and merge
+  // duplicates.
+  std::vector<size_t> count(height + 1, 0);
+  for (const auto &t : triplets) {
+    if (t.x >= width || t.y >= height) {
+      throw std::out_of_range("Triplet (" + std::to_string(t.x) + ", " +
+                              std::to_string(t.y) + ") is outside a " +
+                              std::to_string(width) + "x" +
+                              std::to_string(height) + " matrix.");
+    }
+    count[t.y + 1]++;
+  }
+  for (size_t y = 0; y < height; y++) {
+    count[y + 1] += count[y];
+  }
+  std::vector<std::pair<size_t, double>> entries(triplets.size());
+  std::vector<size_t> next(count.begin(), count.end() - 1);
+  for (const auto &t : triplets) {
+    entries[next[t.y]++] = {t.x, t.value};
+  }
+  for (size_t y = 0; y < height; y++) {
+    auto begin = entries.begin() + count[y];
+    auto end = entries.begin() + count[y + 1];
+    std::sort(begin, end, [](const auto &a, const auto &b) {
+      return a.first < b.first;
+    });
+    for (auto it = begin; it != end;) {
+      size_t x = it->first;
+      double sum = 0.0;
+      for (; it != end && it->first == x; it++) {
+        sum += it->second;
+      }
+      if (sum != 0.0) {
+        m_cols.push_back(x);
+        m_values.push_back(sum);
+      }
+    }
+    m_row_start[y + 1] = m_cols.size();
+  }
+}
+
+SparseMatrix::SparseMatrix(const Matrix &dense, const double &drop_tolerance)
+    : SparseMatrix(dense.width(), dense.height()) {
+  for (size_t y = 0; y < m_height; y++) {
+    for (size_t x = 0; x < m_width; x++) {
+      double value = dense(x, y);
+      if (value != 0.0 && fabs(value) > drop_tolerance) {
+        m_cols.push_back(x);
+        m_values.push_back(value);
+      }
+    }
+    m_row_start[y + 1] = m_cols.size();
+  }
+}
+
+size_t SparseMatrix::width() const { return m_width; }
+size_t SparseMatrix::height() const { return m_height; }
+size_t SparseMatrix::nonZeros() const { return m_values.size(); }
+
+double SparseMatrix::operator()(const size_t &x, const size_t &y) const {
+  if (x >= m_width || y >= m_height) {
+    throw std::out_of_range("(" + std::to_string(x) + ", " +
+                            std::to_string(y) + ") is outside a " +
+                            std::to_string(m_width) + "x" +
+                            std::to_string(m_height) + " matrix.");
+  }
+  auto begin = m_cols.begin() + m_row_start[y];
+  auto end = m_cols.begin() + m_row_start[y + 1];
+  auto it = std::lower_bound(begin, end, x);
+  if (it == end || *it != x) {
+    return 0.0;
+  }
+  return m_values[it - m_cols.begin()];
+}
+
+const std::vector<size_t> &SparseMatrix::rowStart() const {
+  return m_row_start;
+}
+
+const std::vector<size_t> &SparseMatrix::columnIndices() const {
+  return m_cols;
+}
+
+const std::vector<double> &SparseMatrix::values() const { return m_values; }
+
+Matrix SparseMatrix::toDense() const {
+  Matrix result(m_width, m_height);
+  double *r = result.data();
+  for (size_t y = 0; y < m_height; y++) {
+    for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+      r[y * m_width + m_cols[i]] = m_values[i];
+    }
+  }
+  return result;
+}
+
+SparseMatrix SparseMatrix::transpose() const {
+  SparseMatrix result(m_height, m_width);
+  std::vector<size_t> &start = result.m_row_start;
+  for (const auto &x : m_cols) {
+    start[x + 1]++;
+  }
+  for (size_t x = 0; x < m_width; x++) {
+    start[x + 1] += start[x];
+  }
+  result.m_cols.resize(nonZeros());
+  result.m_values.resize(nonZeros());
+  // Visiting the rows in order leaves every row of the result sorted.
+  std::vector<size_t> next(start.begin(), start.end() - 1);
+  for (size_t y = 0; y < m_height; y++) {
+    for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+      size_t j = next[m_cols[i]]++;
+      result.m_cols[j] = y;
+      result.m_values[j] = m_values[i];
+    }
+  }
+  return result;
+}
+
+const Matrix SparseMatrix::operator*(const Matrix &dense_in) const {
+  if (dense_in.height() != m_width) {
+    throw std::runtime_error(
+        "Cannot multiply a " + std::to_string(m_width) + "x" +
+        std::to_string(m_height) + " sparse matrix by a " +
+        std::to_string(dense_in.width()) + "x" +
+        std::to_string(dense_in.height()) + " matrix.");
+  }
+  Matrix dense = dense_in;
+  size_t k = dense.width();
+  Matrix result(k, m_height);
+  const double *b = dense.data();
+  double *c = result.data();
+  parallelFor(
+      0, m_height,
+      [&](const size_t &y) {
+        double *c_row = &c[y * k];
+        if (k == 1) {
+          double sum = 0.0;
+          for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+            sum += m_values[i] * b[m_cols[i]];
+          }
+          c_row[0] = sum;
+          return;
+        }
+        for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+          const double *b_row = &b[m_cols[i] * k];
+          double a = m_values[i];
+          for (size_t x = 0; x < k; x++) {
+            c_row[x] += a * b_row[x];
+          }
+        }
+      },
+      indicesPerChunk(m_height, nonZeros() * k));
+  return result;
+}
+
+Matrix SparseMatrix::transposeMultiply(const Matrix &dense_in) const {
+  if (dense_in.height() != m_height) {
+    throw std::runtime_error(
+        "Cannot multiply the transpose of a " + std::to_string(m_width) +
+        "x" + std::to_string(m_height) + " sparse matrix by a " +
+        std::to_string(dense_in.width()) + "x" +
+        std::to_string(dense_in.height()) + " matrix.");
+  }
+  Matrix dense = dense_in;
+  size_t k = dense.width();
+  Matrix result(k, m_width);
+  const double *b = dense.data();
+  double *c = result.data();
+  for (size_t y = 0; y < m_height; y++) {
+    const double *b_row = &b[y * k];
+    for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+      double *c_row = &c[m_cols[i] * k];
+      double a = m_values[i];
+      for (size_t x = 0; x < k; x++) {
+        c_row[x] += a * b_row[x];
+      }
+    }
+  }
+  return result;
+}
+
+const SparseMatrix SparseMatrix::operator*(const double &scalar) const {
+  SparseMatrix result = *this;
+  for (auto &value : result.m_values) {
+    value *= scalar;
+  }
+  return result;
+}
+
+SparseMatrix SparseMatrix::add(const SparseMatrix &other,
+                               const double &scale) const {
+  checkDimensions(m_width, m_height, other.m_width, other.m_height,
+                  "Sparse addition");
+  SparseMatrix result(m_width, m_height);
+  for (size_t y = 0; y < m_height; y++) {
+    size_t i = m_row_start[y];
+    size_t j = other.m_row_start[y];
+    size_t i_end = m_row_start[y + 1];
+    size_t j_end = other.m_row_start[y + 1];
+    while (i < i_end || j < j_end) {
+      size_t x;
+      double value;
+      if (j == j_end || (i < i_end && m_cols[i] < other.m_cols[j])) {
+        x = m_cols[i];
+        value = m_values[i++];
+      } else if (i == i_end || other.m_cols[j] < m_cols[i]) {
+        x = other.m_cols[j];
+        value = scale * other.m_values[j++];
+      } else {
+        x = m_cols[i];
+        value = m_values[i++] + scale * other.m_values[j++];
+      }
+      if (value != 0.0) {
+        result.m_cols.push_back(x);
+        result.m_values.push_back(value);
+      }
+    }
+    result.m_row_start[y + 1] = result.m_cols.size();
+  }
+  return result;
+}
+
+const SparseMatrix SparseMatrix::operator+(const SparseMatrix &other) const {
+  return add(other, 1.0);
+}
+
+const SparseMatrix SparseMatrix::operator-(const SparseMatrix &other) const {
+  return add(other, -1.0);
+}
+
+const Matrix SparseMatrix::operator+(const Matrix &dense) const {
+  checkDimensions(m_width, m_height, dense.width(), dense.height(),
+                  "Addition");
+  Matrix result = dense;
+  double *r = result.data();
+  for (size_t y = 0; y < m_height; y++) {
+    for (size_t i = m_row_start[y]; i < m_row_start[y + 1]; i++) {
+      r[y * m_width + m_cols[i]] += m_values[i];
+    }
+  }
+  return result;
+}
+
+const Matrix SparseMatrix::operator-(const Matrix &dense) const {
+  return *this + (-dense);
+}
+
+const Matrix operator*(const Matrix &dense_in, const SparseMatrix &sparse) {
+  if (dense_in.width() != sparse.height()) {
+    throw std::runtime_error(
+        "Cannot multiply a " + std::to_string(dense_in.width()) + "x" +
+        std::to_string(dense_in.height()) + " matrix by a " +
+        std::to_string(sparse.width()) + "x" +
+        std::to_string(sparse.height()) + " sparse matrix.");
+  }
+  Matrix dense = dense_in;
+  size_t m = dense.height();
+  size_t p = dense.width();
+  size_t q = sparse.width();
+  const std::vector<size_t> &start = sparse.rowStart();
+  const std::vector<size_t> &cols = sparse.columnIndices();
+  const std::vector<double> &values = sparse.values();
+  Matrix result(q, m);
+  const double *a = dense.data();
+  double *c = result.data();
+  // Row y of the result is row y of dense times sparse: a combination of
+  // the rows of sparse.
+  parallelFor(
+      0, m,
+      [&](const size_t &y) {
+        double *c_row = &c[y * q];
+        for (size_t k = 0; k < p; k++) {
+          double a_yk = a[y * p + k];
+          if (a_yk == 0.0) {
+            continue;
+          }
+          for (size_t i = start[k]; i < start[k + 1]; i++) {
+            c_row[cols[i]] += a_yk * values[i];
+          }
+        }
+      },
+      indicesPerChunk(m, sparse.nonZeros() * m));
+  return result;
+}
+}; // namespace basic_matrix
@@ -0,0 +1,93 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// One entry of a sparse matrix, at column x and row y, as in
+/// Matrix::operator()(x, y).
+struct Triplet {
+  size_t x;
+  size_t y;
+  double value;
+};
+
+/// A sparse matrix in compressed sparse row (CSR) form.
+///
+/// The nonzeros of row y are values()[rowStart()[y]] up to
+/// values()[rowStart()[y + 1]], in the columns columnIndices()[...], which
+/// are sorted. Memory and the cost of products scale with the number of
+/// nonzeros rather than width * height.
+///
+/// The transpose in CSR form has the same arrays as this matrix in
+/// compressed sparse column (CSC) form, so transpose() doubles as the
+/// conversion to CSC.
+class SparseMatrix {
+public:
+  /// A 0x0 matrix.
+  SparseMatrix();
+
+  /// A width x height matrix of zeros.
+  SparseMatrix(const size_t &width, const size_t &height);
+
+  /// Build a width x height matrix from (x, y, value) triplets, in any
+  /// order. Values of duplicate entries are summed, and explicit zeros are
+  /// dropped.
+  SparseMatrix(const size_t &width, const size_t &height,
+               const std::vector<Triplet> &triplets);
+
+  /// The entries of dense with magnitude above drop_tolerance.
+  explicit SparseMatrix(const Matrix &dense,
+                        const double &drop_tolerance = 0.0);
+
+  size_t width() const;
+  size_t height() const;
+
+  /// Number of stored entries.
+  size_t nonZeros() const;
+
+  /// The entry at column x and row y, found by binary search in row y.
+  double operator()(const size_t &x, const size_t &y) const;
+
+  const std::vector<size_t> &rowStart() const;
+  const std::vector<size_t> &columnIndices() const;
+  const std::vector<double> &values() const;
+
+  /// The matrix as a dense Matrix.
+  Matrix toDense() const;
+
+  /// The transpose, in O(nnz + width + height) by a counting sort of the
+  /// entries by column.
+  SparseMatrix transpose() const;
+
+  /// Sparse times dense, e.g. a sparse matrix-vector product (SpMV) for a
+  /// dense n x 1 column. The rows of the result are independent and are
+  /// computed in parallel. Costs O(nnz * dense.width()).
+  const Matrix operator*(const Matrix &dense) const;
+
+  /// this^T * dense, without forming the transpose. Each row of this
+  /// scatters into the result; the cost is the same as operator*.
+  Matrix transposeMultiply(const Matrix &dense) const;
+
+  const SparseMatrix operator*(const double &scalar) const;
+  const SparseMatrix operator+(const SparseMatrix &other) const;
+  const SparseMatrix operator-(const SparseMatrix &other) const;
+
+  /// Mixed sparse and dense sums are dense.
+  const Matrix operator+(const Matrix &dense) const;
+  const Matrix operator-(const Matrix &dense) const;
+
+private:
+  /// this + scale * other, merging the sorted rows.
+  SparseMatrix add(const SparseMatrix &other, const double &scale) const;
+
+  size_t m_width;
+  size_t m_height;
+  std::vector<size_t> m_row_start;
+  std::vector<size_t> m_cols;
+  std::vector<double> m_values;
+};
+
+/// Dense times sparse. Every entry of sparse scales a row of dense into a
+/// column of the result, so the cost is O(nnz * dense.height()).
+const Matrix operator*(const Matrix &dense, const SparseMatrix &sparse);
+}; // namespace basic_matrix
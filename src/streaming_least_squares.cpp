@@ -0,0 +1,197 @@
+#include "streaming_least_squares.hpp"
+#include "lup_decomposition.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+/// Downdates that would shrink det(R^T * R) by more than this factor are
+/// treated as leaving a singular system.
+constexpr double kDowndateTolerance = 1e-12;
+}; // namespace
+
+StreamingLeastSquares::StreamingLeastSquares(const size_t &num_params,
+                                             const size_t &window_size)
+    : m_num_params(num_params), m_window_size(window_size),
+      m_R(num_params, num_params), m_z(1, num_params) {}
+
+void StreamingLeastSquares::addRow(const double *a_in, const double &b_in) {
+  size_t n = m_num_params;
+  std::vector<double> a(a_in, a_in + n);
+  double b = b_in;
+  double *R = m_R.data();
+  double *z = m_z.data();
+  for (size_t i = 0; i < n; i++) {
+    if (a[i] == 0.0) {
+      continue;
+    }
+    // Givens rotation that zeroes a[i] against the diagonal of R.
+    double r = hypot(R[i * n + i], a[i]);
+    double c = R[i * n + i] / r;
+    double s = a[i] / r;
+    R[i * n + i] = r;
+    for (size_t j = i + 1; j < n; j++) {
+      double t = R[i * n + j];
+      R[i * n + j] = c * t + s * a[j];
+      a[j] = c * a[j] - s * t;
+    }
+    double t = z[i];
+    z[i] = c * t + s * b;
+    b = c * b - s * t;
+  }
+  // Whatever is left of b cannot be fit and goes to the residual.
+  m_rho = hypot(m_rho, b);
+  m_num_rows++;
+}
+
+bool StreamingLeastSquares::removeRow(const double *a, const double &b) {
+  size_t n = m_num_params;
+  double *R = m_R.data();
+  double *z = m_z.data();
+  // Solve R^T * p = a.
+  std::vector<double> p(n);
+  double norm_squared = 0.;
+  for (size_t j = 0; j < n; j++) {
+    if (R[j * n + j] == 0.0) {
+      return false;
+    }
+    double sum = a[j];
+    for (size_t i = 0; i < j; i++) {
+      sum -= R[i * n + j] * p[i];
+    }
+    p[j] = sum / R[j * n + j];
+    norm_squared += p[j] * p[j];
+  }
+  // 1 - ||p||^2 is the factor by which det(R^T * R) shrinks. If it is at
+  // the level of rounding error, R^T * R - a * a^T is not positive definite.
+  if (1.0 - norm_squared <= kDowndateTolerance) {
+    return false;
+  }
+  // Determine the rotations, last one first.
+  std::vector<double> c(n);
+  std::vector<double> &s = p;
+  double alpha = sqrt(1.0 - norm_squared);
+  for (size_t i = n; i-- > 0;) {
+    double scale = alpha + fabs(s[i]);
+    double a_scaled = alpha / scale;
+    double b_scaled = s[i] / scale;
+    double norm = sqrt(a_scaled * a_scaled + b_scaled * b_scaled);
+    c[i] = a_scaled / norm;
+    s[i] = b_scaled / norm;
+    alpha = scale * norm;
+  }
+  // Apply them to R, column by column.
+  for (size_t j = 0; j < n; j++) {
+    double xx = 0.;
+    for (size_t i = j + 1; i-- > 0;) {
+      double t = c[i] * xx + s[i] * R[i * n + j];
+      R[i * n + j] = c[i] * R[i * n + j] - s[i] * xx;
+      xx = t;
+    }
+  }
+  // And to z, which leaves the part of b that was fit to the residual.
+  double zeta = b;
+  for (size_t i = 0; i < n; i++) {
+    z[i] = (z[i] - s[i] * zeta) / c[i];
+    zeta = c[i] * zeta - s[i] * z[i];
+  }
+  double ratio = fabs(zeta) / m_rho;
+  // Rounding can push the residual slightly below zero.
+  m_rho = (ratio < 1.0) ? m_rho * sqrt(1.0 - ratio * ratio) : 0.0;
+  m_num_rows--;
+  return true;
+}
+
+void StreamingLeastSquares::rebuildFromWindow() {
+  m_R = Matrix(m_num_params, m_num_params);
+  m_z = Matrix(1, m_num_params);
+  m_rho = 0.0;
+  m_num_rows = 0;
+  for (const auto &row : m_window) {
+    addRow(row.data(), row.back());
+  }
+}
+
+void StreamingLeastSquares::addRows(const Matrix &A, const Matrix &b) {
+  if (A.width() != m_num_params || b.width() != 1 ||
+      A.height() != b.height()) {
+    throw std::runtime_error(
+        "Expected a " + std::to_string(m_num_params) + "xN A and a 1xN b, "
+        "but got a " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) + " A and a " + std::to_string(b.width()) +
+        "x" + std::to_string(b.height()) + " b.");
+  }
+  std::vector<double> row(m_num_params + 1);
+  for (size_t y = 0; y < A.height(); y++) {
+    for (size_t x = 0; x < m_num_params; x++) {
+      row[x] = A(x, y);
+    }
+    row[m_num_params] = b(0, y);
+    addRow(row.data(), row.back());
+    if (m_window_size == 0) {
+      continue;
+    }
+    m_window.push_back(row);
+    if (m_window.size() > m_window_size) {
+      const auto &oldest = m_window.front();
+      bool removed = removeRow(oldest.data(), oldest.back());
+      m_window.pop_front();
+      if (!removed) {
+        rebuildFromWindow();
+      }
+    }
+  }
+}
+
+bool StreamingLeastSquares::removeRows(const Matrix &A, const Matrix &b) {
+  if (A.width() != m_num_params || b.width() != 1 ||
+      A.height() != b.height()) {
+    throw std::runtime_error(
+        "Expected a " + std::to_string(m_num_params) + "xN A and a 1xN b, "
+        "but got a " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) + " A and a " + std::to_string(b.width()) +
+        "x" + std::to_string(b.height()) + " b.");
+  }
+  std::vector<double> row(m_num_params + 1);
+  for (size_t y = 0; y < A.height(); y++) {
+    for (size_t x = 0; x < m_num_params; x++) {
+      row[x] = A(x, y);
+    }
+    row[m_num_params] = b(0, y);
+    // A removed row must also leave the window, or it would be downdated
+    // again when it slides out.
+    auto in_window = m_window.end();
+    if (m_window_size != 0) {
+      in_window = std::find(m_window.begin(), m_window.end(), row);
+      if (in_window == m_window.end()) {
+        throw std::runtime_error("Row " + std::to_string(y) +
+                                 " is not in the window.");
+      }
+    }
+    if (!removeRow(row.data(), row.back())) {
+      return false;
+    }
+    if (in_window != m_window.end()) {
+      m_window.erase(in_window);
+    }
+  }
+  return true;
+}
+
+Matrix StreamingLeastSquares::solve() const {
+  for (size_t i = 0; i < m_num_params; i++) {
+    if (m_R(i, i) == 0.0) {
+      return Matrix();
+    }
+  }
+  Matrix x = m_z;
+  solveU(m_R, x);
+  return x;
+}
+
+double StreamingLeastSquares::residualNorm() const { return m_rho; }
+
+size_t StreamingLeastSquares::numRows() const { return m_num_rows; }
+
+const Matrix &StreamingLeastSquares::R() const { return m_R; }
+}; // namespace basic_matrix
@@ -0,0 +1,69 @@
+#pragma once
+#include "matrix.hpp"
+#include <deque>
+
+namespace basic_matrix {
+/// Linear least squares over a stream of observations.
+///
+/// Rather than keeping every row of A*x = b, only the num_params x
+/// num_params R factor of A, Q^T * b and the residual norm are kept. New rows
+/// are absorbed with Givens rotations and old rows are removed with a
+/// Cholesky downdate (LINPACK's xCHDD), so each row costs O(num_params^2)
+/// regardless of how many rows came before it.
+///
+/// If window_size is nonzero, only the most recent window_size rows are kept
+/// in the solution; older rows are removed automatically as new ones arrive.
+class StreamingLeastSquares {
+public:
+  StreamingLeastSquares(const size_t &num_params,
+                        const size_t &window_size = 0);
+
+  /// Absorb the rows of A (num_params wide) and the corresponding rows of b
+  /// (one wide).
+  void addRows(const Matrix &A, const Matrix &b);
+
+  /// Remove rows that were previously added. Downdating is less stable than
+  /// updating: if removing a row would leave the normal equations singular
+  /// or indefinite, that row and all rows after it are left in and false is
+  /// returned.
+  /// With a window, each row must still be in the window, or
+  /// std::runtime_error is thrown, and it leaves the window as well.
+  bool removeRows(const Matrix &A, const Matrix &b);
+
+  /// The least squares solution of all rows currently in the system, as a
+  /// num_params x 1 matrix. Costs O(num_params^2). Returns a matrix that is
+  /// not ok() if the system is rank deficient, e.g. because it has fewer
+  /// rows than parameters.
+  Matrix solve() const;
+
+  /// ||A * x - b|| for the current solution x.
+  double residualNorm() const;
+
+  /// Number of rows currently in the system.
+  size_t numRows() const;
+
+  /// The upper-triangular R factor of the rows currently in the system.
+  const Matrix &R() const;
+
+private:
+  /// Rotate one row into R, z and rho.
+  void addRow(const double *a, const double &b);
+  /// Rotate one row out of R, z and rho. Returns false, leaving the state
+  /// unchanged, if the downdated R would not exist.
+  bool removeRow(const double *a, const double &b);
+  /// Recompute the state from the rows in the window.
+  void rebuildFromWindow();
+
+  size_t m_num_params;
+  size_t m_window_size;
+  size_t m_num_rows = 0;
+  /// Upper-triangular R factor.
+  Matrix m_R;
+  /// Q^T * b.
+  Matrix m_z;
+  /// Residual norm.
+  double m_rho = 0.0;
+  /// Rows in the window, [a b], oldest first.
+  std::deque<std::vector<double>> m_window;
+};
+}; // namespace basic_matrix
@@ -0,0 +1,339 @@
+#include "svd.hpp"
+#include "parallel.hpp"
+#include "qr_factorization.hpp"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <numeric>
+#include <random>
+
+namespace basic_matrix {
+namespace {
+/// Make the rows of Q (num_rows x length, row-major) orthonormal where
+/// valid[i] is false, keeping the valid rows as they are. Valid rows must
+/// already be orthonormal. New rows are built from unit vectors by
+/// Gram-Schmidt.
+void completeOrthonormalRows(double *q, const size_t &num_rows,
+                             const size_t &length,
+                             std::vector<bool> valid) {
+  std::vector<double> w(length);
+  size_t candidate = 0;
+  for (size_t i = 0; i < num_rows; i++) {
+    if (valid[i]) {
+      continue;
+    }
+    while (candidate < length) {
+      std::fill(w.begin(), w.end(), 0.0);
+      w[candidate++] = 1.0;
+      for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t j = 0; j < num_rows; j++) {
+          if (!valid[j]) {
+            continue;
+          }
+          const double *qj = &q[j * length];
+          double s = 0.0;
+          for (size_t x = 0; x < length; x++) {
+            s += qj[x] * w[x];
+          }
+          for (size_t x = 0; x < length; x++) {
+            w[x] -= s * qj[x];
+          }
+        }
+      }
+      double norm = 0.0;
+      for (const auto &wx : w) {
+        norm += wx * wx;
+      }
+      norm = sqrt(norm);
+      // A unit vector always has a component of at least 1/sqrt(length)
+      // outside a proper subspace for some candidate; skip the ones mostly
+      // inside it.
+      if (norm > 0.5 / sqrt(double(length))) {
+        for (size_t x = 0; x < length; x++) {
+          q[i * length + x] = w[x] / norm;
+        }
+        valid[i] = true;
+        break;
+      }
+    }
+    if (!valid[i]) {
+      throw std::runtime_error("Could not complete an orthonormal basis.");
+    }
+  }
+}
+
+/// One-sided Jacobi on the n rows (length m, m >= n) of Gt, which hold the
+/// columns of the matrix being decomposed. On output, the rows of Gt are
+/// mutually orthogonal, and the same rotations have been applied to the
+/// rows of Vt (n x n).
+bool jacobiSweeps(std::vector<double> &Gt, std::vector<double> &Vt,
+                  const size_t &n, const size_t &m,
+                  const size_t &max_sweeps) {
+  const double tol = sqrt(double(m)) * std::numeric_limits<double>::epsilon();
+  // Round-robin schedule: with players in a ring, player 0 fixed, round r
+  // pairs slot k with slot N - 1 - k, and the other players rotate by one
+  // between rounds. An odd n gets a dummy player.
+  size_t N = n + n % 2;
+  std::vector<size_t> slots(N);
+  std::iota(slots.begin(), slots.end(), 0);
+  std::vector<char> rotated(N / 2);
+  for (size_t sweep = 0; sweep < max_sweeps; sweep++) {
+    bool any_rotated = false;
+    for (size_t round = 0; round + 1 < N; round++) {
+      parallelFor(
+          0, N / 2,
+          [&](const size_t &k) {
+            rotated[k] = 0;
+            size_t i = std::min(slots[k], slots[N - 1 - k]);
+            size_t j = std::max(slots[k], slots[N - 1 - k]);
+            if (j >= n) {
+              return;
+            }
+            double *gi = &Gt[i * m];
+            double *gj = &Gt[j * m];
+            double alpha = 0.0;
+            double beta = 0.0;
+            double gamma = 0.0;
+            for (size_t x = 0; x < m; x++) {
+              alpha += gi[x] * gi[x];
+              beta += gj[x] * gj[x];
+              gamma += gi[x] * gj[x];
+            }
+            if (alpha == 0.0 || beta == 0.0 ||
+                fabs(gamma) <= tol * sqrt(alpha) * sqrt(beta)) {
+              return;
+            }
+            // The rotation that diagonalizes [alpha gamma; gamma beta].
+            double zeta = (beta - alpha) / (2.0 * gamma);
+            double t = copysign(1.0, zeta) / (fabs(zeta) + hypot(1.0, zeta));
+            double c = 1.0 / hypot(1.0, t);
+            double s = c * t;
+            for (size_t x = 0; x < m; x++) {
+              double a = gi[x];
+              double b = gj[x];
+              gi[x] = c * a - s * b;
+              gj[x] = s * a + c * b;
+            }
+            double *vi = &Vt[i * n];
+            double *vj = &Vt[j * n];
+            for (size_t x = 0; x < n; x++) {
+              double a = vi[x];
+              double b = vj[x];
+              vi[x] = c * a - s * b;
+              vj[x] = s * a + c * b;
+            }
+            rotated[k] = 1;
+          },
+          std::max<size_t>(1, 4096 / std::max<size_t>(m, 1)));
+      for (const auto &r : rotated) {
+        any_rotated = any_rotated || r;
+      }
+      std::rotate(slots.begin() + 1, slots.end() - 1, slots.end());
+    }
+    if (!any_rotated) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// SVD of a matrix with height m >= width n, given by the rows of Gt (its
+/// columns). Fills the rows of Ut (u_i, length m; n of them, or m if full)
+/// and Vt (n x n) and the singular values s, in descending order.
+bool tallSVD(std::vector<double> Gt, const size_t &n, const size_t &m,
+             const bool &full, const size_t &max_sweeps,
+             std::vector<double> &Ut, std::vector<double> &s,
+             std::vector<double> &Vt) {
+  std::vector<double> V(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    V[i * n + i] = 1.0;
+  }
+  bool converged = jacobiSweeps(Gt, V, n, m, max_sweeps);
+  std::vector<double> norms(n);
+  double max_norm = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double sum = 0.0;
+    for (size_t x = 0; x < m; x++) {
+      sum += Gt[i * m + x] * Gt[i * m + x];
+    }
+    norms[i] = sqrt(sum);
+    max_norm = std::max(max_norm, norms[i]);
+  }
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](const size_t &a, const size_t &b) {
+    return norms[a] > norms[b];
+  });
+  size_t num_u = full ? m : n;
+  Ut.assign(num_u * m, 0.0);
+  Vt.resize(n * n);
+  s.resize(n);
+  // Columns this small relative to the largest are numerically zero; their
+  // directions carry no information and are replaced by a completion.
+  double zero = m * std::numeric_limits<double>::epsilon() * max_norm;
+  std::vector<bool> valid(num_u, false);
+  for (size_t i = 0; i < n; i++) {
+    size_t c = order[i];
+    s[i] = norms[c];
+    std::copy(&V[c * n], &V[c * n] + n, &Vt[i * n]);
+    if (norms[c] > zero) {
+      for (size_t x = 0; x < m; x++) {
+        Ut[i * m + x] = Gt[c * m + x] / norms[c];
+      }
+      valid[i] = true;
+    }
+  }
+  completeOrthonormalRows(Ut.data(), num_u, m, valid);
+  return converged;
+}
+
+/// An orthonormal basis of the columns of A (height >= width).
+Matrix orthonormalBasis(const Matrix &A) {
+  Matrix QR = A;
+  Matrix tau;
+  householderQR(QR, tau);
+  return formQ(QR, tau, true);
+}
+
+/// Rows of A^T, i.e. the columns of A.
+std::vector<double> columns(const Matrix &A) {
+  std::vector<double> result(A.width() * A.height());
+  for (size_t y = 0; y < A.height(); y++) {
+    for (size_t x = 0; x < A.width(); x++) {
+      result[x * A.height() + y] = A(x, y);
+    }
+  }
+  return result;
+}
+}; // namespace
+
+bool svd(const Matrix &A, Matrix &U, Matrix &S, Matrix &Vt,
+         const SVDOptions &options) {
+  if (A.height() < A.width()) {
+    // A^T = U' * S * V'^T, so A = V' * S * U'^T.
+    Matrix U_transposed;
+    Matrix Vt_transposed;
+    bool converged =
+        svd(A.transpose(), U_transposed, S, Vt_transposed, options);
+    U = Vt_transposed.transpose();
+    Vt = U_transposed.transpose();
+    return converged;
+  }
+  size_t m = A.height();
+  size_t n = A.width();
+  bool precondition = options.qr_preconditioning && m > n;
+  std::vector<double> Ut_rows;
+  std::vector<double> s;
+  std::vector<double> Vt_rows;
+  bool converged;
+  if (precondition) {
+    // A = Q * R; the SVD of the n x n R gives V and S directly, and
+    // U = Q * [U_R 0; 0 I].
+    Matrix QR = A;
+    Matrix tau;
+    householderQR(QR, tau);
+    Matrix R(n, n);
+    for (size_t y = 0; y < n; y++) {
+      for (size_t x = y; x < n; x++) {
+        R(x, y) = QR(x, y);
+      }
+    }
+    converged = tallSVD(columns(R), n, n, false, options.max_sweeps, Ut_rows,
+                        s, Vt_rows);
+    U = Matrix(options.thin ? n : m, m);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t y = 0; y < n; y++) {
+        U(i, y) = Ut_rows[i * n + y];
+      }
+    }
+    for (size_t i = n; i < U.width(); i++) {
+      U(i, i) = 1.0;
+    }
+    applyQ(QR, tau, U);
+  } else {
+    converged = tallSVD(columns(A), n, m, !options.thin, options.max_sweeps,
+                        Ut_rows, s, Vt_rows);
+    size_t num_u = options.thin ? n : m;
+    U = Matrix(num_u, m);
+    for (size_t i = 0; i < num_u; i++) {
+      for (size_t y = 0; y < m; y++) {
+        U(i, y) = Ut_rows[i * m + y];
+      }
+    }
+  }
+  S = Matrix(1, n);
+  std::copy(s.begin(), s.end(), S.data());
+  Vt = Matrix(n, n);
+  std::copy(Vt_rows.begin(), Vt_rows.end(), Vt.data());
+  return converged;
+}
+
+Matrix singularValues(const Matrix &A) {
+  Matrix U;
+  Matrix S;
+  Matrix Vt;
+  SVDOptions options;
+  options.thin = true;
+  if (!svd(A, U, S, Vt, options)) {
+    return Matrix();
+  }
+  return S;
+}
+
+Matrix randomizedRangeFinder(const Matrix &A, const size_t &l,
+                             const size_t &power_iterations,
+                             const size_t &seed) {
+  size_t m = A.height();
+  size_t n = A.width();
+  if (l == 0 || l > std::min(m, n)) {
+    throw std::runtime_error(
+        "The sketch size must be between 1 and min(height, width).");
+  }
+  std::mt19937 gen(seed);
+  std::normal_distribution<double> dist;
+  Matrix Omega(l, n);
+  for (size_t i = 0; i < l * n; i++) {
+    Omega.data()[i] = dist(gen);
+  }
+  Matrix Q = orthonormalBasis(A * Omega);
+  for (size_t q = 0; q < power_iterations; q++) {
+    // A^T * Q is computed as (Q^T * A)^T, which never forms A^T.
+    Matrix Z = orthonormalBasis((Q.transpose() * A).transpose());
+    Q = orthonormalBasis(A * Z);
+  }
+  return Q;
+}
+
+bool randomizedSVD(const Matrix &A, const size_t &k, Matrix &U, Matrix &S,
+                   Matrix &Vt, const RandomizedSVDOptions &options) {
+  size_t r = std::min(A.width(), A.height());
+  if (k == 0 || k > r) {
+    throw std::runtime_error(
+        "The rank must be between 1 and min(height, width).");
+  }
+  size_t l = std::min(k + options.oversampling, r);
+  Matrix Q =
+      randomizedRangeFinder(A, l, options.power_iterations, options.seed);
+  Matrix B = Q.transpose() * A;
+  Matrix U_B;
+  Matrix S_B;
+  Matrix Vt_B;
+  SVDOptions svd_options;
+  svd_options.thin = true;
+  if (!svd(B, U_B, S_B, Vt_B, svd_options)) {
+    return false;
+  }
+  Matrix U_k(k, l);
+  for (size_t y = 0; y < l; y++) {
+    for (size_t x = 0; x < k; x++) {
+      U_k(x, y) = U_B(x, y);
+    }
+  }
+  U = Q * U_k;
+  S = Matrix(1, k);
+  std::copy(S_B.data(), S_B.data() + k, S.data());
+  Vt = Matrix(A.width(), k);
+  std::copy(Vt_B.data(), Vt_B.data() + k * A.width(), Vt.data());
+  return true;
+}
+}; // namespace basic_matrix
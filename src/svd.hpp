@@ -0,0 +1,81 @@
+#pragma once
+#include "matrix.hpp"
+
+namespace basic_matrix {
+struct SVDOptions {
+  /// Compute the thin (economy-size) SVD: for an m x n A and r = min(m, n),
+  /// U is m x r and Vt is r x n instead of m x m and n x n.
+  bool thin = false;
+
+  /// QR-factor tall (and, through the transpose, wide) matrices first and
+  /// run Jacobi on the small square R. This is much cheaper when
+  /// height >> width, and makes Jacobi converge in fewer sweeps.
+  bool qr_preconditioning = true;
+
+  /// Maximum number of Jacobi sweeps over all column pairs.
+  size_t max_sweeps = 60;
+};
+
+/// Singular value decomposition, A = U * diag(S) * Vt, by one-sided
+/// (Hestenes) Jacobi.
+///
+/// Plane rotations are applied to pairs of columns of A until all columns
+/// are mutually orthogonal; the column norms are then the singular values,
+/// the normalized columns U, and the accumulated rotations V. Each sweep
+/// visits all column pairs in round-robin (tournament) order, whose rounds
+/// consist of disjoint pairs, so the rotations of a round run in parallel.
+/// Jacobi computes small singular values to high relative accuracy.
+///
+/// out: U, orthogonal, m x m (or m x r if options.thin).
+/// out: S, the r x 1 singular values in descending order.
+/// out: Vt, orthogonal, n x n (or r x n if options.thin).
+/// Returns false if the columns are not orthogonal after
+/// options.max_sweeps sweeps.
+bool svd(const Matrix &A, Matrix &U, Matrix &S, Matrix &Vt,
+         const SVDOptions &options = SVDOptions());
+
+/// The singular values of A, in descending order, as a min(m, n) x 1
+/// matrix. Returns a matrix that is not ok() if Jacobi does not converge.
+Matrix singularValues(const Matrix &A);
+
+struct RandomizedSVDOptions {
+  /// Extra sketch columns beyond the requested rank. A few more than k make
+  /// the captured range much more reliable.
+  size_t oversampling = 10;
+
+  /// Number of power iterations, (A * A^T)^q * A * Omega. Each sharpens the
+  /// decay of the spectrum the sketch sees, at the cost of two passes over
+  /// A.
+  size_t power_iterations = 2;
+
+  /// Seed of the Gaussian test matrix; equal seeds give equal results.
+  size_t seed = 0;
+};
+
+/// An m x l matrix with orthonormal columns whose range approximates the
+/// range of the m x n matrix A (Halko, Martinsson and Tropp's randomized
+/// range finder).
+///
+/// A is multiplied by an n x l Gaussian test matrix, optionally followed by
+/// power iterations, re-orthonormalizing with a thin QR factorization after
+/// every product with A or A^T. All of the work is in products with A.
+Matrix randomizedRangeFinder(const Matrix &A, const size_t &l,
+                             const size_t &power_iterations = 2,
+                             const size_t &seed = 0);
+
+/// Rank-k truncated SVD, A ~= U * diag(S) * Vt, by randomized projection.
+///
+/// Q = randomizedRangeFinder(A, k + oversampling) captures the dominant
+/// range of A, and the small (k + oversampling) x n matrix B = Q^T * A is
+/// decomposed with svd. Then U = Q * U_B. The cost is a few passes of
+/// matrix multiplication over A, O(m * n * k), instead of the O(m * n^2) of
+/// a full SVD.
+///
+/// out: U, m x k with orthonormal columns.
+/// out: S, the k x 1 largest singular values, in descending order.
+/// out: Vt, k x n with orthonormal rows.
+/// Returns false if the SVD of the projection does not converge.
+bool randomizedSVD(
+    const Matrix &A, const size_t &k, Matrix &U, Matrix &S, Matrix &Vt,
+    const RandomizedSVDOptions &options = RandomizedSVDOptions());
+}; // namespace basic_matrix
@@ -0,0 +1,589 @@
+#include "symmetric_eigenvalues.hpp"
+#include "eigenvalues.hpp"
+#include "parallel.hpp"
+#include "qr_factorization.hpp"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <numeric>
+
+namespace basic_matrix {
+namespace {
+constexpr size_t kPanelSize = 32;
+// Tridiagonal problems this small are solved directly with QL; the merge
+// overhead of divide-and-conquer does not pay off below this.
+constexpr size_t kDivideAndConquerMinSize = 32;
+constexpr size_t kParallelMergeMinSize = 128;
+constexpr size_t kMaxQLIterations = 60;
+constexpr size_t kMaxSecularIterations = 200;
+
+/// Implicit QL with Wilkinson shifts on the tridiagonal matrix (d, e), after
+/// EISPACK's tql2. On output, d holds the eigenvalues in ascending order.
+/// If zt is not null, it is an n x n row-major matrix whose rows are rotated
+/// along; starting from the identity, row i ends up as the eigenvector of
+/// d[i].
+bool tridiagonalQL(std::vector<double> &d, std::vector<double> e,
+                   double *zt) {
+  const double eps = std::numeric_limits<double>::epsilon();
+  size_t n = d.size();
+  e.resize(n, 0.0);
+  if (n > 0) {
+    e[n - 1] = 0.0;
+  }
+  for (size_t l = 0; l < n; l++) {
+    size_t iter = 0;
+    size_t m;
+    do {
+      for (m = l; m + 1 < n; m++) {
+        double dd = fabs(d[m]) + fabs(d[m + 1]);
+        if (fabs(e[m]) <= eps * dd) {
+          break;
+        }
+      }
+      if (m == l) {
+        break;
+      }
+      if (iter++ == kMaxQLIterations) {
+        return false;
+      }
+      double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+      double r = hypot(g, 1.0);
+      g = d[m] - d[l] + e[l] / (g + copysign(r, g));
+      double s = 1.0;
+      double c = 1.0;
+      double p = 0.0;
+      bool underflow = false;
+      for (size_t i = m; i-- > l;) {
+        double f = s * e[i];
+        double b = c * e[i];
+        r = hypot(f, g);
+        e[i + 1] = r;
+        if (r == 0.0) {
+          // Recover from underflow by restarting the sweep.
+          d[i + 1] -= p;
+          e[m] = 0.0;
+          underflow = true;
+          break;
+        }
+        s = f / r;
+        c = g / r;
+        g = d[i + 1] - p;
+        r = (d[i] - g) * s + 2.0 * c * b;
+        p = s * r;
+        d[i + 1] = g + p;
+        g = c * r - b;
+        if (zt != nullptr) {
+          double *zi = &zt[i * n];
+          double *zi1 = &zt[(i + 1) * n];
+          for (size_t k = 0; k < n; k++) {
+            double zf = zi1[k];
+            zi1[k] = s * zi[k] + c * zf;
+            zi[k] = c * zi[k] - s * zf;
+          }
+        }
+      }
+      if (underflow) {
+        continue;
+      }
+      d[l] -= p;
+      e[l] = g;
+      e[m] = 0.0;
+    } while (m != l);
+  }
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](const size_t &a, const size_t &b) { return d[a] < d[b]; });
+  std::vector<double> sorted(n);
+  for (size_t i = 0; i < n; i++) {
+    sorted[i] = d[order[i]];
+  }
+  d = sorted;
+  if (zt != nullptr) {
+    std::vector<double> rows(zt, zt + n * n);
+    for (size_t i = 0; i < n; i++) {
+      std::copy(&rows[order[i] * n], &rows[order[i] * n] + n, &zt[i * n]);
+    }
+  }
+  return true;
+}
+
+/// One root of the secular equation
+///   f(lambda) = 1 + rho * sum_j z_j^2 / (d_j - lambda) = 0,
+/// stored as an offset tau from the pole d[origin] it is closest to. Keeping
+/// the offset, rather than lambda itself, lets d_j - lambda be computed as
+/// (d_j - d_origin) - tau without cancellation.
+struct SecularRoot {
+  size_t origin;
+  double tau;
+};
+
+double secularFunction(const std::vector<double> &d,
+                       const std::vector<double> &z, const double &rho,
+                       const size_t &origin, const double &tau,
+                       double &derivative) {
+  double f = 1.0;
+  derivative = 0.0;
+  for (size_t j = 0; j < d.size(); j++) {
+    double t = z[j] / ((d[j] - d[origin]) - tau);
+    f += rho * z[j] * t;
+    derivative += rho * t * t;
+  }
+  return f;
+}
+
+/// Find root i of the secular equation for ascending poles d, rho > 0 and
+/// nonzero z. Root i lies between d[i] and d[i+1], or above d[k-1] for the
+/// last one. Newton's method is safeguarded by bisection.
+SecularRoot solveSecularEquation(const std::vector<double> &d,
+                                 const std::vector<double> &z,
+                                 const double &rho, const size_t &i) {
+  const double eps = std::numeric_limits<double>::epsilon();
+  size_t k = d.size();
+  SecularRoot root;
+  double lo = 0.0;
+  double hi = 0.0;
+  double derivative;
+  if (i + 1 < k) {
+    double half_gap = (d[i + 1] - d[i]) / 2.0;
+    if (secularFunction(d, z, rho, i, half_gap, derivative) >= 0.0) {
+      root.origin = i;
+      hi = half_gap;
+    } else {
+      root.origin = i + 1;
+      lo = -half_gap;
+    }
+  } else {
+    root.origin = i;
+    for (const auto &zj : z) {
+      hi += rho * zj * zj;
+    }
+  }
+  double tau = (lo + hi) / 2.0;
+  for (size_t iter = 0; iter < kMaxSecularIterations; iter++) {
+    double f = secularFunction(d, z, rho, root.origin, tau, derivative);
+    if (f == 0.0) {
+      break;
+    }
+    if (f > 0.0) {
+      hi = tau;
+    } else {
+      lo = tau;
+    }
+    double next = tau - f / derivative;
+    if (!(next > lo && next < hi)) {
+      next = (lo + hi) / 2.0;
+    }
+    bool converged = fabs(next - tau) <= 2.0 * eps * fabs(next) ||
+                     hi - lo <= 2.0 * eps * std::max(fabs(lo), fabs(hi));
+    tau = next;
+    if (converged) {
+      break;
+    }
+  }
+  root.tau = tau;
+  return root;
+}
+
+/// Solve the tridiagonal eigenproblem (d, e) by divide-and-conquer. On
+/// output, d holds the eigenvalues in ascending order and q the n x n
+/// row-major eigenvector matrix, eigenvectors in columns.
+bool divideAndConquer(std::vector<double> &d, const std::vector<double> &e,
+                      std::vector<double> &q, const size_t &depth) {
+  const double eps = std::numeric_limits<double>::epsilon();
+  size_t n = d.size();
+  if (n <= kDivideAndConquerMinSize) {
+    std::vector<double> zt(n * n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+      zt[i * n + i] = 1.0;
+    }
+    if (!tridiagonalQL(d, e, zt.data())) {
+      return false;
+    }
+    q.resize(n * n);
+    for (size_t r = 0; r < n; r++) {
+      for (size_t c = 0; c < n; c++) {
+        q[r * n + c] = zt[c * n + r];
+      }
+    }
+    return true;
+  }
+
+  // Tear T into diag(T1, T2) + beta * u * u^T, u = e_(m-1) + e_m.
+  size_t m = n / 2;
+  size_t n2 = n - m;
+  double beta = e[m - 1];
+  std::vector<double> d1(d.begin(), d.begin() + m);
+  std::vector<double> d2(d.begin() + m, d.end());
+  std::vector<double> e1(e.begin(), e.begin() + m - 1);
+  std::vector<double> e2(e.begin() + m, e.end());
+  d1[m - 1] -= beta;
+  d2[0] -= beta;
+  std::vector<double> q1;
+  std::vector<double> q2;
+  bool ok[2] = {true, true};
+  auto solveHalf = [&](const size_t &half) {
+    ok[half] = half == 0 ? divideAndConquer(d1, e1, q1, depth + 1)
+                         : divideAndConquer(d2, e2, q2, depth + 1);
+  };
+  if (n >= kParallelMergeMinSize && (size_t(1) << depth) < numThreads()) {
+    parallelFor(0, 2, solveHalf);
+  } else {
+    solveHalf(0);
+    solveHalf(1);
+  }
+  if (!ok[0] || !ok[1]) {
+    return false;
+  }
+
+  // Now T = Q * (D + rho * z * z^T) * Q^T with Q = diag(Q1, Q2) and
+  // z = Q^T * u. Make rho positive (negating D if needed) and z a unit
+  // vector, then sort the poles. qs holds the columns of Q as rows.
+  double rho = beta;
+  double sign = 1.0;
+  if (rho < 0.0) {
+    rho = -rho;
+    sign = -1.0;
+  }
+  rho *= 2.0;
+  std::vector<double> D(n);
+  std::vector<double> z(n);
+  for (size_t i = 0; i < m; i++) {
+    D[i] = sign * d1[i];
+    z[i] = q1[(m - 1) * m + i] / sqrt(2.0);
+  }
+  for (size_t i = 0; i < n2; i++) {
+    D[m + i] = sign * d2[i];
+    z[m + i] = q2[i] / sqrt(2.0);
+  }
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](const size_t &a, const size_t &b) { return D[a] < D[b]; });
+  std::vector<double> Ds(n);
+  std::vector<double> zs(n);
+  std::vector<double> qs(n * n, 0.0);
+  double d_max = 0.0;
+  double z_max = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    size_t c = order[i];
+    Ds[i] = D[c];
+    zs[i] = z[c];
+    d_max = std::max(d_max, fabs(Ds[i]));
+    z_max = std::max(z_max, fabs(zs[i]));
+    double *row = &qs[i * n];
+    if (c < m) {
+      for (size_t r = 0; r < m; r++) {
+        row[r] = q1[r * m + c];
+      }
+    } else {
+      for (size_t r = 0; r < n2; r++) {
+        row[m + r] = q2[r * n2 + c - m];
+      }
+    }
+  }
+
+  // Deflation: a negligible z_j leaves (D_j, q_j) as an eigenpair, and so
+  // does a pole within tol of its predecessor after a Givens rotation
+  // moves all of the pair's weight in z onto one of them.
+  double tol = 8.0 * eps * std::max(d_max, rho * z_max);
+  std::vector<size_t> kept;
+  std::vector<size_t> deflated;
+  for (size_t j = 0; j < n; j++) {
+    if (rho * fabs(zs[j]) <= tol) {
+      deflated.push_back(j);
+      continue;
+    }
+    if (!kept.empty()) {
+      size_t i = kept.back();
+      double r = hypot(zs[i], zs[j]);
+      double c = zs[j] / r;
+      double s = zs[i] / r;
+      if (fabs((Ds[j] - Ds[i]) * c * s) <= tol) {
+        zs[i] = 0.0;
+        zs[j] = r;
+        double *qi = &qs[i * n];
+        double *qj = &qs[j * n];
+        for (size_t x = 0; x < n; x++) {
+          double a = qi[x];
+          double b = qj[x];
+          qi[x] = c * a - s * b;
+          qj[x] = s * a + c * b;
+        }
+        double di = c * c * Ds[i] + s * s * Ds[j];
+        Ds[j] = s * s * Ds[i] + c * c * Ds[j];
+        Ds[i] = di;
+        kept.back() = j;
+        deflated.push_back(i);
+        continue;
+      }
+    }
+    kept.push_back(j);
+  }
+
+  // Solve the secular equation for the remaining k poles.
+  size_t k = kept.size();
+  std::vector<double> dk(k);
+  std::vector<double> zk(k);
+  for (size_t i = 0; i < k; i++) {
+    dk[i] = Ds[kept[i]];
+    zk[i] = zs[kept[i]];
+  }
+  std::vector<SecularRoot> roots(k);
+  parallelFor(
+      0, k,
+      [&](const size_t &i) { roots[i] = solveSecularEquation(dk, zk, rho, i); },
+      16);
+  // lambda_i - d_j, computed from the root's offset.
+  auto gap = [&](const size_t &i, const size_t &j) {
+    return (dk[roots[i].origin] - dk[j]) + roots[i].tau;
+  };
+  // Gu-Eisenstat: recompute z so the computed roots are the exact
+  // eigenvalues of D + rho * z_hat * z_hat^T. Eigenvectors built from z_hat
+  // are then numerically orthogonal.
+  std::vector<double> z_hat(k);
+  parallelFor(
+      0, k,
+      [&](const size_t &j) {
+        double prod = gap(k - 1, j) / rho;
+        for (size_t i = 0; i < j; i++) {
+          prod *= gap(i, j) / (dk[i] - dk[j]);
+        }
+        for (size_t i = j + 1; i < k; i++) {
+          prod *= gap(i - 1, j) / (dk[i] - dk[j]);
+        }
+        z_hat[j] = copysign(sqrt(fabs(prod)), zk[j]);
+      },
+      16);
+  // Eigenvectors of D + rho * z_hat * z_hat^T, as the rows of U^T, then
+  // the eigenvectors of T as the rows of U^T * Q_k^T.
+  Matrix Ut(k, k);
+  Matrix QkT(n, k);
+  parallelFor(
+      0, k,
+      [&](const size_t &i) {
+        double *u = &Ut.data()[i * k];
+        double norm = 0.0;
+        for (size_t j = 0; j < k; j++) {
+          u[j] = z_hat[j] / ((dk[j] - dk[roots[i].origin]) - roots[i].tau);
+          norm += u[j] * u[j];
+        }
+        norm = sqrt(norm);
+        for (size_t j = 0; j < k; j++) {
+          u[j] /= norm;
+        }
+        std::copy(&qs[kept[i] * n], &qs[kept[i] * n] + n,
+                  &QkT.data()[i * n]);
+      },
+      16);
+  Matrix VT = k > 0 ? Ut * QkT : Matrix(n, 0);
+
+  // Gather the eigenpairs in ascending order.
+  std::vector<std::pair<double, const double *>> pairs;
+  pairs.reserve(n);
+  for (size_t i = 0; i < k; i++) {
+    double lambda = dk[roots[i].origin] + roots[i].tau;
+    pairs.emplace_back(sign * lambda, &VT.data()[i * n]);
+  }
+  for (const auto &j : deflated) {
+    pairs.emplace_back(sign * Ds[j], &qs[j * n]);
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  q.resize(n * n);
+  for (size_t c = 0; c < n; c++) {
+    d[c] = pairs[c].first;
+    for (size_t r = 0; r < n; r++) {
+      q[r * n + c] = pairs[c].second[r];
+    }
+  }
+  return true;
+}
+
+void toVectors(const Matrix &diagonal, const Matrix &off_diagonal,
+               std::vector<double> &d, std::vector<double> &e) {
+  d.resize(diagonal.height());
+  e.resize(off_diagonal.height());
+  for (size_t i = 0; i < d.size(); i++) {
+    d[i] = diagonal(0, i);
+  }
+  for (size_t i = 0; i < e.size(); i++) {
+    e[i] = off_diagonal(0, i);
+  }
+}
+}; // namespace
+
+void tridiagonalize(Matrix &A, Matrix &diagonal, Matrix &off_diagonal,
+                    Matrix &tau) {
+  if (A.height() != A.width()) {
+    throw std::runtime_error("Cannot tridiagonalize a non-square matrix.");
+  }
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    tridiagonalize(A_contiguous, diagonal, off_diagonal, tau);
+    A = A_contiguous;
+    return;
+  }
+  size_t n = A.height();
+  diagonal = Matrix(1, n);
+  off_diagonal = Matrix(1, n > 0 ? n - 1 : 0);
+  tau = Matrix(1, n > 0 ? n - 1 : 0);
+  if (n == 0) {
+    return;
+  }
+  double *a = A.data();
+  std::vector<double> v(n);
+  std::vector<double> w(n);
+  std::vector<double> vtv(kPanelSize);
+  std::vector<double> wtv(kPanelSize);
+  for (size_t k0 = 0; k0 + 1 < n; k0 += kPanelSize) {
+    size_t nb = std::min(kPanelSize, n - 1 - k0);
+    // Row r of V and W is row k0 + r of the reflectors and of the
+    // corresponding columns of W. Until the panel is done, A itself stays
+    // as it was at the start of the panel, apart from its columns in the
+    // panel, so every use of A is corrected by V and W on the fly.
+    Matrix V(nb, n - k0);
+    Matrix W(nb, n - k0);
+    double *vp = V.data();
+    double *wp = W.data();
+    for (size_t j = 0; j < nb; j++) {
+      size_t i = k0 + j;
+      const double *vi = &vp[(i - k0) * nb];
+      const double *wi = &wp[(i - k0) * nb];
+      for (size_t r = i; r < n; r++) {
+        const double *vr = &vp[(r - k0) * nb];
+        const double *wr = &wp[(r - k0) * nb];
+        double s = 0.0;
+        for (size_t l = 0; l < j; l++) {
+          s += vr[l] * wi[l] + wr[l] * vi[l];
+        }
+        a[r * n + i] -= s;
+      }
+      diagonal(0, i) = a[i * n + i];
+      double *x = i + 2 < n ? &a[(i + 2) * n + i] : nullptr;
+      double t = householderReflector(&a[(i + 1) * n + i], x, n - i - 2, n);
+      off_diagonal(0, i) = a[(i + 1) * n + i];
+      tau(0, i) = t;
+      v[i + 1] = 1.0;
+      for (size_t r = i + 2; r < n; r++) {
+        v[r] = a[r * n + i];
+      }
+      for (size_t r = i + 1; r < n; r++) {
+        vp[(r - k0) * nb + j] = v[r];
+      }
+      if (t == 0.0) {
+        continue;
+      }
+      // w = t * (A - V * W^T - W * V^T) * v over the trailing block, then
+      // w -= (t / 2) * (w^T * v) * v, so A -= v * w^T + w * v^T applies the
+      // reflector from both sides.
+      for (size_t l = 0; l < j; l++) {
+        vtv[l] = 0.0;
+        wtv[l] = 0.0;
+      }
+      for (size_t r = i + 1; r < n; r++) {
+        const double *vr = &vp[(r - k0) * nb];
+        const double *wr = &wp[(r - k0) * nb];
+        for (size_t l = 0; l < j; l++) {
+          vtv[l] += vr[l] * v[r];
+          wtv[l] += wr[l] * v[r];
+        }
+      }
+      double wv = 0.0;
+      for (size_t r = i + 1; r < n; r++) {
+        const double *row = &a[r * n];
+        const double *vr = &vp[(r - k0) * nb];
+        const double *wr = &wp[(r - k0) * nb];
+        double s = 0.0;
+        for (size_t c = i + 1; c < n; c++) {
+          s += row[c] * v[c];
+        }
+        for (size_t l = 0; l < j; l++) {
+          s -= vr[l] * wtv[l] + wr[l] * vtv[l];
+        }
+        w[r] = t * s;
+        wv += w[r] * v[r];
+      }
+      double alpha = -0.5 * t * wv;
+      for (size_t r = i + 1; r < n; r++) {
+        wp[(r - k0) * nb + j] = w[r] + alpha * v[r];
+      }
+    }
+    // Apply the whole panel to the trailing block as a rank-2nb update.
+    size_t s = k0 + nb;
+    if (s < n) {
+      size_t m = n - s;
+      Matrix Vs(nb, m);
+      Matrix Ws(nb, m);
+      std::copy(&vp[(s - k0) * nb], &vp[(s - k0) * nb] + m * nb, Vs.data());
+      std::copy(&wp[(s - k0) * nb], &wp[(s - k0) * nb] + m * nb, Ws.data());
+      Matrix P = Vs * Ws.transpose();
+      const double *p = P.data();
+      parallelFor(
+          0, m,
+          [&](const size_t &r) {
+            double *row = &a[(s + r) * n + s];
+            for (size_t c = 0; c < m; c++) {
+              row[c] -= p[r * m + c] + p[c * m + r];
+            }
+          },
+          64);
+    }
+  }
+  diagonal(0, n - 1) = a[(n - 1) * n + n - 1];
+}
+
+bool tridiagonalEigen(const Matrix &diagonal, const Matrix &off_diagonal,
+                      Matrix &values, Matrix &vectors) {
+  if (off_diagonal.height() + 1 != diagonal.height() &&
+      !(diagonal.height() == 0 && off_diagonal.height() == 0)) {
+    throw std::runtime_error(
+        "The off-diagonal of a tridiagonal matrix must have one element "
+        "fewer than its diagonal.");
+  }
+  std::vector<double> d;
+  std::vector<double> e;
+  toVectors(diagonal, off_diagonal, d, e);
+  size_t n = d.size();
+  std::vector<double> q;
+  if (n > 0 && !divideAndConquer(d, e, q, 0)) {
+    return false;
+  }
+  values = Matrix(1, n);
+  vectors = Matrix(n, n);
+  std::copy(d.begin(), d.end(), values.data());
+  std::copy(q.begin(), q.end(), vectors.data());
+  return true;
+}
+
+bool symmetricEigen(const Matrix &A, Matrix &values, Matrix &vectors) {
+  Matrix H = A;
+  Matrix diagonal;
+  Matrix off_diagonal;
+  Matrix tau;
+  tridiagonalize(H, diagonal, off_diagonal, tau);
+  Matrix Z;
+  if (!tridiagonalEigen(diagonal, off_diagonal, values, Z)) {
+    return false;
+  }
+  vectors = formHessenbergQ(H, tau) * Z;
+  return true;
+}
+
+Matrix symmetricEigenvalues(const Matrix &A) {
+  Matrix H = A;
+  Matrix diagonal;
+  Matrix off_diagonal;
+  Matrix tau;
+  tridiagonalize(H, diagonal, off_diagonal, tau);
+  std::vector<double> d;
+  std::vector<double> e;
+  toVectors(diagonal, off_diagonal, d, e);
+  if (!tridiagonalQL(d, e, nullptr)) {
+    return Matrix();
+  }
+  Matrix result(1, d.size());
+  std::copy(d.begin(), d.end(), result.data());
+  return result;
+}
+}; // namespace basic_matrix
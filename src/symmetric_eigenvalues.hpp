@@ -0,0 +1,55 @@
+#pragma once
+#include "matrix.hpp"
+
+namespace basic_matrix {
+/// Reduce the symmetric matrix A to tridiagonal form, T = Q^T * A * Q, in
+/// place.
+///
+/// Reflectors are generated a panel at a time (LAPACK's xLATRD), and the
+/// trailing matrix is updated once per panel with the rank-2k update
+/// A -= V * W^T + W * V^T, so most of the work is matrix multiplication.
+/// Both triangles of A must be filled in.
+///
+/// On output, the reflectors are stored below the subdiagonal of A exactly
+/// as hessenbergReduction stores them, so formHessenbergQ can form Q.
+///
+/// in/out: A
+/// out: diagonal, the n x 1 diagonal of T.
+/// out: off_diagonal, the (n-1) x 1 sub- and superdiagonal of T.
+/// out: tau, the reflector scales.
+void tridiagonalize(Matrix &A, Matrix &diagonal, Matrix &off_diagonal,
+                    Matrix &tau);
+
+/// Compute the eigenvalues and eigenvectors of a symmetric tridiagonal
+/// matrix with Cuppen's divide-and-conquer method.
+///
+/// The matrix is split in half by a rank-one tear, both halves are solved
+/// recursively (in parallel), and the halves are merged by solving the
+/// secular equation of the rank-one update. Eigenvectors of the merge are
+/// computed with the Gu-Eisenstat formula, so they stay orthogonal even for
+/// close eigenvalues. Small problems are solved with the implicit QL
+/// algorithm.
+///
+/// in: diagonal, n x 1.
+/// in: off_diagonal, (n-1) x 1.
+/// out: values, the n x 1 eigenvalues in ascending order.
+/// out: vectors, n x n, with the eigenvector of values(0, i) in column i.
+/// Returns false if the QL iterations fail to converge.
+bool tridiagonalEigen(const Matrix &diagonal, const Matrix &off_diagonal,
+                      Matrix &values, Matrix &vectors);
+
+/// Compute the eigenvalues and eigenvectors of the symmetric matrix A by
+/// tridiagonalization followed by tridiagonalEigen. Only symmetric input
+/// gives meaningful results; this is not checked.
+///
+/// out: values, the n x 1 eigenvalues in ascending order.
+/// out: vectors, n x n, with the eigenvector of values(0, i) in column i.
+/// Returns false if the algorithm fails to converge.
+bool symmetricEigen(const Matrix &A, Matrix &values, Matrix &vectors);
+
+/// Compute only the eigenvalues of the symmetric matrix A, in ascending
+/// order, as an n x 1 matrix. After tridiagonalization this takes O(n^2)
+/// with the implicit QL algorithm. Returns a matrix that is not ok() if the
+/// algorithm fails to converge.
+Matrix symmetricEigenvalues(const Matrix &A);
+}; // namespace basic_matrix
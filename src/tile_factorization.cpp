@@ -0,0 +1,347 @@
+#include "tile_factorization.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
+namespace basic_matrix {
+namespace {
+/// The tiles of an n x n matrix, and the last task that wrote each of them.
+/// A task that reads or writes a tile depends on its last writer. Neither
+/// factorization writes a tile after another task has read it, so that is
+/// every dependency there is.
+class TileGrid {
+public:
+  TileGrid(const size_t &n, const size_t &tile_size)
+      : m_n(n), m_tile_size(tile_size),
+        m_count((n + tile_size - 1) / tile_size),
+        m_last_writer(m_count * m_count, kNone) {}
+
+  /// The number of tiles per row and column.
+  size_t count() const { return m_count; }
+  /// The first row or column of tile t.
+  size_t begin(const size_t &t) const { return t * m_tile_size; }
+  /// One past the last row or column of tile t.
+  size_t end(const size_t &t) const {
+    return std::min(m_n, (t + 1) * m_tile_size);
+  }
+
+  /// Add a task that reads and writes the given tiles, as (row, column)
+  /// pairs; only the written ones are listed in writes.
+  void add(TaskGraph &graph, const std::function<void()> &fn,
+           const std::vector<std::pair<size_t, size_t>> &reads,
+           const std::vector<std::pair<size_t, size_t>> &writes,
+           const bool &critical) {
+    std::vector<size_t> dependencies;
+    for (const auto &tiles : {reads, writes}) {
+      for (const auto &tile : tiles) {
+        size_t writer = m_last_writer[tile.first * m_count + tile.second];
+        if (writer != kNone) {
+          dependencies.push_back(writer);
+        }
+      }
+    }
+    size_t id = graph.add(fn, dependencies, critical);
+    for (const auto &tile : writes) {
+      m_last_writer[tile.first * m_count + tile.second] = id;
+    }
+  }
+
+private:
+  static const size_t kNone = ~size_t(0);
+  size_t m_n;
+  size_t m_tile_size;
+  size_t m_count;
+  std::vector<size_t> m_last_writer;
+};
+
+void checkTileSize(const size_t &tile_size) {
+  if (tile_size == 0) {
+    throw std::runtime_error("The tile size must be positive.");
+  }
+}
+
+/// Factor columns [begin, end) of the rows from begin down, with partial
+/// pivoting over the whole column. Rows are only swapped within these
+/// columns; the other columns are swapped by the tasks that read them.
+void factorPanel(double *a, const size_t &n, const size_t &begin,
+                 const size_t &end, std::vector<size_t> &pivots,
+                 std::atomic<bool> &singular) {
+  for (size_t k = begin; k < end; k++) {
+    size_t p = k;
+    for (size_t y = k + 1; y < n; y++) {
+      if (fabs(a[y * n + k]) > fabs(a[p * n + k])) {
+        p = y;
+      }
+    }
+    pivots[k] = p;
+    if (a[p * n + k] == 0.0) {
+      singular = true;
+      continue;
+    }
+    if (p != k) {
+      std::swap_ranges(&a[k * n + begin], &a[k * n + end], &a[p * n + begin]);
+    }
+    const double *pivot_row = &a[k * n];
+    for (size_t y = k + 1; y < n; y++) {
+      double *row = &a[y * n];
+      double l = row[k] / pivot_row[k];
+      row[k] = l;
+      for (size_t x = k + 1; x < end; x++) {
+        row[x] -= l * pivot_row[x];
+      }
+    }
+  }
+}
+
+/// Apply the row swaps of steps [begin, end) to columns [x_begin, x_end).
+void swapRows(double *a, const size_t &n, const std::vector<size_t> &pivots,
+              const size_t &begin, const size_t &end, const size_t &x_begin,
+              const size_t &x_end) {
+  for (size_t k = begin; k < end; k++) {
+    if (pivots[k] != k) {
+      std::swap_ranges(&a[k * n + x_begin], &a[k * n + x_end],
+                       &a[pivots[k] * n + x_begin]);
+    }
+  }
+}
+
+/// Cholesky factorization of the lower triangle of an n x n matrix whose
+/// row y starts at rows[y]. Only entries on and below the diagonal are
+/// read or written, so the rows may be dense or packed.
+bool tileCholeskyRows(const std::vector<double *> &rows, const size_t &n,
+                      const size_t &tile_size) {
+  // Once a pivot is not positive, the remaining tasks are skipped.
+  std::atomic<bool> failed(false);
+  TileGrid tiles(n, tile_size);
+  size_t count = tiles.count();
+  TaskGraph graph;
+  for (size_t k = 0; k < count; k++) {
+    size_t k_begin = tiles.begin(k);
+    size_t k_end = tiles.end(k);
+    // Factor the diagonal tile, row by row: L(x, y) is A(x, y) minus the
+    // dot product of the first x entries of rows x and y of L.
+    tiles.add(
+        graph,
+        [=, &rows, &failed]() {
+          if (failed) {
+            return;
+          }
+          for (size_t y = k_begin; y < k_end; y++) {
+            double *row = rows[y];
+            for (size_t x = k_begin; x <= y; x++) {
+              const double *x_row = rows[x];
+              double sum = row[x];
+              for (size_t p = k_begin; p < x; p++) {
+                sum -= row[p] * x_row[p];
+              }
+              if (x == y) {
+                if (!(sum > 0.0)) {
+                  failed = true;
+                  return;
+                }
+                row[y] = sqrt(sum);
+              } else {
+                row[x] = sum / x_row[x];
+              }
+            }
+          }
+        },
+        {}, {{k, k}}, true);
+    // L_ik = A_ik * L_kk^-T, by forward substitution along each row.
+    for (size_t i = k + 1; i < count; i++) {
+      size_t i_begin = tiles.begin(i);
+      size_t i_end = tiles.end(i);
+      tiles.add(
+          graph,
+          [=, &rows, &failed]() {
+            if (failed) {
+              return;
+            }
+            for (size_t y = i_begin; y < i_end; y++) {
+              double *row = rows[y];
+              for (size_t x = k_begin; x < k_end; x++) {
+                const double *x_row = rows[x];
+                double sum = row[x];
+                for (size_t p = k_begin; p < x; p++) {
+                  sum -= row[p] * x_row[p];
+                }
+                row[x] = sum / x_row[x];
+              }
+            }
+          },
+          {{k, k}}, {{i, k}}, true);
+    }
+    // A_ij -= L_ik * L_jk^T on and below the diagonal. Both factors are
+    // read along their rows.
+    for (size_t j = k + 1; j < count; j++) {
+      size_t j_begin = tiles.begin(j);
+      size_t j_end = tiles.end(j);
+      for (size_t i = j; i < count; i++) {
+        size_t i_begin = tiles.begin(i);
+        size_t i_end = tiles.end(i);
+        tiles.add(
+            graph,
+            [=, &rows, &failed]() {
+              if (failed) {
+                return;
+              }
+              for (size_t y = i_begin; y < i_end; y++) {
+                double *row = rows[y];
+                size_t x_end = i == j ? y + 1 : j_end;
+                for (size_t x = j_begin; x < x_end; x++) {
+                  const double *x_row = rows[x];
+                  double sum = 0.0;
+                  for (size_t p = k_begin; p < k_end; p++) {
+                    sum += row[p] * x_row[p];
+                  }
+                  row[x] -= sum;
+                }
+              }
+            },
+            {{i, k}, {j, k}}, {{i, j}}, j == k + 1);
+      }
+    }
+  }
+  graph.run();
+  return !failed;
+}
+}; // namespace
+
+bool tileLUFactorize(Matrix &A, std::vector<size_t> &pivots,
+                     const size_t &tile_size) {
+  if (A.width() != A.height()) {
+    throw std::runtime_error(
+        "Input matrix was " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) +
+        " but a square matrix is required for lu factorization.");
+  }
+  checkTileSize(tile_size);
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    bool result = tileLUFactorize(A_contiguous, pivots, tile_size);
+    A = A_contiguous;
+    return result;
+  }
+  size_t n = A.height();
+  pivots.resize(n);
+  double *a = A.data();
+  std::atomic<bool> singular(false);
+  TileGrid tiles(n, tile_size);
+  size_t count = tiles.count();
+  TaskGraph graph;
+  for (size_t k = 0; k < count; k++) {
+    size_t k_begin = tiles.begin(k);
+    size_t k_end = tiles.end(k);
+    std::vector<std::pair<size_t, size_t>> panel;
+    for (size_t i = k; i < count; i++) {
+      panel.emplace_back(i, k);
+    }
+    tiles.add(
+        graph,
+        [=, &pivots, &singular]() {
+          factorPanel(a, n, k_begin, k_end, pivots, singular);
+        },
+        {}, panel, true);
+    // The next panel and the updates it waits for are critical, so that
+    // they run ahead of the rest of this step's trailing update.
+    for (size_t j = k + 1; j < count; j++) {
+      size_t j_begin = tiles.begin(j);
+      size_t j_end = tiles.end(j);
+      // Swap the rows of column j and solve with the unit lower triangle
+      // of the diagonal tile for row k of U.
+      std::vector<std::pair<size_t, size_t>> column;
+      for (size_t i = k; i < count; i++) {
+        column.emplace_back(i, j);
+      }
+      tiles.add(
+          graph,
+          [=, &pivots]() {
+            swapRows(a, n, pivots, k_begin, k_end, j_begin, j_end);
+            for (size_t y = k_begin; y < k_end; y++) {
+              double *row = &a[y * n];
+              for (size_t p = k_begin; p < y; p++) {
+                double l = row[p];
+                const double *u_row = &a[p * n];
+                for (size_t x = j_begin; x < j_end; x++) {
+                  row[x] -= l * u_row[x];
+                }
+              }
+            }
+          },
+          {{k, k}}, column, j == k + 1);
+    }
+    for (size_t j = k + 1; j < count; j++) {
+      size_t j_begin = tiles.begin(j);
+      size_t j_end = tiles.end(j);
+      for (size_t i = k + 1; i < count; i++) {
+        size_t i_begin = tiles.begin(i);
+        size_t i_end = tiles.end(i);
+        // A_ij -= L_ik * U_kj.
+        tiles.add(
+            graph,
+            [=]() {
+              for (size_t y = i_begin; y < i_end; y++) {
+                double *row = &a[y * n];
+                for (size_t p = k_begin; p < k_end; p++) {
+                  double l = row[p];
+                  const double *u_row = &a[p * n];
+                  for (size_t x = j_begin; x < j_end; x++) {
+                    row[x] -= l * u_row[x];
+                  }
+                }
+              }
+            },
+            {{i, k}, {k, j}}, {{i, j}}, j == k + 1);
+      }
+    }
+  }
+  graph.run();
+  // Each panel swapped rows within its own columns only; apply the swaps
+  // of the later panels to the multipliers on its left.
+  parallelFor(0, count, [&](const size_t &j) {
+    swapRows(a, n, pivots, tiles.end(j), n, tiles.begin(j), tiles.end(j));
+  });
+  return !singular;
+}
+
+bool tileCholeskyFactorize(Matrix &A, const size_t &tile_size) {
+  if (A.width() != A.height()) {
+    throw std::runtime_error(
+        "Input matrix was " + std::to_string(A.width()) + "x" +
+        std::to_string(A.height()) +
+        " but a square matrix is required for Cholesky factorization.");
+  }
+  checkTileSize(tile_size);
+  if (!A.contiguous()) {
+    Matrix A_contiguous = A;
+    bool result = tileCholeskyFactorize(A_contiguous, tile_size);
+    A = A_contiguous;
+    return result;
+  }
+  size_t n = A.height();
+  double *a = A.data();
+  std::vector<double *> rows(n);
+  for (size_t y = 0; y < n; y++) {
+    rows[y] = &a[y * n];
+  }
+  if (!tileCholeskyRows(rows, n, tile_size)) {
+    return false;
+  }
+  parallelFor(0, n, [&](const size_t &y) {
+    std::fill(&a[y * n + y + 1], &a[y * n + n], 0.0);
+  });
+  return true;
+}
+
+bool tileCholeskyFactorize(LowerTriangular &L, const size_t &tile_size) {
+  checkTileSize(tile_size);
+  size_t n = L.size();
+  double *l = L.data();
+  std::vector<double *> rows(n);
+  for (size_t y = 0; y < n; y++) {
+    rows[y] = &l[y * (y + 1) / 2];
+  }
+  return tileCholeskyRows(rows, n, tile_size);
+}
+}; // namespace basic_matrix
@@ -0,0 +1,42 @@
+#pragma once
+#include "matrix.hpp"
+#include "packed_matrix.hpp"
+#include <vector>
+
+namespace basic_matrix {
+/// Tile algorithms for factoring large dense matrices on many cores, in the
+/// style of PLASMA. The matrix is split into tile_size x tile_size tiles,
+/// and each step of the factorization into tasks on tiles: factoring the
+/// panel, solving with it, and one update per tile of the trailing matrix.
+/// The tasks form a dependency graph that runs on a TaskGraph, so a task
+/// starts as soon as the tiles it reads are ready instead of at the end of
+/// a step, and the panel of step k + 1 and the updates that unblock it are
+/// critical tasks (lookahead), so they overlap the rest of the trailing
+/// update of step k instead of leaving cores idle at every panel.
+
+/// The default tile size: the three tiles of an update fit in L2 cache.
+const size_t kDefaultTileSize = 96;
+
+/// luFactorize as a task graph, with the same output: P*A = L*U with
+/// partial pivoting, U on and above the diagonal of A, the multipliers of
+/// the unit L below it, and the LAPACK-style row swaps in pivots. The panel
+/// task factors a whole column of tiles, so the pivots are chosen from the
+/// whole column as in luFactorize, and not only within a tile.
+/// Returns false if a pivot is exactly zero, i.e. A is singular.
+bool tileLUFactorize(Matrix &A, std::vector<size_t> &pivots,
+                     const size_t &tile_size = kDefaultTileSize);
+
+/// Cholesky factorization, A = L * L^T, of a symmetric positive definite
+/// matrix as a task graph. Only the lower triangle of A is read. On output
+/// A is L: its strict upper triangle is set to 0.
+/// Returns false if A is not positive definite; A is then only partially
+/// factored.
+bool tileCholeskyFactorize(Matrix &A,
+                           const size_t &tile_size = kDefaultTileSize);
+
+/// tileCholeskyFactorize in packed storage: L holds the lower triangle of A
+/// on input and L on output. The tiles are spans of the packed rows, so no
+/// dense copy is made.
+bool tileCholeskyFactorize(LowerTriangular &L,
+                           const size_t &tile_size = kDefaultTileSize);
+}; // namespace basic_matrix
@@ -0,0 +1,201 @@
+#include "banded_matrix.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+/// A random n x n matrix with the given bandwidths.
+Matrix randomBanded(const size_t &n, const size_t &lower,
+                    const size_t &upper) {
+  Matrix result(n, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      if (x + lower >= y && x <= y + upper) {
+        result(x, y) = randomDouble(-1.0, 1.0);
+      }
+    }
+  }
+  return result;
+}
+
+/// A symmetric positive definite matrix with the given bandwidth.
+Matrix randomSPDBanded(const size_t &n, const size_t &bandwidth) {
+  Matrix result = randomBanded(n, bandwidth, bandwidth);
+  result = result + result.transpose();
+  for (size_t i = 0; i < n; i++) {
+    result(i, i) = 2.0 * bandwidth + 2.0;
+  }
+  return result;
+}
+}; // namespace
+
+void storageWorks() {
+  Matrix dense = randomBanded(7, 2, 1);
+  BandedMatrix A(dense, 2, 1);
+  ASSERT_EQ(A.size(), 7);
+  ASSERT_EQ(A.band().size(), 7 * 4);
+  ASSERT_MATRIX_NEAR(A.toDense(), dense);
+  // Reading outside the band gives zero; writing there throws.
+  const BandedMatrix &const_A = A;
+  ASSERT_EQ(const_A(4, 2), 0.0);
+  ASSERT_EQ(const_A(2, 4), dense(2, 4));
+  // LAPACK layout: (x, y) at row upper + y - x of column x.
+  ASSERT_EQ(A.band()[3 * 4 + 1 + 4 - 3], dense(3, 4));
+  A(3, 3) = 10.0;
+  ASSERT_EQ(A(3, 3), 10.0);
+  bool threw = false;
+  try {
+    A(5, 1) = 1.0;
+  } catch (const std::out_of_range &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void productWorks() {
+  Matrix dense = randomBanded(50, 3, 5);
+  BandedMatrix A(dense, 3, 5);
+  Matrix x = randomMatrix(1, 50, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A * x, dense * x);
+  Matrix B = randomMatrix(4, 50, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A * B, dense * B);
+}
+
+void bandedLUWorks() {
+  for (const auto &bands :
+       std::vector<std::pair<size_t, size_t>>{{0, 0}, {1, 1}, {3, 2}, {0, 4},
+                                              {5, 0}}) {
+    size_t n = 60;
+    Matrix dense = randomBanded(n, bands.first, bands.second);
+    // Diagonally dominant, so that even the triangular cases are well
+    // conditioned.
+    double dominance = bands.first + bands.second + 1.0;
+    for (size_t i = 0; i < n; i++) {
+      dense(i, i) = (i % 2 == 0) ? dominance : -dominance;
+    }
+    BandedMatrix A(dense, bands.first, bands.second);
+    BandedMatrix LU;
+    std::vector<size_t> pivots;
+    ASSERT(bandedLUFactorize(A, LU, pivots));
+    ASSERT_EQ(LU.upper(), bands.first + bands.second);
+    Matrix x = randomMatrix(3, n, -1.0, 1.0);
+    Matrix b = dense * x;
+    solveBandedLU(LU, pivots, b);
+    ASSERT_MATRIX_NEAR_TOL(b, x, 1e-10);
+  }
+  // Pivoting is needed: the first diagonal entry is zero.
+  Matrix dense = {{0.0, 1.0, 0.0}, {2.0, 1.0, 1.0}, {0.0, 3.0, 1.0}};
+  BandedMatrix A(dense, 1, 1);
+  BandedMatrix LU;
+  std::vector<size_t> pivots;
+  ASSERT(bandedLUFactorize(A, LU, pivots));
+  Matrix b(1, 3);
+  b(0, 0) = 1.0;
+  b(0, 1) = 2.0;
+  b(0, 2) = 3.0;
+  Matrix expected = dense.inverse() * b;
+  solveBandedLU(LU, pivots, b);
+  ASSERT_MATRIX_NEAR(b, expected);
+
+  BandedMatrix singular(3, 1, 1);
+  ASSERT(!bandedLUFactorize(singular, LU, pivots));
+}
+
+void bandedCholeskyWorks() {
+  size_t n = 80;
+  Matrix dense = randomSPDBanded(n, 4);
+  BandedMatrix A(dense, 4, 4);
+  BandedMatrix L;
+  ASSERT(bandedCholeskyFactorize(A, L));
+  ASSERT_EQ(L.upper(), 0);
+  Matrix L_dense = L.toDense();
+  ASSERT_MATRIX_NEAR_TOL(L_dense * L_dense.transpose(), dense, 1e-10);
+  Matrix x = randomMatrix(2, n, -1.0, 1.0);
+  Matrix b = dense * x;
+  solveBandedCholesky(L, b);
+  ASSERT_MATRIX_NEAR_TOL(b, x, 1e-10);
+
+  BandedMatrix indefinite(dense * -1.0, 4, 4);
+  ASSERT(!bandedCholeskyFactorize(indefinite, L));
+}
+
+void batchesWork() {
+  setNumThreads(4);
+  std::vector<BandedMatrix> A;
+  std::vector<Matrix> b;
+  std::vector<Matrix> x;
+  for (size_t i = 0; i < 20; i++) {
+    Matrix dense = randomSPDBanded(30, 2);
+    A.push_back(BandedMatrix(dense, 2, 2));
+    x.push_back(randomMatrix(1, 30, -1.0, 1.0));
+    b.push_back(dense * x.back());
+  }
+  ASSERT(solveBandedBatch(A, b));
+  for (size_t i = 0; i < b.size(); i++) {
+    ASSERT_MATRIX_NEAR_TOL(b[i], x[i], 1e-10);
+  }
+  setNumThreads(0);
+}
+
+void tridiagonalWorks() {
+  size_t n = 100;
+  Matrix sub = randomMatrix(1, n - 1, -1.0, 1.0);
+  Matrix super = randomMatrix(1, n - 1, -1.0, 1.0);
+  Matrix diagonal = randomMatrix(1, n, 2.5, 3.0);
+  Matrix dense(n, n);
+  for (size_t i = 0; i < n; i++) {
+    dense(i, i) = diagonal(0, i);
+    if (i + 1 < n) {
+      dense(i, i + 1) = sub(0, i);
+      dense(i + 1, i) = super(0, i);
+    }
+  }
+  Matrix x = randomMatrix(3, n, -1.0, 1.0);
+  Matrix b = dense * x;
+  ASSERT(solveTridiagonal(sub, diagonal, super, b));
+  ASSERT_MATRIX_NEAR_TOL(b, x, 1e-10);
+
+  Matrix zero_pivot = Matrix(1, 2);
+  Matrix off = Matrix(1, 1);
+  Matrix rhs = Matrix(1, 2);
+  ASSERT(!solveTridiagonal(off, zero_pivot, off, rhs));
+}
+
+void tridiagonalBatchWorks() {
+  // m systems of size n side by side; system j is column j.
+  size_t n = 40;
+  size_t m = 300;
+  setNumThreads(4);
+  Matrix sub = randomMatrix(m, n - 1, -1.0, 1.0);
+  Matrix super = randomMatrix(m, n - 1, -1.0, 1.0);
+  Matrix diagonal = randomMatrix(m, n, 2.5, 3.0);
+  Matrix x = randomMatrix(m, n, -1.0, 1.0);
+  Matrix b(m, n);
+  for (size_t j = 0; j < m; j++) {
+    for (size_t i = 0; i < n; i++) {
+      double value = diagonal(j, i) * x(j, i);
+      if (i > 0) {
+        value += sub(j, i - 1) * x(j, i - 1);
+      }
+      if (i + 1 < n) {
+        value += super(j, i) * x(j, i + 1);
+      }
+      b(j, i) = value;
+    }
+  }
+  ASSERT(solveTridiagonalBatch(sub, diagonal, super, b));
+  ASSERT_MATRIX_NEAR_TOL(b, x, 1e-10);
+  setNumThreads(0);
+}
+
+int main() {
+  storageWorks();
+  productWorks();
+  bandedLUWorks();
+  bandedCholeskyWorks();
+  batchesWork();
+  tridiagonalWorks();
+  tridiagonalBatchWorks();
+}
@@ -0,0 +1,98 @@
+#include "batched_gemm.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+/// Product i of a vertically stacked batch of height-h blocks.
+Matrix block(const Matrix &stacked, const size_t &h, const size_t &i) {
+  return Matrix(
+      MatrixROI(0, i * h, stacked.width(), h, const_cast<Matrix *>(&stacked)));
+}
+}; // namespace
+
+void stackedProductsWork() {
+  setNumThreads(4);
+  // Shapes with and without a fixed-size micro-kernel.
+  for (const auto &shape : std::vector<std::vector<size_t>>{
+           {1, 1, 1}, {3, 3, 3}, {4, 1, 4}, {2, 4, 3}, {5, 3, 7}, {8, 8, 8}}) {
+    size_t m = shape[0];
+    size_t n = shape[1];
+    size_t k = shape[2];
+    size_t count = 1000;
+    Matrix A = randomMatrix(k, m * count, -1.0, 1.0);
+    Matrix B = randomMatrix(n, k * count, -1.0, 1.0);
+    Matrix C = batchedMultiply(A, B, count);
+    ASSERT_EQ(C.width(), n);
+    ASSERT_EQ(C.height(), m * count);
+    for (size_t i = 0; i < count; i += 37) {
+      ASSERT_MATRIX_NEAR(block(C, m, i), block(A, m, i) * block(B, k, i));
+    }
+  }
+  setNumThreads(0);
+
+  // Views of larger matrices are not contiguous.
+  Matrix A_outer = randomMatrix(5, 12, -1.0, 1.0);
+  Matrix B_outer = randomMatrix(4, 10, -1.0, 1.0);
+  Matrix A_view(MatrixROI(1, 2, 3, 8, &A_outer));
+  Matrix B_view(MatrixROI(0, 1, 2, 6, &B_outer));
+  Matrix C_view = batchedMultiply(A_view, B_view, 2);
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_MATRIX_NEAR(block(C_view, 4, i),
+                       block(A_view, 4, i) * block(B_view, 3, i));
+  }
+
+  bool threw = false;
+  try {
+    batchedMultiply(Matrix(3, 6), Matrix(3, 5), 2);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void stridesAndScalingWork() {
+  // One shared 3x3 A applied to 50 points, accumulated into C with alpha
+  // and beta.
+  size_t count = 50;
+  Matrix A = randomMatrix(3, 3, -1.0, 1.0);
+  Matrix points = randomMatrix(1, 3 * count, -1.0, 1.0);
+  Matrix C = randomMatrix(1, 3 * count, -1.0, 1.0);
+  Matrix C_before = C;
+  batchedMultiply(A.data(), 0, points.data(), 3, C.data(), 3, 3, 1, 3, count,
+                  2.0, 0.5);
+  for (size_t i = 0; i < count; i++) {
+    Matrix expected =
+        A * block(points, 3, i) * 2.0 + block(C_before, 3, i) * 0.5;
+    ASSERT_MATRIX_NEAR(block(C, 3, i), expected);
+  }
+  // The same with a generic shape.
+  Matrix A6 = randomMatrix(6, 6, -1.0, 1.0);
+  Matrix points6 = randomMatrix(1, 6 * count, -1.0, 1.0);
+  Matrix C6 = randomMatrix(1, 6 * count, -1.0, 1.0);
+  Matrix C6_before = C6;
+  batchedMultiply(A6.data(), 0, points6.data(), 6, C6.data(), 6, 6, 1, 6,
+                  count, -1.0, 2.0);
+  for (size_t i = 0; i < count; i++) {
+    Matrix expected =
+        A6 * block(points6, 6, i) * -1.0 + block(C6_before, 6, i) * 2.0;
+    ASSERT_MATRIX_NEAR(block(C6, 6, i), expected);
+  }
+
+  // Products written to the same C would race.
+  bool threw = false;
+  try {
+    batchedMultiply(A.data(), 0, points.data(), 3, C.data(), 0, 3, 1, 3,
+                    count);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main() {
+  stackedProductsWork();
+  stridesAndScalingWork();
+}
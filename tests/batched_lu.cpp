@@ -0,0 +1,89 @@
+#include "batched_lu.hpp"
+#include "lup_decomposition.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+#include <math.h>
+
+using namespace basic_matrix;
+
+namespace {
+/// Matrix i of a vertically stacked batch.
+Matrix block(const Matrix &stacked, const size_t &n, const size_t &i) {
+  return Matrix(MatrixROI(0, i * n, stacked.width(), n,
+                          const_cast<Matrix *>(&stacked)));
+}
+}; // namespace
+
+void batchedLUWorks() {
+  setNumThreads(4);
+  for (size_t n : {1, 3, 5, 8}) {
+    // Not a multiple of the number of lanes.
+    size_t count = 203;
+    Matrix stacked = randomMatrix(n, n * count, -1.0, 1.0);
+    if (n > 1) {
+      // Some matrices need pivoting: a zero in the top left corner.
+      stacked(0, 0) = 0.0;
+      stacked(0, 5 * n) = 0.0;
+    }
+    BatchedLU LU(stacked, n);
+    ASSERT_EQ(LU.count(), count);
+    ASSERT(LU.allOk());
+
+    Matrix b = randomMatrix(2, n * count, -1.0, 1.0);
+    Matrix x = b;
+    LU.solve(x);
+    Matrix inverse = LU.inverse();
+    Matrix det = LU.determinants();
+    for (size_t i = 0; i < count; i++) {
+      Matrix A = block(stacked, n, i);
+      Matrix A_inverse = A.inverse();
+      if (!A_inverse.ok()) {
+        continue;
+      }
+      ASSERT_MATRIX_NEAR_TOL(A * block(x, n, i), block(b, n, i), 1e-8);
+      ASSERT_MATRIX_NEAR_TOL(block(inverse, n, i), A_inverse, 1e-8);
+      double expected = A.det();
+      ASSERT_TOL(det(0, i), expected, 1e-10 * std::max(1.0, fabs(expected)));
+    }
+  }
+  setNumThreads(0);
+}
+
+void singularMatricesAreFlagged() {
+  size_t n = 4;
+  size_t count = 20;
+  Matrix stacked = randomMatrix(n, n * count, -1.0, 1.0);
+  // Matrix 7 has two equal rows, matrix 12 is zero.
+  for (size_t x = 0; x < n; x++) {
+    stacked(x, 7 * n + 1) = stacked(x, 7 * n + 3);
+    for (size_t y = 0; y < n; y++) {
+      stacked(x, 12 * n + y) = 0.0;
+    }
+  }
+  BatchedLU LU(stacked, n);
+  ASSERT(!LU.allOk());
+  ASSERT(!LU.ok(12));
+  ASSERT(LU.ok(11));
+  ASSERT(LU.ok(13));
+  Matrix det = LU.determinants();
+  ASSERT_EQ(det(0, 12), 0.0);
+  ASSERT_TOL(det(0, 7), 0.0, 1e-12);
+  Matrix inverse = LU.inverse();
+  ASSERT(std::isnan(inverse(0, 12 * n)));
+  Matrix A = block(stacked, n, 13);
+  ASSERT_MATRIX_NEAR_TOL(block(inverse, n, 13), A.inverse(), 1e-8);
+
+  bool threw = false;
+  try {
+    BatchedLU bad(Matrix(3, 10), 3);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main() {
+  batchedLUWorks();
+  singularMatricesAreFlagged();
+}
@@ -0,0 +1,84 @@
+#include "diagonal_matrix.hpp"
+#include "matrix_helpers.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+void identityWorks() {
+  Matrix A = randomMatrix(6, 6, -1.0, 1.0);
+  Identity I(6);
+  ASSERT_MATRIX_NEAR(I.toDense(), identity(6));
+  ASSERT_MATRIX_NEAR(A - 2.5 * I, A - identity(6) * 2.5);
+  ASSERT_MATRIX_NEAR(I * 2.5 + A, A + identity(6) * 2.5);
+  ASSERT_MATRIX_NEAR(A + I, A + identity(6));
+  ASSERT_MATRIX_NEAR(-(3.0 * I) - A, identity(6) * -3.0 - A);
+  ASSERT_MATRIX_NEAR(I * A, A);
+  ASSERT_MATRIX_NEAR(A * (2.0 * I), A * 2.0);
+
+  Matrix B = A;
+  B -= 0.5 * I;
+  ASSERT_MATRIX_NEAR(B, A - identity(6) * 0.5);
+  B += 0.5 * I;
+  ASSERT_MATRIX_NEAR(B, A);
+
+  // In place on an ROI only touches the ROI's diagonal.
+  Matrix C = randomMatrix(8, 8, -1.0, 1.0);
+  Matrix expected = C;
+  for (size_t i = 0; i < 3; i++) {
+    expected(2 + i, 1 + i) += 1.0;
+  }
+  Matrix roi(MatrixROI(2, 1, 3, 3, &C));
+  roi += ScaledIdentity(3, 1.0);
+  ASSERT_MATRIX_NEAR(C, expected);
+
+  bool threw = false;
+  try {
+    A - Identity(5);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void diagonalWorks() {
+  Matrix values = randomMatrix(1, 5, 0.5, 2.0);
+  Diagonal D(values);
+  ASSERT_EQ(D.size(), 5);
+  Matrix dense = D.toDense();
+  Matrix A = randomMatrix(5, 5, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A + D, A + dense);
+  ASSERT_MATRIX_NEAR(A - D, A - dense);
+  ASSERT_MATRIX_NEAR(D - A, dense - A);
+  ASSERT_MATRIX_NEAR(D * A, dense * A);
+  ASSERT_MATRIX_NEAR(A * D, A * dense);
+  Matrix tall = randomMatrix(3, 5, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(D * tall, dense * tall);
+  Matrix wide = randomMatrix(5, 2, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(wide * D, wide * dense);
+  ASSERT_MATRIX_NEAR((D * D.inverse()).toDense(), identity(5));
+  ASSERT_MATRIX_NEAR((D + 2.0 * Identity(5)).toDense(),
+                     dense + identity(5) * 2.0);
+  ASSERT_MATRIX_NEAR((D - D).toDense(), Matrix(5, 5));
+  ASSERT_MATRIX_NEAR((3.0 * D).toDense(), dense * 3.0);
+  ASSERT_MATRIX_NEAR(diagonalOf(dense).toDense(), dense);
+
+  bool threw = false;
+  try {
+    Diagonal(std::vector<double>{1.0, 0.0}).inverse();
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+  threw = false;
+  try {
+    D * Matrix(5, 4);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main() {
+  identityWorks();
+  diagonalWorks();
+}
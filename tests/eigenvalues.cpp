@@ -3,6 +3,7 @@
 #include "matrix.hpp"
 #include "matrix_helpers.hpp"
 #include "qr_factorization.hpp"
+#include "test_helpers.hpp"
 #include <iostream>
 
 using namespace basic_matrix;
@@ -49,4 +50,69 @@ void testEigenvalues() {
   }
 }
 
-int main(int argc, char **argv) { testEigenvalues(); }
+void hessenbergReductionObeysDefinition() {
+  // The largest sizes are reduced in blocks.
+  for (size_t n : {1, 2, 3, 10, 57, 161, 250}) {
+    Matrix A = randomMatrix(n, n, -10.0, 10.0);
+    Matrix H = A;
+    Matrix tau;
+    hessenbergReduction(H, tau);
+    Matrix Q = formHessenbergQ(H, tau);
+    for (size_t x = 0; x < n; x++) {
+      for (size_t y = x + 2; y < n; y++) {
+        H(x, y) = 0.0;
+      }
+    }
+    ASSERT_MATRIX_NEAR_TOL(Q.transpose() * Q, identity(n), 1e-10);
+    ASSERT_MATRIX_NEAR_TOL(Q * H * Q.transpose(), A, 1e-8);
+  }
+}
+
+void complexEigenvaluesWork() {
+  {
+    // A rotation by 90 degrees.
+    Matrix A = {{0, -1}, {1, 0}};
+    Matrix result = complexEigenvalues(A);
+    ASSERT(result.ok());
+    ASSERT_EQ(result.width(), 2);
+    ASSERT_NEAR(result(0, 0), 0.0);
+    ASSERT_NEAR(result(0, 1), 0.0);
+    ASSERT_NEAR(fabs(result(1, 0)), 1.0);
+    ASSERT_NEAR(result(1, 0), -result(1, 1));
+  }
+  {
+    Matrix A = {{11.604381, -7.344107}, {0.187676, 10.981659}};
+    Matrix result = complexEigenvalues(A);
+    ASSERT(result.ok());
+    for (size_t i = 0; i < 2; i++) {
+      ASSERT_TOL(result(0, i), 11.29302, 1e-5);
+      ASSERT_TOL(fabs(result(1, i)), 1.131978, 1e-5);
+    }
+  }
+  for (size_t n : {3, 8, 50, 200}) {
+    Matrix A = randomMatrix(n, n, -10.0, 10.0);
+    Matrix result = complexEigenvalues(A);
+    ASSERT(result.ok());
+    // sum(lambda) = trace(A) and sum(lambda^2) = trace(A^2).
+    Matrix A2 = A * A;
+    double trace = 0., trace2 = 0., sum = 0., sum2 = 0., imaginary_sum = 0.;
+    for (size_t i = 0; i < n; i++) {
+      trace += A(i, i);
+      trace2 += A2(i, i);
+      double re = result(0, i);
+      double im = result(1, i);
+      sum += re;
+      sum2 += re * re - im * im;
+      imaginary_sum += im;
+    }
+    ASSERT_TOL(sum, trace, 1e-8 * n);
+    ASSERT_TOL(sum2, trace2, 1e-6 * n);
+    ASSERT_TOL(imaginary_sum, 0.0, 1e-8);
+  }
+}
+
+int main(int argc, char **argv) {
+  testEigenvalues();
+  hessenbergReductionObeysDefinition();
+  complexEigenvaluesWork();
+}
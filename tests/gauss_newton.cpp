@@ -117,6 +117,76 @@ void gaussNewtonWorksFor2DLinearSystemWithNoise() {
   ASSERT_MATRIX_NEAR_TOL(problem.outputs.theta, theta_normal_eqn, 10.0);
 }
 
+void gaussNewtonReusesItsWorkspace() {
+  // Many fits of the same size through one workspace: after the first,
+  // every buffer keeps its storage.
+  size_t num_params = 4;
+  size_t num_samples = 12;
+  GaussNewtonWorkspace workspace;
+  const double *J_data = nullptr;
+  const double *JtJ_data = nullptr;
+  const double *L_data = nullptr;
+  for (size_t fit = 0; fit < 5; fit++) {
+    OptimizationProblem problem;
+    problem.inputs.num_params = num_params;
+    Matrix theta_gt = randomMatrix(1, num_params, -10.0, 10.0);
+    problem.outputs.theta = randomMatrix(1, num_params, -3.0, 3.0);
+    problem.inputs.X = randomMatrix(num_params, num_samples, -10.0, 10.0);
+    problem.inputs.y = problem.inputs.X * theta_gt;
+    problem.inputs.function = &linearFunction;
+    gaussNewton(problem, workspace);
+    ASSERT_MATRIX_NEAR_TOL(problem.outputs.theta, theta_gt, 1e-6);
+    ASSERT_EQ(workspace.J.width(), num_params);
+    ASSERT_EQ(workspace.J.height(), num_samples);
+    if (fit > 0) {
+      ASSERT(workspace.J.data() == J_data);
+      ASSERT(workspace.JtJ.packed().data() == JtJ_data);
+      ASSERT(workspace.L.packed().data() == L_data);
+    }
+    J_data = workspace.J.data();
+    JtJ_data = workspace.JtJ.packed().data();
+    L_data = workspace.L.packed().data();
+  }
+}
+
+void gaussNewtonThrowsOnMismatchedSizes() {
+  size_t num_params = 3;
+  size_t num_samples = 8;
+  OptimizationProblem problem;
+  problem.inputs.num_params = num_params;
+  problem.inputs.X = randomMatrix(num_params, num_samples, -1.0, 1.0);
+  problem.inputs.y = randomMatrix(1, num_samples, -1.0, 1.0);
+  problem.inputs.jacobian = [&](const Matrix &, const Matrix &X,
+                                const Matrix &, Matrix &J) { J = X; };
+  // One output short.
+  problem.inputs.vector_function = [&](const Matrix &, const Matrix &,
+                                       Matrix &y) {
+    y = Matrix(1, num_samples - 1);
+  };
+  bool threw = false;
+  try {
+    gaussNewton(problem);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+
+  // A Jacobian with a column too many.
+  problem.inputs.vector_function = [&](const Matrix &theta, const Matrix &X,
+                                       Matrix &y) { y = X * theta; };
+  problem.inputs.jacobian = [&](const Matrix &, const Matrix &,
+                                const Matrix &, Matrix &J) {
+    J = Matrix(num_params + 1, num_samples);
+  };
+  threw = false;
+  try {
+    gaussNewton(problem);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
 void gaussNewtonWorksForLogisticRegression() {}
 
 int main() {
@@ -124,5 +194,7 @@ int main() {
   gaussNewtonWorksForNonlinearSystem();
   gaussNewtonWorksFor1DLinearSystemWithNoise();
   gaussNewtonWorksFor2DLinearSystemWithNoise();
+  gaussNewtonReusesItsWorkspace();
+  gaussNewtonThrowsOnMismatchedSizes();
   return 0;
 }
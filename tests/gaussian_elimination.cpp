@@ -1,6 +1,7 @@
 #include "gaussian_elimination.hpp"
 #include "matrix.hpp"
 #include "matrix_helpers.hpp"
+#include "parallel.hpp"
 #include "test_helpers.hpp"
 #include <iostream>
 
@@ -41,9 +42,52 @@ void solveByGaussianEliminationWorks() {
   }
 }
 
+void solveByGaussianEliminationWorksForSeveralColumns() {
+  for (const auto &n : {1, 5, 150}) {
+    Matrix A = generateNonsingularMatrix(n, n);
+    Matrix x = randomMatrix(3, n, -10.0, 10.0);
+    Matrix b = A * x;
+    solveByGaussianElimination(A, b);
+    ASSERT_MATRIX_NEAR_TOL(x, b, 1e-6);
+  }
+  // Large enough that the row updates run in parallel.
+  setNumThreads(4);
+  Matrix A = generateNonsingularMatrix(200, 200);
+  Matrix x = randomMatrix(2, 200, -10.0, 10.0);
+  Matrix b = A * x;
+  solveByGaussianElimination(A, b);
+  ASSERT_MATRIX_NEAR_TOL(x, b, 1e-6);
+  setNumThreads(0);
+
+  bool threw = false;
+  try {
+    Matrix b_wrong(1, 4);
+    solveByGaussianElimination(A, b_wrong);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void pivotsOnTheLargestEntry() {
+  // Without pivoting, the tiny first pivot loses half the digits.
+  double e = 1e-8;
+  Matrix A = {{e, 1}, {1, 1}};
+  Matrix b(1, 2);
+  b(0, 0) = 1.0;
+  b(0, 1) = 2.0;
+  solveByGaussianElimination(A, b);
+  double x0 = 1.0 / (1.0 - e);
+  double x1 = 1.0 - e * x0;
+  ASSERT_TOL(b(0, 0), x0, 1e-14);
+  ASSERT_TOL(b(0, 1), x1, 1e-14);
+}
+
 int main() {
   doesNotChangeIdentity();
   linearlyDependentRows();
   rankTwo();
   solveByGaussianEliminationWorks();
+  solveByGaussianEliminationWorksForSeveralColumns();
+  pivotsOnTheLargestEntry();
 }
@@ -1,3 +1,4 @@
+#include "lup_decomposition.hpp"
 #include "matrix.hpp"
 #include "matrix_helpers.hpp"
 #include "test_helpers.hpp"
@@ -24,4 +25,55 @@ void nonSingularMatricesWork() {
   }
 }
 
-int main() { nonSingularMatricesWork(); }
+void scaledMatricesWork() {
+  // det(A) = 1e-30, but A is perfectly conditioned.
+  Matrix A = identity(10) * 1e-3;
+  A(3, 1) = 5e-4;
+  ASSERT(A.rcond() > 0.1);
+  Matrix AI = A.inverse();
+  ASSERT(AI.ok());
+  ASSERT_MATRIX_NEAR(A * AI, identity(10));
+
+  Matrix L, U, P;
+  ASSERT(lupDecomposition(A, L, U, P));
+  ASSERT_MATRIX_NEAR(P * A, L * U);
+}
+
+void singularMatricesFail() {
+  Matrix A = randomMatrix(6, 6, -1.0, 1.0);
+  // The last row is a combination of the first two.
+  for (size_t x = 0; x < A.width(); x++) {
+    A(x, 5) = 0.3 * A(x, 0) - 2.0 * A(x, 1);
+  }
+  ASSERT(A.rcond() < 1e-15);
+  ASSERT(!A.inverse().ok());
+  ASSERT(!(A * 1e10).inverse().ok());
+}
+
+void rcondEstimatesTheConditionNumber() {
+  size_t trial_count = 20;
+  for (size_t i = 0; i < trial_count; i++) {
+    size_t n = randomInt<size_t>(1, 30);
+    Matrix A = randomMatrix(n, n, -1.0, 1.0);
+    // Grade the columns to make the conditioning interesting.
+    for (size_t y = 0; y < n; y++) {
+      for (size_t x = 0; x < n; x++) {
+        A(x, y) *= pow(10.0, -double(x % 5));
+      }
+    }
+    Matrix AI = A.inverse();
+    ASSERT(AI.ok());
+    double exact = 1.0 / (norm1(A) * norm1(AI));
+    double estimate = A.rcond();
+    // ||A^-1||_1 is underestimated, by at most a small factor in practice.
+    ASSERT(estimate >= exact * (1.0 - 1e-9));
+    ASSERT(estimate <= 10.0 * exact);
+  }
+}
+
+int main() {
+  nonSingularMatricesWork();
+  scaledMatricesWork();
+  singularMatricesFail();
+  rcondEstimatesTheConditionNumber();
+}
@@ -0,0 +1,169 @@
+#include "iterative_solvers.hpp"
+#include "matrix_helpers.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+/// The 5-point finite difference discretization of -u_xx - u_yy + c * u_x
+/// on a k x k grid. Symmetric positive definite for c = 0.
+Matrix convectionDiffusion(const size_t &k, const double &c) {
+  size_t n = k * k;
+  Matrix A(n, n);
+  for (size_t gy = 0; gy < k; gy++) {
+    for (size_t gx = 0; gx < k; gx++) {
+      size_t i = gy * k + gx;
+      A(i, i) = 4.0;
+      if (gx > 0) {
+        A(i - 1, i) = -1.0 - c;
+      }
+      if (gx + 1 < k) {
+        A(i + 1, i) = -1.0 + c;
+      }
+      if (gy > 0) {
+        A(i - k, i) = -1.0;
+      }
+      if (gy + 1 < k) {
+        A(i + k, i) = -1.0;
+      }
+    }
+  }
+  return A;
+}
+
+void assertSolves(const Matrix &A, const Matrix &b, const Matrix &x,
+                  const IterativeSolverResult &result, const double &tol) {
+  ASSERT(result.converged);
+  ASSERT(result.relative_residual <= tol);
+  ASSERT((A * x - b).norm() <= tol * b.norm() * (1.0 + 1e-6));
+}
+}; // namespace
+
+void conjugateGradientWorks() {
+  Matrix A = convectionDiffusion(20, 0.0);
+  Matrix b = randomMatrix(1, A.height(), -1.0, 1.0);
+  Matrix x;
+  IterativeSolverResult plain = conjugateGradient(A, b, x);
+  assertSolves(A, b, x, plain, 1e-10);
+
+  IterativeSolverOptions options;
+  options.preconditioner = jacobiPreconditioner(A);
+  x = Matrix();
+  assertSolves(A, b, x, conjugateGradient(A, b, x, options), 1e-10);
+
+  options.preconditioner = incompleteCholeskyPreconditioner(A);
+  x = Matrix();
+  IterativeSolverResult ic = conjugateGradient(A, b, x, options);
+  assertSolves(A, b, x, ic, 1e-10);
+  ASSERT(ic.iterations < plain.iterations);
+
+  // A warm start from the solution is already converged.
+  IterativeSolverResult warm = conjugateGradient(A, b, x, options);
+  ASSERT(warm.converged);
+  ASSERT_EQ(warm.iterations, 0);
+
+  // The same operator, never formed.
+  size_t num_matvecs = 0;
+  LinearOperator op = [&](const Matrix &v) {
+    num_matvecs++;
+    return A * v;
+  };
+  x = Matrix();
+  IterativeSolverResult result = conjugateGradient(op, b, x);
+  assertSolves(A, b, x, result, 1e-10);
+  // Plus the two for the initial and final residual.
+  ASSERT_EQ(num_matvecs, result.iterations + 2);
+}
+
+void gmresWorks() {
+  Matrix A = convectionDiffusion(15, 0.4);
+  Matrix b = randomMatrix(1, A.height(), -1.0, 1.0);
+  Matrix x;
+  IterativeSolverOptions options;
+  options.restart = 20;
+  IterativeSolverResult plain = gmres(A, b, x, options);
+  assertSolves(A, b, x, plain, 1e-10);
+
+  options.preconditioner = incompleteLUPreconditioner(A);
+  x = Matrix();
+  IterativeSolverResult ilu = gmres(A, b, x, options);
+  assertSolves(A, b, x, ilu, 1e-10);
+  ASSERT(ilu.iterations < plain.iterations);
+
+  // Without restarts, GMRES solves a dense n x n system in n iterations.
+  Matrix B = generateNonsingularMatrix(12, 12);
+  Matrix c = randomMatrix(1, 12, -1.0, 1.0);
+  x = Matrix();
+  options = IterativeSolverOptions();
+  options.restart = 12;
+  options.tolerance = 1e-12;
+  IterativeSolverResult result = gmres(B, c, x, options);
+  ASSERT(result.converged);
+  ASSERT(result.iterations <= 12);
+  ASSERT_MATRIX_NEAR_TOL(x, B.inverse() * c, 1e-6);
+
+  // Running out of iterations is reported.
+  options = IterativeSolverOptions();
+  options.max_iterations = 3;
+  x = Matrix();
+  result = gmres(A, b, x, options);
+  ASSERT(!result.converged);
+  ASSERT_EQ(result.iterations, 3);
+}
+
+void bicgstabWorks() {
+  Matrix A = convectionDiffusion(15, 0.4);
+  Matrix b = randomMatrix(1, A.height(), -1.0, 1.0);
+  Matrix x;
+  IterativeSolverResult plain = bicgstab(A, b, x);
+  assertSolves(A, b, x, plain, 1e-10);
+
+  IterativeSolverOptions options;
+  options.preconditioner = incompleteLUPreconditioner(A);
+  x = Matrix();
+  IterativeSolverResult ilu = bicgstab(A, b, x, options);
+  assertSolves(A, b, x, ilu, 1e-10);
+  ASSERT(ilu.iterations < plain.iterations);
+
+  // A zero right-hand side has the zero solution.
+  x = Matrix();
+  IterativeSolverResult zero = bicgstab(A, Matrix(1, A.height()), x);
+  ASSERT(zero.converged);
+  ASSERT_MATRIX_NEAR(x, Matrix(1, A.height()));
+}
+
+void incompletePreconditionersAreExactForTridiagonalMatrices() {
+  // With no fill-in outside the pattern, IC(0) and ILU(0) are complete
+  // factorizations.
+  size_t n = 30;
+  Matrix A(n, n);
+  for (size_t i = 0; i < n; i++) {
+    A(i, i) = 3.0;
+    if (i > 0) {
+      A(i - 1, i) = -1.0;
+      A(i, i - 1) = -1.0;
+    }
+  }
+  Matrix b = randomMatrix(1, n, -1.0, 1.0);
+  Matrix expected = A.inverse() * b;
+  ASSERT_MATRIX_NEAR(incompleteCholeskyPreconditioner(A)(b), expected);
+  // Non-symmetric, with the same pattern.
+  A(3, 2) = 0.5;
+  expected = A.inverse() * b;
+  ASSERT_MATRIX_NEAR(incompleteLUPreconditioner(A)(b), expected);
+
+  bool threw = false;
+  try {
+    incompleteCholeskyPreconditioner(A * -1.0);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main() {
+  conjugateGradientWorks();
+  gmresWorks();
+  bicgstabWorks();
+  incompletePreconditionersAreExactForTridiagonalMatrices();
+}
@@ -68,7 +68,32 @@ void naiveKMeansE2E() {
   }
 }
 
+void naiveKMeansFarFromTheOrigin() {
+  // Two tight clusters 4 apart, 1e9 from the origin. Expanding the squared
+  // distance as |c|^2 - 2 p.c would lose everything below ~100 here.
+  double offset = 1e9;
+  std::vector<Matrix> points;
+  for (size_t i = 0; i < 100; i++) {
+    double center = i % 2 == 0 ? offset : offset + 4.0;
+    Matrix point = randomMatrix(1, 2, -0.5, 0.5, 0.0);
+    point(0, 0) += center;
+    point(0, 1) += offset;
+    points.push_back(point);
+  }
+  k_means::KMeansOptions options;
+  options.k = 2;
+  auto result = k_means::clusterByNaiveKMeans(points, options);
+  ASSERT_EQ(result.clusters.size(), 2);
+  for (const auto &cluster : result.clusters) {
+    ASSERT_EQ(cluster.member_indices.size(), 50);
+    for (const auto &idx : cluster.member_indices) {
+      ASSERT_EQ(idx % 2, cluster.member_indices[0] % 2);
+    }
+  }
+}
+
 int main() {
   naiveKMeansE2E();
+  naiveKMeansFarFromTheOrigin();
   return 0;
 }
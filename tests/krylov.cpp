@@ -0,0 +1,146 @@
+#include "krylov.hpp"
+#include "matrix_helpers.hpp"
+#include "qr_factorization.hpp"
+#include "test_helpers.hpp"
+#include <algorithm>
+
+using namespace basic_matrix;
+
+namespace {
+Matrix randomOrthogonalMatrix(const size_t &n) {
+  Matrix Q;
+  Matrix R = randomMatrix(n, n, -1.0, 1.0);
+  qrFactorize(Q, R);
+  return Q;
+}
+
+Matrix column(const Matrix &A, const size_t &x) {
+  Matrix result(1, A.height());
+  for (size_t y = 0; y < A.height(); y++) {
+    result(0, y) = A(x, y);
+  }
+  return result;
+}
+}; // namespace
+
+void lanczosFindsExtremalEigenpairs() {
+  size_t n = 300;
+  std::vector<double> spectrum;
+  for (size_t i = 0; i < n; i++) {
+    spectrum.push_back(randomDouble(-100.0, 100.0));
+  }
+  Matrix Q = randomOrthogonalMatrix(n);
+  Matrix QD = Q;
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      QD(x, y) *= spectrum[x];
+    }
+  }
+  Matrix A = QD * Q.transpose();
+  std::sort(spectrum.begin(), spectrum.end());
+
+  size_t k = 5;
+  KrylovOptions options;
+  for (const auto &order :
+       {EigenvalueOrder::LargestMagnitude, EigenvalueOrder::LargestReal,
+        EigenvalueOrder::SmallestReal}) {
+    options.order = order;
+    KrylovEigenpairs result = lanczosEigen(A, k, options);
+    ASSERT(result.converged);
+    ASSERT(result.values.ok());
+    ASSERT_EQ(result.values.height(), k);
+    std::vector<double> expected = spectrum;
+    if (order == EigenvalueOrder::LargestMagnitude) {
+      std::sort(expected.begin(), expected.end(),
+                [](const double &a, const double &b) {
+                  return fabs(a) > fabs(b);
+                });
+    } else if (order == EigenvalueOrder::LargestReal) {
+      std::reverse(expected.begin(), expected.end());
+    }
+    for (size_t i = 0; i < k; i++) {
+      ASSERT_TOL(result.values(0, i), expected[i], 1e-8);
+      Matrix x = column(result.vectors, i);
+      ASSERT_TOL(x.norm(), 1.0, 1e-10);
+      ASSERT((A * x - x * result.values(0, i)).norm() < 1e-7);
+    }
+  }
+}
+
+void lanczosWorksOnOperators() {
+  // The 1D Laplacian, never formed explicitly. Its eigenvalues are
+  // 2 - 2 * cos(j * pi / (n + 1)).
+  size_t n = 1000;
+  size_t num_matvecs = 0;
+  LinearOperator laplacian = [&](const Matrix &x) {
+    num_matvecs++;
+    Matrix y(1, n);
+    for (size_t i = 0; i < n; i++) {
+      y(0, i) = 2.0 * x(0, i) - (i > 0 ? x(0, i - 1) : 0.0) -
+                (i + 1 < n ? x(0, i + 1) : 0.0);
+    }
+    return y;
+  };
+  KrylovOptions options;
+  options.subspace_size = 60;
+  options.tolerance = 1e-12;
+  KrylovEigenpairs result = lanczosEigen(laplacian, n, 3, options);
+  ASSERT(result.converged);
+  ASSERT_EQ(result.num_matvecs, num_matvecs);
+  for (size_t i = 0; i < 3; i++) {
+    double expected = 2.0 - 2.0 * cos((n - i) * M_PI / (n + 1));
+    ASSERT_TOL(result.values(0, i), expected, 1e-9);
+  }
+  bool threw = false;
+  try {
+    lanczosEigen(laplacian, n, 0);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void arnoldiFindsComplexEigenpairs() {
+  // A = S * B * S^-1 with a dominant complex pair 10 +/- 3i, then a real
+  // eigenvalue of -9, then smaller ones.
+  size_t n = 200;
+  Matrix B(n, n);
+  B(0, 0) = 10.0;
+  B(1, 0) = 3.0;
+  B(0, 1) = -3.0;
+  B(1, 1) = 10.0;
+  B(2, 2) = -9.0;
+  for (size_t i = 3; i < n; i++) {
+    B(i, i) = randomDouble(-5.0, 5.0);
+  }
+  Matrix S = generateNonsingularMatrix(n, n);
+  Matrix A = S * B * S.inverse();
+  KrylovEigenpairs result = arnoldiEigen(A, 3);
+  ASSERT(result.converged);
+  ASSERT_EQ(result.values.height(), 3);
+  ASSERT_TOL(result.values(0, 0), 10.0, 1e-8);
+  ASSERT_TOL(result.values(1, 0), 3.0, 1e-8);
+  ASSERT_TOL(result.values(0, 1), 10.0, 1e-8);
+  ASSERT_TOL(result.values(1, 1), -3.0, 1e-8);
+  ASSERT_TOL(result.values(0, 2), -9.0, 1e-8);
+  ASSERT_TOL(result.values(1, 2), 0.0, 1e-8);
+  // A * (xr + i * xi) = (a + i * b) * (xr + i * xi).
+  Matrix xr = column(result.vectors, 0);
+  Matrix xi = column(result.vectors, 1);
+  double scale = A.norm();
+  ASSERT((A * xr - (xr * 10.0 - xi * 3.0)).norm() < 1e-8 * scale);
+  ASSERT((A * xi - (xr * 3.0 + xi * 10.0)).norm() < 1e-8 * scale);
+  Matrix x = column(result.vectors, 2);
+  ASSERT((A * x + x * 9.0).norm() < 1e-8 * scale);
+
+  // Asking for just the first eigenvalue of the pair returns both.
+  result = arnoldiEigen(A, 1);
+  ASSERT(result.converged);
+  ASSERT_EQ(result.values.height(), 2);
+}
+
+int main() {
+  lanczosFindsExtremalEigenpairs();
+  lanczosWorksOnOperators();
+  arnoldiFindsComplexEigenpairs();
+}
@@ -156,6 +156,39 @@ void lupDeterminantWorks() {
   }
 }
 
+void luFactorizeWorks() {
+  size_t num_trials = 20;
+  for (size_t trial = 0; trial < num_trials; trial++) {
+    size_t n = randomInt<size_t>(1, 40);
+    Matrix A = generateNonsingularMatrix(n, n);
+    Matrix LU = A;
+    std::vector<size_t> pivots;
+    ASSERT(luFactorize(LU, pivots));
+    ASSERT_EQ(pivots.size(), n);
+    Matrix L = identity(n);
+    Matrix U(n, n);
+    for (size_t y = 0; y < n; y++) {
+      for (size_t x = 0; x < n; x++) {
+        (x < y ? L : U)(x, y) = LU(x, y);
+      }
+    }
+    Matrix PA = A;
+    for (size_t y = 0; y < n; y++) {
+      PA.swapRows(y, pivots[y]);
+    }
+    ASSERT_MATRIX_NEAR_TOL(PA, L * U, 1e-9);
+
+    Matrix x = randomMatrix(3, n, -10.0, 10.0);
+    Matrix b = A * x;
+    solveLU(LU, pivots, b);
+    ASSERT_MATRIX_NEAR_TOL(x, b, 1e-6);
+  }
+  // A zero column cannot be pivoted.
+  Matrix singular = {{1, 0, 2}, {3, 0, 4}, {5, 0, 6}};
+  std::vector<size_t> pivots;
+  ASSERT(!luFactorize(singular, pivots));
+}
+
 int main() {
   pivotWorks();
   luDecompositionObeysDefinition();
@@ -165,4 +198,5 @@ int main() {
   solveLUPWorks();
   lupDeterminantWorks();
   lupDecompositionFailsForSingularMatrices();
+  luFactorizeWorks();
 }
@@ -1,6 +1,7 @@
 #include "matrix.hpp"
 #include "matrix_helpers.hpp"
 #include "test_helpers.hpp"
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <sstream>
@@ -209,6 +210,15 @@ void wrappedMatricesWork() {
   }
 }
 
+void detOfEmptyMatrixIsOne() {
+  Matrix mat(0, 0);
+  ASSERT_EQ(mat.det(), 1.0);
+  std::pair<double, double> result = mat.slogdet();
+  ASSERT_EQ(result.first, 1.0);
+  ASSERT_EQ(result.second, 0.0);
+  ASSERT_EQ(mat.det(), result.first * exp(result.second));
+}
+
 void detWorksOn1x1() {
   Matrix mat = {2.2};
   double det = mat.det();
@@ -234,6 +244,45 @@ void detWorksOn4x4() {
   ASSERT_NEAR(det, -54.0);
 }
 
+void slogdetWorks() {
+  Matrix mat = {
+      {1, 4, 11, 12}, {4, 59, 63, 64}, {7, 18, 9, 10}, {12, 49, 19, 19}};
+  std::pair<double, double> result = mat.slogdet();
+  ASSERT_EQ(result.first, -1.0);
+  ASSERT_NEAR(result.second, log(54.0));
+  ASSERT_NEAR(mat.logAbsDet(), log(54.0));
+
+  // The determinant, 10^500, overflows, but its logarithm does not.
+  size_t n = 500;
+  Matrix big(n, n);
+  for (size_t i = 0; i < n; i++) {
+    big(i, i) = (i % 2 == 0) ? 10.0 : -10.0;
+    if (i + 1 < n) {
+      big(i + 1, i) = 3.0;
+    }
+  }
+  result = big.slogdet();
+  ASSERT_EQ(result.first, 1.0);
+  ASSERT_TOL(result.second, n * log(10.0), 1e-9);
+  ASSERT(std::isinf(big.det()));
+
+  Matrix singular = {{1, 2}, {2, 4}};
+  ASSERT_EQ(singular.det(), 0.0);
+  result = singular.slogdet();
+  ASSERT_EQ(result.first, 0.0);
+  ASSERT(std::isinf(result.second) && result.second < 0.0);
+}
+
+void detDoesNotOverflowInternally() {
+  // The product of the first two pivots overflows, but the determinant is 1.
+  Matrix mat(4, 4);
+  mat(0, 0) = 1e200;
+  mat(1, 1) = 1e200;
+  mat(2, 2) = 1e-200;
+  mat(3, 3) = 1e-200;
+  ASSERT_TOL(mat.det(), 1.0, 1e-12);
+}
+
 void equalsWorks() {
   Matrix mat = {
       {1, 4, 11, 12}, {4, 59, 63, 64}, {7, 18, 9, 10}, {12, 49, 19, 19}};
@@ -291,6 +340,43 @@ void sumColsWorks() {
   ASSERT_MATRIX_NEAR(col_sum, mat_expected);
 }
 
+void assignmentCopiesOk() {
+  // A failure result stays a failure when it is assigned.
+  Matrix result(2, 2);
+  ASSERT(result.ok());
+  result = Matrix();
+  ASSERT(!result.ok());
+  result = Matrix(3, 3);
+  ASSERT(result.ok());
+  Matrix copy;
+  copy = result;
+  ASSERT(copy.ok());
+  Matrix failed;
+  Matrix failed_copy = failed;
+  ASSERT(!failed_copy.ok());
+  Matrix ok_copy = result;
+  ASSERT(ok_copy.ok());
+
+  // An ROI is a view of its source; assigning to it writes the source's
+  // entries and leaves the view's own ok() alone.
+  Matrix source(4, 4);
+  Matrix roi(MatrixROI(1, 1, 2, 2, &source));
+  ASSERT(roi.ok());
+  roi = Matrix({{1.0, 2.0}, {3.0, 4.0}});
+  ASSERT(roi.ok());
+  ASSERT(source.ok());
+  ASSERT_EQ(source(2, 2), 4.0);
+  // A failed result cannot be assigned to an ROI, whose size is fixed.
+  bool threw = false;
+  try {
+    roi = Matrix();
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ASSERT(roi.ok());
+}
+
 int main() {
   emptyMatrix();
   initWorks();
@@ -298,14 +384,18 @@ int main() {
   boundingBoxWorks();
   roisWork();
   wrappedMatricesWork();
+  detOfEmptyMatrixIsOne();
   detWorksOn1x1();
   detWorksOn2x2();
   detWorksOn3x3();
   detWorksOn4x4();
+  slogdetWorks();
+  detDoesNotOverflowInternally();
   equalsWorks();
   rowWorks();
   colWorks();
   reshapeWorks();
   sumRowsWorks();
   sumColsWorks();
+  assignmentCopiesOk();
 }
@@ -0,0 +1,73 @@
+#include "mixed_precision.hpp"
+#include "lup_decomposition.hpp"
+#include "matrix_helpers.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+void solveMixedPrecisionWorks() {
+  size_t n = 120;
+  Matrix A = randomMatrix(n, n, -1.0, 1.0);
+  for (size_t i = 0; i < n; i++) {
+    A(i, i) += 10.0;
+  }
+  Matrix x = randomMatrix(3, n, -1.0, 1.0);
+  Matrix b = A * x;
+  MixedPrecisionResult result;
+  ASSERT(solveMixedPrecision(A, b, &result));
+  ASSERT(!result.used_double);
+  ASSERT(result.iterations > 0);
+  // As accurate as a double solve, well beyond float precision.
+  ASSERT_MATRIX_NEAR_TOL(b, x, 1e-12);
+}
+
+void fallsBackToDouble() {
+  // The Hilbert matrix is too ill-conditioned for float factors to help.
+  size_t n = 9;
+  Matrix A(n, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      A(x, y) = 1.0 / (x + y + 1.0);
+    }
+  }
+  Matrix x = randomMatrix(1, n, -1.0, 1.0);
+  Matrix b = A * x;
+  Matrix expected = b;
+  Matrix LU = A;
+  std::vector<size_t> pivots;
+  ASSERT(luFactorize(LU, pivots));
+  solveLU(LU, pivots, expected);
+  MixedPrecisionResult result;
+  ASSERT(solveMixedPrecision(A, b, &result));
+  ASSERT(result.used_double);
+  ASSERT_MATRIX_NEAR(b, expected);
+
+  // Entries that do not fit in a float.
+  Matrix big = identity(3) * 1e300;
+  Matrix c = randomMatrix(1, 3, -1.0, 1.0);
+  Matrix big_expected = c / 1e300;
+  ASSERT(solveMixedPrecision(big, c, &result));
+  ASSERT(result.used_double);
+  ASSERT_MATRIX_NEAR_TOL(c * 1e300, big_expected * 1e300, 1e-12);
+
+  Matrix singular = {{1.0, 2.0}, {2.0, 4.0}};
+  Matrix d = randomMatrix(1, 2, -1.0, 1.0);
+  Matrix d_before = d;
+  ASSERT(!solveMixedPrecision(singular, d));
+  ASSERT_MATRIX_NEAR(d, d_before);
+}
+
+void inverseMixedPrecisionWorks() {
+  size_t n = 40;
+  Matrix A = generateNonsingularMatrix(n, n);
+  Matrix inverse = inverseMixedPrecision(A);
+  ASSERT(inverse.ok());
+  ASSERT_MATRIX_NEAR_TOL(inverse, A.inverse(), 1e-8);
+  ASSERT(!inverseMixedPrecision(Matrix({{1.0, 1.0}, {1.0, 1.0}})).ok());
+}
+
+int main() {
+  solveMixedPrecisionWorks();
+  fallsBackToDouble();
+  inverseMixedPrecisionWorks();
+}
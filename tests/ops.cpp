@@ -1,5 +1,6 @@
 #include "matrix.hpp"
 #include "matrix_helpers.hpp"
+#include "parallel.hpp"
 #include "test_helpers.hpp"
 #include <chrono>
 #include <math.h>
@@ -174,6 +175,7 @@ void swapColsWorks() {
                        {17.17, 18.18, 20.2, 19.19},
                        {21.21, 22.22, 24.24, 23.23}});
   mat_result.swapCols(2, 3);
+  ASSERT_MATRIX_NEAR(mat_expected, mat_result);
 }
 
 void scalarMultiplyWorks() {
@@ -276,6 +278,94 @@ void simdWorks() {
     simdMultiply(A, B, C_simd);
     ASSERT_MATRIX_NEAR(C_naive, C_simd);
   }
+  // Large enough that row blocks are spread over threads.
+  setNumThreads(4);
+  Matrix A = randomMatrix(150, 700, -1.0, 1.0);
+  Matrix B = randomMatrix(190, 150, -1.0, 1.0);
+  Matrix C_naive(190, 700);
+  Matrix C_simd(190, 700);
+  naiveMultiply(A, B, C_naive);
+  simdMultiply(A, B, C_simd);
+  ASSERT_MATRIX_NEAR(C_naive, C_simd);
+  setNumThreads(0);
+}
+
+void symmetricRankKUpdateWorks() {
+  for (int trial = 0; trial < 50; trial++) {
+    size_t w = rand() % 40 + 1;
+    size_t h = rand() % 40 + 1;
+    Matrix A = randomMatrix(w, h, -10.0, 10.0);
+    Matrix AtA_expected(w, w);
+    naiveMultiply(A.transpose(), A, AtA_expected);
+    Matrix AtA;
+    symmetricRankKUpdate(A, AtA);
+    ASSERT_MATRIX_NEAR_TOL(AtA, AtA_expected, 1e-8);
+
+    Matrix AAt_expected(h, h);
+    naiveMultiply(A, A.transpose(), AAt_expected);
+    Matrix AAt;
+    symmetricRankKUpdate(A, AAt, false);
+    ASSERT_MATRIX_NEAR_TOL(AAt, AAt_expected, 1e-8);
+
+    // Accumulation: C = 2 * A^T * A - C
+    Matrix C = randomMatrix(w, w, -10.0, 10.0);
+    Matrix C_expected = 2.0 * AtA_expected - C;
+    symmetricRankKUpdate(A, C, true, 2.0, -1.0, false);
+    for (size_t x = 0; x < w; x++) {
+      for (size_t y = 0; y <= x; y++) {
+        ASSERT_TOL(C(x, y), C_expected(x, y), 1e-8);
+      }
+    }
+
+    // Transposed ROIs are packed before the update.
+    Matrix AtA_roi;
+    symmetricRankKUpdate(A.transposeROI(), AtA_roi, false);
+    ASSERT_MATRIX_NEAR_TOL(AtA_roi, AtA_expected, 1e-8);
+  }
+}
+
+void packedSymmetricRankKUpdateWorks() {
+  for (int trial = 0; trial < 50; trial++) {
+    size_t w = rand() % 70 + 1;
+    size_t h = rand() % 300 + 1;
+    Matrix A = randomMatrix(w, h, -10.0, 10.0);
+    Matrix AtA(w, w);
+    naiveMultiply(A.transpose(), A, AtA);
+    Matrix AAt(h, h);
+    naiveMultiply(A, A.transpose(), AAt);
+
+    // Row y of the packed lower triangle starts at y(y+1)/2.
+    std::vector<double> c(w * (w + 1) / 2, NAN);
+    packedSymmetricRankKUpdate(A, c.data());
+    for (size_t y = 0; y < w; y++) {
+      for (size_t x = 0; x <= y; x++) {
+        ASSERT_TOL(c[y * (y + 1) / 2 + x], AtA(x, y), 1e-8);
+      }
+    }
+    // Accumulation: c = 2 * A^T * A - c
+    packedSymmetricRankKUpdate(A, c.data(), true, 2.0, -1.0);
+    for (size_t y = 0; y < w; y++) {
+      for (size_t x = 0; x <= y; x++) {
+        ASSERT_TOL(c[y * (y + 1) / 2 + x], AtA(x, y), 1e-8);
+      }
+    }
+    // A transposed ROI is packed before the update.
+    std::vector<double> c_roi(w * (w + 1) / 2);
+    packedSymmetricRankKUpdate(A.transposeROI(), c_roi.data(), false);
+    for (size_t y = 0; y < w; y++) {
+      for (size_t x = 0; x <= y; x++) {
+        ASSERT_TOL(c_roi[y * (y + 1) / 2 + x], AtA(x, y), 1e-8);
+      }
+    }
+
+    std::vector<double> d(h * (h + 1) / 2);
+    packedSymmetricRankKUpdate(A, d.data(), false);
+    for (size_t y = 0; y < h; y++) {
+      for (size_t x = 0; x <= y; x++) {
+        ASSERT_TOL(d[y * (y + 1) / 2 + x], AAt(x, y), 1e-8);
+      }
+    }
+  }
 }
 
 int main() {
@@ -296,4 +386,6 @@ int main() {
   scalarDivideWorks();
   negationWorks();
   simdWorks();
+  symmetricRankKUpdateWorks();
+  packedSymmetricRankKUpdateWorks();
 }
@@ -0,0 +1,145 @@
+#include "packed_matrix.hpp"
+#include "lup_decomposition.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+/// A random well-conditioned lower-triangular n x n matrix.
+Matrix randomLower(const size_t &n) {
+  Matrix result(n, n);
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < y; x++) {
+      result(x, y) = randomDouble(-1.0, 1.0) / n;
+    }
+    result(y, y) = randomDouble(1.0, 2.0);
+  }
+  return result;
+}
+}; // namespace
+
+void lowerTriangularWorks() {
+  size_t n = 30;
+  Matrix dense = randomLower(n);
+  LowerTriangular L(dense);
+  ASSERT_EQ(L.packed().size(), n * (n + 1) / 2);
+  ASSERT_MATRIX_NEAR(L.toDense(), dense);
+  const LowerTriangular &const_L = L;
+  ASSERT_EQ(const_L(3, 2), 0.0);
+  ASSERT_EQ(const_L(2, 3), dense(2, 3));
+  bool threw = false;
+  try {
+    L(3, 2) = 1.0;
+  } catch (const std::out_of_range &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+
+  Matrix B = randomMatrix(4, n, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(L * B, dense * B);
+  Matrix x = B;
+  L.solve(x);
+  ASSERT_MATRIX_NEAR(dense * x, B);
+  x = B;
+  L.solveTransposed(x);
+  ASSERT_MATRIX_NEAR(dense.transpose() * x, B);
+
+  Matrix unit = dense;
+  for (size_t i = 0; i < n; i++) {
+    unit(i, i) = 1.0;
+  }
+  x = B;
+  L.solve(x, true);
+  ASSERT_MATRIX_NEAR(unit * x, B);
+}
+
+void upperTriangularWorks() {
+  size_t n = 25;
+  Matrix dense = randomLower(n).transpose();
+  UpperTriangular U(dense);
+  ASSERT_EQ(U.packed().size(), n * (n + 1) / 2);
+  ASSERT_MATRIX_NEAR(U.toDense(), dense);
+  const UpperTriangular &const_U = U;
+  ASSERT_EQ(const_U(2, 3), 0.0);
+  ASSERT_EQ(const_U(3, 2), dense(3, 2));
+
+  Matrix B = randomMatrix(3, n, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(U * B, dense * B);
+  Matrix x = B;
+  U.solve(x);
+  ASSERT_MATRIX_NEAR(dense * x, B);
+  // A non-contiguous right-hand side.
+  Matrix BB = randomMatrix(4, n, -1.0, 1.0);
+  Matrix roi(MatrixROI(1, 0, 2, n, &BB));
+  Matrix expected = roi;
+  U.solve(roi);
+  ASSERT_MATRIX_NEAR(dense * roi, expected);
+}
+
+void symmetricWorks() {
+  size_t n = 20;
+  Matrix A = randomMatrix(n, n, -1.0, 1.0);
+  Matrix dense = A + A.transpose();
+  SymmetricMatrix S(dense);
+  ASSERT_MATRIX_NEAR(S.toDense(), dense);
+  ASSERT_EQ(S(3, 7), S(7, 3));
+  S(3, 7) = 5.0;
+  ASSERT_EQ(S(7, 3), 5.0);
+  dense(3, 7) = 5.0;
+  dense(7, 3) = 5.0;
+  Matrix B = randomMatrix(2, n, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(S * B, dense * B);
+}
+
+void gramAndCholeskyWork() {
+  setNumThreads(4);
+  Matrix J = randomMatrix(12, 200, -1.0, 1.0);
+  SymmetricMatrix JtJ = gramMatrix(J);
+  Matrix expected = J.transpose() * J;
+  ASSERT_MATRIX_NEAR_TOL(JtJ.toDense(), expected, 1e-10);
+  setNumThreads(0);
+
+  LowerTriangular L;
+  ASSERT(choleskyFactorize(JtJ, L));
+  Matrix L_dense = L.toDense();
+  ASSERT_MATRIX_NEAR_TOL(L_dense * L_dense.transpose(), expected, 1e-10);
+  Matrix x = randomMatrix(2, 12, -1.0, 1.0);
+  Matrix b = expected * x;
+  solveCholesky(L, b);
+  ASSERT_MATRIX_NEAR_TOL(b, x, 1e-10);
+
+  // Rank-deficient: the last column is zero.
+  for (size_t y = 0; y < J.height(); y++) {
+    J(11, y) = 0.0;
+  }
+  ASSERT(!choleskyFactorize(gramMatrix(J), L));
+}
+
+void unpackLUWorks() {
+  size_t n = 15;
+  Matrix A = generateNonsingularMatrix(n, n);
+  Matrix LU = A;
+  std::vector<size_t> pivots;
+  ASSERT(luFactorize(LU, pivots));
+  LowerTriangular L;
+  UpperTriangular U;
+  unpackLU(LU, L, U);
+  Matrix b = randomMatrix(1, n, -1.0, 1.0);
+  Matrix x = b;
+  for (size_t i = 0; i < n; i++) {
+    std::swap(x(0, i), x(0, pivots[i]));
+  }
+  L.solve(x, true);
+  U.solve(x);
+  ASSERT_MATRIX_NEAR_TOL(A * x, b, 1e-9);
+}
+
+int main() {
+  lowerTriangularWorks();
+  upperTriangularWorks();
+  symmetricWorks();
+  gramAndCholeskyWork();
+  unpackLUWorks();
+}
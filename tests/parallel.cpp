@@ -0,0 +1,128 @@
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+#include <atomic>
+#include <vector>
+
+using namespace basic_matrix;
+
+void parallelForVisitsEveryIndexOnce() {
+  for (size_t num_threads : {1, 2, 5}) {
+    setNumThreads(num_threads);
+    ASSERT_EQ(numThreads(), num_threads);
+    std::vector<std::atomic<int>> visits(1000);
+    parallelFor(10, visits.size(), [&](const size_t &i) { visits[i]++; });
+    for (size_t i = 0; i < visits.size(); i++) {
+      ASSERT_EQ(visits[i].load(), i < 10 ? 0 : 1);
+    }
+  }
+  setNumThreads(0);
+  ASSERT(numThreads() > 0);
+}
+
+void parallelForRethrows() {
+  setNumThreads(4);
+  bool thrown = false;
+  try {
+    parallelFor(0, 100, [](const size_t &i) {
+      if (i == 77) {
+        throw std::runtime_error("77");
+      }
+    });
+  } catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  setNumThreads(0);
+}
+
+void parallelForNestsAndRepeats() {
+  setNumThreads(4);
+  // Many short calls reuse the same threads, and a call made from inside
+  // another one finishes even with every thread busy.
+  std::vector<std::atomic<int>> visits(64 * 64);
+  for (size_t step = 0; step < 200; step++) {
+    parallelFor(0, 64, [&](const size_t &y) {
+      parallelFor(0, 64, [&](const size_t &x) { visits[y * 64 + x]++; });
+    });
+  }
+  for (const auto &count : visits) {
+    ASSERT_EQ(count.load(), 200);
+  }
+  setNumThreads(0);
+}
+
+void taskGraphRespectsDependencies() {
+  for (size_t num_threads : {1, 3, 8}) {
+    setNumThreads(num_threads);
+    // A chain per column of a grid, where each task also waits for its
+    // left neighbour in the previous row.
+    size_t rows = 20;
+    size_t columns = 30;
+    std::vector<std::atomic<int>> finished(rows * columns);
+    std::atomic<bool> in_order(true);
+    TaskGraph graph;
+    for (size_t y = 0; y < rows; y++) {
+      for (size_t x = 0; x < columns; x++) {
+        std::vector<size_t> dependencies;
+        if (y > 0) {
+          dependencies.push_back((y - 1) * columns + x);
+          size_t left = (x + columns - 1) % columns;
+          dependencies.push_back((y - 1) * columns + left);
+          // Duplicates are fine.
+          dependencies.push_back((y - 1) * columns + x);
+        }
+        size_t id = graph.add(
+            [&, dependencies, y, x]() {
+              for (const auto &dependency : dependencies) {
+                if (finished[dependency].load() != 1) {
+                  in_order = false;
+                }
+              }
+              finished[y * columns + x]++;
+            },
+            dependencies, x == 0);
+        ASSERT_EQ(id, y * columns + x);
+      }
+    }
+    ASSERT_EQ(graph.size(), rows * columns);
+    graph.run();
+    ASSERT(in_order.load());
+    for (const auto &count : finished) {
+      ASSERT_EQ(count.load(), 1);
+    }
+  }
+  setNumThreads(0);
+}
+
+void taskGraphRethrows() {
+  setNumThreads(4);
+  TaskGraph graph;
+  std::atomic<int> after_failure(0);
+  size_t failing = graph.add([]() { throw std::runtime_error("failed"); });
+  graph.add([&]() { after_failure++; }, {failing});
+  bool thrown = false;
+  try {
+    graph.run();
+  } catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  ASSERT_EQ(after_failure.load(), 0);
+
+  thrown = false;
+  try {
+    graph.add([]() {}, {graph.size()});
+  } catch (const std::out_of_range &) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  setNumThreads(0);
+}
+
+int main() {
+  parallelForVisitsEveryIndexOnce();
+  parallelForRethrows();
+  parallelForNestsAndRepeats();
+  taskGraphRespectsDependencies();
+  taskGraphRethrows();
+}
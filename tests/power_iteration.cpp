@@ -0,0 +1,157 @@
+#include "power_iteration.hpp"
+#include "matrix_helpers.hpp"
+#include "qr_factorization.hpp"
+#include "test_helpers.hpp"
+#include <algorithm>
+
+using namespace basic_matrix;
+
+namespace {
+/// A symmetric matrix Q * diag(spectrum) * Q^T, with Q random and
+/// orthogonal.
+Matrix symmetricWithSpectrum(const std::vector<double> &spectrum) {
+  size_t n = spectrum.size();
+  Matrix Q;
+  Matrix R = randomMatrix(n, n, -1.0, 1.0);
+  qrFactorize(Q, R);
+  Matrix QD = Q;
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      QD(x, y) *= spectrum[x];
+    }
+  }
+  return QD * Q.transpose();
+}
+
+void assertEigenpair(const Matrix &A, const Eigenpair &pair,
+                     const double &expected, const double &tol) {
+  ASSERT(pair.converged);
+  ASSERT_TOL(pair.value, expected, tol);
+  ASSERT_TOL(pair.vector.norm(), 1.0, 1e-12);
+  ASSERT((A * pair.vector - pair.vector * pair.value).norm() <
+         tol * A.norm());
+}
+}; // namespace
+
+void powerIterationWorks() {
+  std::vector<double> spectrum = {-10.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.5, -0.5};
+  Matrix A = symmetricWithSpectrum(spectrum);
+  Eigenpair result = powerIteration(A);
+  assertEigenpair(A, result, -10.0, 1e-9);
+
+  // A warm start from the answer converges immediately.
+  PowerIterationOptions options;
+  options.initial_vector = result.vector;
+  Eigenpair warm = powerIteration(A, options);
+  assertEigenpair(A, warm, -10.0, 1e-9);
+  ASSERT(warm.iterations <= 1);
+
+  // A non-symmetric matrix through an operator.
+  Matrix B = {{2.0, 1.0}, {1.0, 3.0}};
+  B(1, 0) = 0.5;
+  size_t num_matvecs = 0;
+  LinearOperator op = [&](const Matrix &x) {
+    num_matvecs++;
+    return B * x;
+  };
+  result = powerIteration(op, 2);
+  ASSERT(result.converged);
+  ASSERT_EQ(num_matvecs, result.iterations + 1);
+  double expected = 2.5 + sqrt(0.25 + 0.5);
+  ASSERT_TOL(result.value, expected, 1e-9);
+
+  // +/- lambda never settles.
+  Matrix flip = {{0.0, 1.0}, {1.0, 0.0}};
+  options = PowerIterationOptions();
+  options.initial_vector = Matrix(1, 2);
+  options.initial_vector(0, 0) = 1.0;
+  options.max_iterations = 50;
+  result = powerIteration(flip, options);
+  ASSERT(!result.converged);
+  ASSERT_EQ(result.iterations, 50);
+}
+
+void inverseIterationWorks() {
+  size_t n = 60;
+  std::vector<double> spectrum;
+  for (size_t i = 0; i < n; i++) {
+    spectrum.push_back(double(i) - 20.0);
+  }
+  Matrix A = symmetricWithSpectrum(spectrum);
+  // The eigenvalue closest to the shift, from the middle of the spectrum.
+  Eigenpair result = inverseIteration(A, 3.3);
+  assertEigenpair(A, result, 3.0, 1e-9);
+  ASSERT(result.iterations < 40);
+
+  // A shift that is exactly an eigenvalue still works.
+  Matrix D = Matrix({{2.0, 0.0}, {0.0, 7.0}});
+  result = inverseIteration(D, 7.0);
+  assertEigenpair(D, result, 7.0, 1e-12);
+
+  // Non-symmetric, with eigenvalues 1, 2 and 3.
+  Matrix S = generateNonsingularMatrix(3, 3);
+  Matrix B = S * Matrix({{1.0, 0.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 3.0}}) *
+             S.inverse();
+  result = inverseIteration(B, 1.8);
+  assertEigenpair(B, result, 2.0, 1e-8);
+}
+
+void rayleighQuotientIterationWorks() {
+  size_t n = 40;
+  std::vector<double> spectrum;
+  for (size_t i = 0; i < n; i++) {
+    spectrum.push_back(randomDouble(-50.0, 50.0));
+  }
+  Matrix A = symmetricWithSpectrum(spectrum);
+  // Start from a rough eigenvector.
+  PowerIterationOptions options;
+  options.max_iterations = 3;
+  options.tolerance = 0.0;
+  Eigenpair rough = powerIteration(A, options);
+  ASSERT(!rough.converged);
+
+  options = PowerIterationOptions();
+  options.initial_vector = rough.vector;
+  options.tolerance = 1e-13;
+  Eigenpair result = rayleighQuotientIteration(A, options);
+  ASSERT(result.converged);
+  ASSERT(result.iterations < 20);
+  ASSERT((A * result.vector - result.vector * result.value).norm() <
+         1e-12 * A.norm());
+  ASSERT(std::any_of(spectrum.begin(), spectrum.end(), [&](const double &l) {
+    return fabs(l - result.value) < 1e-10;
+  }));
+
+  bool threw = false;
+  try {
+    options.initial_vector = Matrix(1, n + 1);
+    rayleighQuotientIteration(A, options);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void copiedOptionsStartRandomly() {
+  // A copy of the default options still has no initial vector.
+  PowerIterationOptions defaults;
+  std::vector<PowerIterationOptions> copies = {defaults};
+  PowerIterationOptions options = copies[0];
+  ASSERT(!options.initial_vector.ok());
+  std::vector<double> spectrum = {9.0, 4.0, -2.0, 1.0};
+  Matrix A = symmetricWithSpectrum(spectrum);
+  assertEigenpair(A, powerIteration(A, options), 9.0, 1e-9);
+  assertEigenpair(A, inverseIteration(A, -1.5, options), -2.0, 1e-9);
+  Eigenpair result = rayleighQuotientIteration(A, options);
+  ASSERT(result.converged);
+  ASSERT(std::any_of(spectrum.begin(), spectrum.end(), [&](const double &l) {
+    return fabs(l - result.value) < 1e-9;
+  }));
+}
+
+int main() {
+  powerIterationWorks();
+  inverseIterationWorks();
+  rayleighQuotientIterationWorks();
+  copiedOptionsStartRandomly();
+}
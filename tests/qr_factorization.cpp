@@ -1,5 +1,8 @@
 #include "qr_factorization.hpp"
 #include "matrix_helpers.hpp"
+#include "io.hpp"
+#include "parallel.hpp"
+#include "scalar.hpp"
 #include "test_helpers.hpp"
 
 using namespace basic_matrix;
@@ -71,9 +74,148 @@ void qrSolveWorksForUnderconstrainedSystems() {
   }
 }
 
+void householderQRObeysDefinition() {
+  size_t num_trials = 20;
+  for (size_t trial = 0; trial < num_trials; trial++) {
+    // Large enough to span several reflector blocks.
+    size_t w = randomInt<size_t>(1, 80);
+    size_t h = randomInt<size_t>(1, 120);
+    Matrix A = randomMatrix(w, h, -10.0, 10.0);
+    Matrix QR = A;
+    Matrix tau;
+    householderQR(QR, tau);
+    ASSERT_EQ(tau.height(), std::min(w, h));
+    Matrix R(w, std::min(w, h));
+    for (size_t x = 0; x < w; x++) {
+      for (size_t y = 0; y <= x && y < R.height(); y++) {
+        R(x, y) = QR(x, y);
+      }
+    }
+    Matrix Q = formQ(QR, tau, true);
+    ASSERT_MATRIX_NEAR_TOL(Q * R, A, 1e-8);
+    ASSERT_MATRIX_NEAR_TOL(Q.transpose() * Q, identity(Q.width()), 1e-10);
+    Matrix Q_full = formQ(QR, tau);
+    ASSERT_MATRIX_NEAR_TOL(Q_full.transpose() * Q_full, identity(h), 1e-10);
+  }
+}
+
+void applyQMatchesFormQ() {
+  size_t w = 45;
+  size_t h = 70;
+  Matrix A = randomMatrix(w, h, -10.0, 10.0);
+  Matrix tau;
+  householderQR(A, tau);
+  Matrix Q = formQ(A, tau);
+  Matrix B = randomMatrix(3, h, -10.0, 10.0);
+  Matrix QB = B;
+  applyQ(A, tau, QB);
+  ASSERT_MATRIX_NEAR_TOL(QB, Q * B, 1e-9);
+  Matrix QtB = B;
+  applyQt(A, tau, QtB);
+  ASSERT_MATRIX_NEAR_TOL(QtB, Q.transpose() * B, 1e-9);
+  // Round trip through a non-contiguous matrix.
+  applyQ(A, tau, QtB);
+  Matrix QtB_roi(MatrixROI(0, 0, 3, h, &QtB));
+  applyQt(A, tau, QtB_roi);
+  applyQ(A, tau, QtB_roi);
+  ASSERT_MATRIX_NEAR_TOL(QtB, B, 1e-9);
+}
+
+void thinQrFactorizeObeysDefinition() {
+  size_t w = 7;
+  size_t h = 40;
+  Matrix A = randomMatrix(w, h, -10.0, 10.0);
+  Matrix Q;
+  Matrix R = A;
+  qrFactorize(Q, R, true);
+  ASSERT_EQ(Q.width(), w);
+  ASSERT_EQ(Q.height(), h);
+  ASSERT_EQ(R.width(), w);
+  ASSERT_EQ(R.height(), w);
+  ASSERT_MATRIX_NEAR_TOL(Q * R, A, 1e-9);
+}
+
+void qrSolveWorksForMultipleRightHandSides() {
+  size_t width = 6;
+  size_t height = 30;
+  Matrix A = randomMatrix(width, height, -100.0, 100.0);
+  Matrix X = randomMatrix(4, width, -10.0, 10.0);
+  Matrix B = A * X;
+  solveQR(A, B);
+  Matrix X_result(MatrixROI(0, 0, 4, width, &B));
+  ASSERT_MATRIX_NEAR_TOL(X, X_result, 1e-6);
+}
+
+void qrSolveWorksForTallSystems() {
+  // Forming a square Q here would take 3.2GB.
+  size_t width = 5;
+  size_t height = 20000;
+  Matrix A = randomMatrix(width, height, -1.0, 1.0);
+  Matrix x = randomMatrix(1, width, -10.0, 10.0);
+  Matrix b = A * x;
+  solveQR(A, b);
+  Matrix x_result(MatrixROI(0, 0, 1, width, &b));
+  ASSERT_MATRIX_NEAR_TOL(x, x_result, 1e-6);
+}
+
+void tsqrMatchesHouseholderR() {
+  setNumThreads(4);
+  size_t width = 9;
+  size_t height = 1000;
+  Matrix A = randomMatrix(width, height, -10.0, 10.0);
+  Matrix R_expected = A;
+  Matrix Q;
+  qrFactorize(Q, R_expected, true);
+  // 7 chunks gives an unbalanced reduction tree.
+  Matrix R = tsqrR(A, 7);
+  ASSERT_EQ(R.width(), width);
+  ASSERT_EQ(R.height(), width);
+  // R is unique up to the sign of each row.
+  for (size_t y = 0; y < width; y++) {
+    double flip = sign(R(y, y)) * sign(R_expected(y, y));
+    for (size_t x = 0; x < width; x++) {
+      ASSERT_TOL(flip * R(x, y), R_expected(x, y), 1e-8);
+    }
+  }
+  setNumThreads(0);
+}
+
+void tsqrSolveMatchesQRSolve() {
+  setNumThreads(3);
+  Matrix Xy = loadFromFile("tests/2d_linear_regression.txt");
+  Matrix X(3, Xy.height());
+  for (size_t y = 0; y < Xy.height(); y++) {
+    X(0, y) = 1;
+    X(1, y) = Xy(0, y);
+    X(2, y) = Xy(1, y);
+  }
+  Matrix b = Matrix(MatrixROI(2, 0, 1, Xy.height(), &Xy));
+  Matrix b_qr = b;
+  solveQR(X, b_qr);
+  Matrix b_tsqr = b;
+  solveTSQR(X, b_tsqr, 4);
+  ASSERT_MATRIX_NEAR_TOL(Matrix(MatrixROI(0, 0, 1, 3, &b_tsqr)),
+                         Matrix(MatrixROI(0, 0, 1, 3, &b_qr)), 1e-6);
+
+  // Multiple right-hand sides on a larger, exactly solvable system.
+  Matrix A = randomMatrix(6, 5000, -1.0, 1.0);
+  Matrix x = randomMatrix(2, 6, -10.0, 10.0);
+  Matrix B = A * x;
+  solveTSQR(A, B);
+  ASSERT_MATRIX_NEAR_TOL(Matrix(MatrixROI(0, 0, 2, 6, &B)), x, 1e-6);
+  setNumThreads(0);
+}
+
 int main() {
   obeysDefinition();
+  householderQRObeysDefinition();
+  applyQMatchesFormQ();
   qrSolveWorksForSquareMatrices();
   qrSolveWorksForOverconstrainedSystems();
   qrSolveWorksForUnderconstrainedSystems();
+  thinQrFactorizeObeysDefinition();
+  qrSolveWorksForMultipleRightHandSides();
+  qrSolveWorksForTallSystems();
+  tsqrMatchesHouseholderR();
+  tsqrSolveMatchesQRSolve();
 }
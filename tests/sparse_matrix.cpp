@@ -0,0 +1,121 @@
+#include "sparse_matrix.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+/// A random width x height matrix with about density * width * height
+/// nonzeros.
+Matrix randomSparseDense(const size_t &width, const size_t &height,
+                         const double &density) {
+  Matrix result(width, height);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      if (randomDouble(0.0, 1.0) < density) {
+        result(x, y) = randomDouble(-10.0, 10.0);
+      }
+    }
+  }
+  return result;
+}
+}; // namespace
+
+void constructionWorks() {
+  std::vector<Triplet> triplets = {
+      {2, 1, 4.0}, {0, 0, 1.0}, {2, 1, -1.0}, {1, 2, 5.0}, {0, 2, 0.0}};
+  SparseMatrix A(3, 3, triplets);
+  ASSERT_EQ(A.nonZeros(), 3);
+  ASSERT_EQ(A(0, 0), 1.0);
+  ASSERT_EQ(A(2, 1), 3.0);
+  ASSERT_EQ(A(1, 2), 5.0);
+  ASSERT_EQ(A(0, 2), 0.0);
+  ASSERT_MATRIX_NEAR(A.toDense(),
+                     Matrix({{1.0, 0.0, 0.0}, {0.0, 0.0, 3.0},
+                             {0.0, 5.0, 0.0}}));
+  ASSERT(A.rowStart() == std::vector<size_t>({0, 1, 2, 3}));
+  ASSERT(A.columnIndices() == std::vector<size_t>({0, 2, 1}));
+
+  Matrix dense = randomSparseDense(17, 11, 0.2);
+  SparseMatrix B(dense);
+  ASSERT_MATRIX_NEAR(B.toDense(), dense);
+  SparseMatrix dropped(Matrix({{1.0, 1e-12}, {-1e-12, 2.0}}), 1e-9);
+  ASSERT_EQ(dropped.nonZeros(), 2);
+
+  bool threw = false;
+  try {
+    SparseMatrix C(2, 2, {{2, 0, 1.0}});
+  } catch (const std::out_of_range &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void transposeWorks() {
+  Matrix dense = randomSparseDense(23, 9, 0.3);
+  SparseMatrix At = SparseMatrix(dense).transpose();
+  ASSERT_EQ(At.width(), 9);
+  ASSERT_EQ(At.height(), 23);
+  ASSERT_MATRIX_NEAR(At.toDense(), dense.transpose());
+  for (size_t y = 0; y < At.height(); y++) {
+    for (size_t i = At.rowStart()[y] + 1; i < At.rowStart()[y + 1]; i++) {
+      ASSERT(At.columnIndices()[i - 1] < At.columnIndices()[i]);
+    }
+  }
+}
+
+void productsWork() {
+  Matrix dense = randomSparseDense(40, 30, 0.1);
+  SparseMatrix A(dense);
+  Matrix x = randomMatrix(1, 40, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A * x, dense * x);
+  Matrix B = randomMatrix(5, 40, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A * B, dense * B);
+  Matrix C = randomMatrix(3, 30, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(A.transposeMultiply(C), dense.transpose() * C);
+  Matrix D = randomMatrix(30, 7, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(D * A, D * dense);
+  // A non-contiguous operand.
+  Matrix BB = randomMatrix(6, 40, -1.0, 1.0);
+  Matrix roi(MatrixROI(1, 0, 5, 40, &BB));
+  ASSERT_MATRIX_NEAR(A * roi, dense * roi);
+
+  // Large enough to run in parallel.
+  setNumThreads(4);
+  Matrix big = randomSparseDense(3000, 2000, 0.01);
+  SparseMatrix S(big);
+  Matrix v = randomMatrix(1, 3000, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(S * v, big * v);
+  Matrix W = randomMatrix(2000, 20, -1.0, 1.0);
+  ASSERT_MATRIX_NEAR(W * S, W * big);
+  setNumThreads(0);
+
+  bool threw = false;
+  try {
+    A * Matrix(1, 30);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void arithmeticWorks() {
+  Matrix a = randomSparseDense(12, 8, 0.3);
+  Matrix b = randomSparseDense(12, 8, 0.3);
+  SparseMatrix A(a);
+  SparseMatrix B(b);
+  ASSERT_MATRIX_NEAR((A + B).toDense(), a + b);
+  ASSERT_MATRIX_NEAR((A - B).toDense(), a - b);
+  ASSERT_MATRIX_NEAR((A * 2.5).toDense(), a * 2.5);
+  ASSERT_EQ((A - A).nonZeros(), 0);
+  ASSERT_MATRIX_NEAR(A + b, a + b);
+  ASSERT_MATRIX_NEAR(A - b, a - b);
+}
+
+int main() {
+  constructionWorks();
+  transposeWorks();
+  productsWork();
+  arithmeticWorks();
+}
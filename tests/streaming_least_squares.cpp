@@ -0,0 +1,114 @@
+#include "streaming_least_squares.hpp"
+#include "matrix_helpers.hpp"
+#include "qr_factorization.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+Matrix rows(const Matrix &A, const size_t &y0, const size_t &y1) {
+  Matrix result(A.width(), y1 - y0);
+  for (size_t y = y0; y < y1; y++) {
+    for (size_t x = 0; x < A.width(); x++) {
+      result(x, y - y0) = A(x, y);
+    }
+  }
+  return result;
+}
+
+Matrix batchSolution(const Matrix &A, const Matrix &b) {
+  Matrix x = b;
+  solveQR(A, x);
+  return rows(x, 0, A.width());
+}
+}; // namespace
+
+void streamingMatchesBatchSolution() {
+  size_t n = 5;
+  Matrix A = randomMatrix(n, 200, -10.0, 10.0);
+  Matrix b = A * randomMatrix(1, n, -10.0, 10.0) +
+             randomMatrix(1, 200, -1.0, 1.0);
+  StreamingLeastSquares streaming(n);
+  ASSERT(!streaming.solve().ok());
+  for (size_t y = 0; y < A.height(); y += 20) {
+    streaming.addRows(rows(A, y, y + 20), rows(b, y, y + 20));
+    Matrix A_so_far = rows(A, 0, y + 20);
+    Matrix b_so_far = rows(b, 0, y + 20);
+    Matrix x = batchSolution(A_so_far, b_so_far);
+    ASSERT_MATRIX_NEAR_TOL(streaming.solve(), x, 1e-8);
+    ASSERT_TOL(streaming.residualNorm(), (A_so_far * x - b_so_far).norm(),
+               1e-8);
+  }
+  ASSERT_EQ(streaming.numRows(), 200);
+}
+
+void removeRowsUndoesAddRows() {
+  size_t n = 4;
+  Matrix A = randomMatrix(n, 60, -10.0, 10.0);
+  Matrix b = randomMatrix(1, 60, -10.0, 10.0);
+  StreamingLeastSquares streaming(n);
+  streaming.addRows(A, b);
+  ASSERT(streaming.removeRows(rows(A, 0, 25), rows(b, 0, 25)));
+  ASSERT_EQ(streaming.numRows(), 35);
+  Matrix x = batchSolution(rows(A, 25, 60), rows(b, 25, 60));
+  ASSERT_MATRIX_NEAR_TOL(streaming.solve(), x, 1e-8);
+  // Removing more rows than there are parameters cannot work.
+  StreamingLeastSquares small(n);
+  small.addRows(rows(A, 0, 6), rows(b, 0, 6));
+  ASSERT(!small.removeRows(rows(A, 0, 3), rows(b, 0, 3)));
+}
+
+void slidingWindowTracksRecentRows() {
+  size_t n = 3;
+  size_t window = 30;
+  Matrix A = randomMatrix(n, 150, -10.0, 10.0);
+  Matrix b = randomMatrix(1, 150, -10.0, 10.0);
+  StreamingLeastSquares streaming(n, window);
+  for (size_t y = 0; y < A.height(); y += 10) {
+    streaming.addRows(rows(A, y, y + 10), rows(b, y, y + 10));
+  }
+  ASSERT_EQ(streaming.numRows(), window);
+  Matrix A_window = rows(A, 150 - window, 150);
+  Matrix b_window = rows(b, 150 - window, 150);
+  Matrix x = batchSolution(A_window, b_window);
+  ASSERT_MATRIX_NEAR_TOL(streaming.solve(), x, 1e-8);
+  ASSERT_TOL(streaming.residualNorm(), (A_window * x - b_window).norm(),
+             1e-8);
+}
+
+void removeRowsLeavesTheWindow() {
+  size_t n = 3;
+  size_t window = 20;
+  Matrix A = randomMatrix(n, 30, -10.0, 10.0);
+  Matrix b = randomMatrix(1, 30, -10.0, 10.0);
+  StreamingLeastSquares streaming(n, window);
+  streaming.addRows(rows(A, 0, 20), rows(b, 0, 20));
+  ASSERT(streaming.removeRows(rows(A, 5, 10), rows(b, 5, 10)));
+  ASSERT_EQ(streaming.numRows(), 15);
+  // 25 rows went into the window and 5 were removed; the overflow drops
+  // rows 0 to 4, not the removed ones a second time.
+  streaming.addRows(rows(A, 20, 30), rows(b, 20, 30));
+  ASSERT_EQ(streaming.numRows(), window);
+  Matrix A_window = rows(A, 10, 30);
+  Matrix b_window = rows(b, 10, 30);
+  Matrix x = batchSolution(A_window, b_window);
+  ASSERT_MATRIX_NEAR_TOL(streaming.solve(), x, 1e-8);
+  ASSERT_TOL(streaming.residualNorm(), (A_window * x - b_window).norm(),
+             1e-8);
+
+  // Rows that already slid out cannot be removed.
+  bool threw = false;
+  try {
+    streaming.removeRows(rows(A, 0, 1), rows(b, 0, 1));
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main() {
+  streamingMatchesBatchSolution();
+  removeRowsUndoesAddRows();
+  removeRowsLeavesTheWindow();
+  slidingWindowTracksRecentRows();
+}
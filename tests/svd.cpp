@@ -0,0 +1,126 @@
+#include "svd.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "qr_factorization.hpp"
+#include "test_helpers.hpp"
+
+using namespace basic_matrix;
+
+namespace {
+void assertSVD(const Matrix &A, const SVDOptions &options) {
+  Matrix U;
+  Matrix S;
+  Matrix Vt;
+  ASSERT(svd(A, U, S, Vt, options));
+  size_t m = A.height();
+  size_t n = A.width();
+  size_t r = std::min(m, n);
+  ASSERT_EQ(S.height(), r);
+  ASSERT_EQ(U.height(), m);
+  ASSERT_EQ(U.width(), options.thin ? r : m);
+  ASSERT_EQ(Vt.height(), options.thin ? r : n);
+  ASSERT_EQ(Vt.width(), n);
+  ASSERT_MATRIX_NEAR_TOL(U.transpose() * U, identity(U.width()), 1e-12);
+  ASSERT_MATRIX_NEAR_TOL(Vt * Vt.transpose(), identity(Vt.height()), 1e-12);
+  for (size_t i = 0; i + 1 < r; i++) {
+    ASSERT(S(0, i) >= S(0, i + 1));
+  }
+  Matrix Sigma(Vt.height(), U.width());
+  for (size_t i = 0; i < r; i++) {
+    Sigma(i, i) = S(0, i);
+  }
+  ASSERT_MATRIX_NEAR_TOL(U * Sigma * Vt, A, 1e-10 * (1.0 + S(0, 0)));
+}
+}; // namespace
+
+void svdWorks() {
+  for (const auto &thin : {false, true}) {
+    for (const auto &qr_preconditioning : {false, true}) {
+      SVDOptions options;
+      options.thin = thin;
+      options.qr_preconditioning = qr_preconditioning;
+      assertSVD(randomMatrix(25, 60, -10.0, 10.0), options);
+      assertSVD(randomMatrix(45, 20, -10.0, 10.0), options);
+      assertSVD(randomMatrix(30, 30, -10.0, 10.0), options);
+      assertSVD(randomMatrix(1, 7, -10.0, 10.0), options);
+      // Rank 5.
+      assertSVD(randomMatrix(5, 40, -1.0, 1.0) * randomMatrix(30, 5, -1.0, 1.0),
+                options);
+    }
+  }
+  // The rotations of each round run in parallel.
+  setNumThreads(4);
+  assertSVD(randomMatrix(41, 80, -10.0, 10.0), SVDOptions());
+  setNumThreads(0);
+}
+
+void singularValuesWork() {
+  // U * diag(s) * V^T with known, widely graded s.
+  size_t n = 12;
+  Matrix U;
+  Matrix R = randomMatrix(n, 30, -1.0, 1.0);
+  qrFactorize(U, R);
+  Matrix V;
+  R = randomMatrix(n, n, -1.0, 1.0);
+  qrFactorize(V, R);
+  Matrix Sigma(n, 30);
+  std::vector<double> expected;
+  for (size_t i = 0; i < n; i++) {
+    expected.push_back(pow(10.0, -double(i)));
+    Sigma(i, i) = expected.back();
+  }
+  Matrix A = U * Sigma * V.transpose();
+  Matrix S = singularValues(A);
+  ASSERT(S.ok());
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_TOL(S(0, i), expected[i], 1e-14);
+  }
+  Matrix zero = singularValues(Matrix(3, 4));
+  ASSERT_MATRIX_NEAR(zero, Matrix(1, 3));
+}
+
+void randomizedSVDWorks() {
+  // Rank 8 plus a little noise.
+  size_t k = 8;
+  Matrix A = randomMatrix(k, 300, -1.0, 1.0) * randomMatrix(120, k, -1.0, 1.0) +
+             randomMatrix(120, 300, -1e-6, 1e-6, 0.0);
+  Matrix U;
+  Matrix S;
+  Matrix Vt;
+  ASSERT(randomizedSVD(A, k, U, S, Vt));
+  ASSERT_EQ(U.width(), k);
+  ASSERT_EQ(U.height(), 300);
+  ASSERT_EQ(Vt.height(), k);
+  ASSERT_EQ(Vt.width(), 120);
+  ASSERT_MATRIX_NEAR_TOL(U.transpose() * U, identity(k), 1e-12);
+  ASSERT_MATRIX_NEAR_TOL(Vt * Vt.transpose(), identity(k), 1e-12);
+  Matrix exact = singularValues(A);
+  for (size_t i = 0; i < k; i++) {
+    ASSERT_TOL(S(0, i), exact(0, i), 1e-8 * exact(0, 0));
+  }
+  Matrix Sigma(k, k);
+  for (size_t i = 0; i < k; i++) {
+    Sigma(i, i) = S(0, i);
+  }
+  ASSERT((U * Sigma * Vt - A).norm() < 1e-3);
+
+  // The same seed gives the same result.
+  Matrix U2;
+  Matrix S2;
+  Matrix Vt2;
+  ASSERT(randomizedSVD(A, k, U2, S2, Vt2));
+  ASSERT_MATRIX_NEAR_TOL(S2, S, 0.0);
+  ASSERT_MATRIX_NEAR_TOL(U2, U, 0.0);
+
+  Matrix Q = randomizedRangeFinder(A, 12, 0, 7);
+  ASSERT_EQ(Q.width(), 12);
+  ASSERT_MATRIX_NEAR_TOL(Q.transpose() * Q, identity(12), 1e-12);
+  // The range of A is (almost) inside the range of Q.
+  ASSERT((Q * (Q.transpose() * A) - A).norm() < 1e-3);
+}
+
+int main() {
+  svdWorks();
+  singularValuesWork();
+  randomizedSVDWorks();
+}
@@ -0,0 +1,169 @@
+#include "symmetric_eigenvalues.hpp"
+#include "eigenvalues.hpp"
+#include "matrix_helpers.hpp"
+#include "parallel.hpp"
+#include "qr_factorization.hpp"
+#include "test_helpers.hpp"
+#include <algorithm>
+
+using namespace basic_matrix;
+
+namespace {
+Matrix randomSymmetricMatrix(const size_t &n) {
+  Matrix A = randomMatrix(n, n, -10.0, 10.0);
+  return A + A.transpose();
+}
+
+/// Q * diag(values) * Q^T for a random orthogonal Q.
+Matrix symmetricMatrixWithEigenvalues(const std::vector<double> &values) {
+  size_t n = values.size();
+  Matrix Q;
+  Matrix R = randomMatrix(n, n, -1.0, 1.0);
+  qrFactorize(Q, R);
+  Matrix QL = Q;
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      QL(x, y) *= values[x];
+    }
+  }
+  return QL * Q.transpose();
+}
+
+Matrix tridiagonal(const Matrix &diagonal, const Matrix &off_diagonal) {
+  size_t n = diagonal.height();
+  Matrix T(n, n);
+  for (size_t i = 0; i < n; i++) {
+    T(i, i) = diagonal(0, i);
+    if (i + 1 < n) {
+      T(i + 1, i) = off_diagonal(0, i);
+      T(i, i + 1) = off_diagonal(0, i);
+    }
+  }
+  return T;
+}
+
+void assertEigenpairs(const Matrix &A, const Matrix &values,
+                      const Matrix &vectors, const double &tol) {
+  size_t n = A.height();
+  ASSERT_EQ(values.height(), n);
+  for (size_t i = 0; i + 1 < n; i++) {
+    ASSERT(values(0, i) <= values(0, i + 1));
+  }
+  Matrix VL = vectors;
+  for (size_t y = 0; y < n; y++) {
+    for (size_t x = 0; x < n; x++) {
+      VL(x, y) *= values(0, x);
+    }
+  }
+  ASSERT_MATRIX_NEAR_TOL(A * vectors, VL, tol);
+  ASSERT_MATRIX_NEAR_TOL(vectors.transpose() * vectors, identity(n), 1e-10);
+}
+}; // namespace
+
+void tridiagonalizeObeysDefinition() {
+  // Large enough to span several panels.
+  for (size_t n : {1, 2, 3, 33, 70}) {
+    Matrix A = randomSymmetricMatrix(n);
+    Matrix H = A;
+    Matrix diagonal;
+    Matrix off_diagonal;
+    Matrix tau;
+    tridiagonalize(H, diagonal, off_diagonal, tau);
+    ASSERT_EQ(diagonal.height(), n);
+    ASSERT_EQ(off_diagonal.height(), n - 1);
+    Matrix Q = formHessenbergQ(H, tau);
+    ASSERT_MATRIX_NEAR_TOL(Q.transpose() * Q, identity(n), 1e-12);
+    ASSERT_MATRIX_NEAR_TOL(Q.transpose() * A * Q,
+                           tridiagonal(diagonal, off_diagonal), 1e-10);
+  }
+}
+
+void tridiagonalEigenWorks() {
+  // A random tridiagonal matrix, deep enough for several merge levels.
+  {
+    size_t n = 200;
+    Matrix diagonal = randomMatrix(1, n, -10.0, 10.0);
+    Matrix off_diagonal = randomMatrix(1, n - 1, -10.0, 10.0);
+    Matrix values;
+    Matrix vectors;
+    ASSERT(tridiagonalEigen(diagonal, off_diagonal, values, vectors));
+    assertEigenpairs(tridiagonal(diagonal, off_diagonal), values, vectors,
+                     1e-9);
+  }
+  // The Wilkinson matrix has pairs of nearly equal eigenvalues, and the
+  // constant diagonal has many exactly equal ones, so merges deflate.
+  {
+    size_t n = 101;
+    Matrix diagonal(1, n);
+    Matrix off_diagonal(1, n - 1);
+    for (size_t i = 0; i < n; i++) {
+      diagonal(0, i) = fabs(double(i) - double(n / 2));
+    }
+    for (size_t i = 0; i + 1 < n; i++) {
+      off_diagonal(0, i) = 1.0;
+    }
+    Matrix values;
+    Matrix vectors;
+    ASSERT(tridiagonalEigen(diagonal, off_diagonal, values, vectors));
+    assertEigenpairs(tridiagonal(diagonal, off_diagonal), values, vectors,
+                     1e-10);
+  }
+  {
+    size_t n = 90;
+    Matrix diagonal(1, n);
+    Matrix off_diagonal(1, n - 1);
+    for (size_t i = 0; i < n; i++) {
+      diagonal(0, i) = 2.0;
+    }
+    for (size_t i = 0; i + 1 < n; i += 3) {
+      off_diagonal(0, i) = 1.0;
+    }
+    Matrix values;
+    Matrix vectors;
+    ASSERT(tridiagonalEigen(diagonal, off_diagonal, values, vectors));
+    assertEigenpairs(tridiagonal(diagonal, off_diagonal), values, vectors,
+                     1e-10);
+  }
+}
+
+void symmetricEigenWorks() {
+  std::vector<double> expected;
+  for (size_t i = 0; i < 150; i++) {
+    // Clusters of repeated eigenvalues as well as distinct ones.
+    expected.push_back(i < 50 ? double(i / 10) : randomDouble(-50.0, 50.0));
+  }
+  Matrix A = symmetricMatrixWithEigenvalues(expected);
+  std::sort(expected.begin(), expected.end());
+  for (size_t threads : {1, 4}) {
+    setNumThreads(threads);
+    Matrix values;
+    Matrix vectors;
+    ASSERT(symmetricEigen(A, values, vectors));
+    assertEigenpairs(A, values, vectors, 1e-9);
+    Matrix only_values = symmetricEigenvalues(A);
+    ASSERT(only_values.ok());
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_TOL(values(0, i), expected[i], 1e-9);
+      ASSERT_TOL(only_values(0, i), expected[i], 1e-9);
+    }
+  }
+  setNumThreads(0);
+  {
+    Matrix A = randomSymmetricMatrix(40);
+    Matrix values;
+    Matrix vectors;
+    ASSERT(symmetricEigen(A, values, vectors));
+    assertEigenpairs(A, values, vectors, 1e-9);
+    Matrix general = eigenvalues(A);
+    ASSERT(general.ok());
+    for (size_t i = 0; i < 40; i++) {
+      assertContains(general, values(0, i), 1e-8);
+    }
+  }
+}
+
+int main() {
+  tridiagonalizeObeysDefinition();
+  tridiagonalEigenWorks();
+  symmetricEigenWorks();
+}
@@ -1,4 +1,5 @@
 #include "test_helpers.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <random>
 #include <string>
@@ -0,0 +1,100 @@
+#include "lup_decomposition.hpp"
+#include "matrix_helpers.hpp"
+#include "packed_matrix.hpp"
+#include "parallel.hpp"
+#include "test_helpers.hpp"
+#include "tile_factorization.hpp"
+
+using namespace basic_matrix;
+
+void tileLUMatchesLUFactorize() {
+  setNumThreads(4);
+  // Sizes that are and are not multiples of the tile size.
+  for (size_t n : {1, 7, 16, 50, 130}) {
+    Matrix A = generateNonsingularMatrix(n, n);
+    Matrix expected = A;
+    std::vector<size_t> expected_pivots;
+    ASSERT(luFactorize(expected, expected_pivots));
+    for (size_t tile_size : {1, 5, 16, 200}) {
+      Matrix LU = A;
+      std::vector<size_t> pivots;
+      ASSERT(tileLUFactorize(LU, pivots, tile_size));
+      ASSERT(pivots == expected_pivots);
+      ASSERT_MATRIX_NEAR_TOL(LU, expected, 1e-9);
+      Matrix b = randomMatrix(2, n, -1.0, 1.0);
+      Matrix x = b;
+      solveLU(LU, pivots, x);
+      ASSERT_MATRIX_NEAR_TOL(A * x, b, 1e-8);
+    }
+  }
+
+  Matrix singular = randomMatrix(40, 40, -1.0, 1.0);
+  for (size_t y = 0; y < 40; y++) {
+    singular(17, y) = 0.0;
+  }
+  std::vector<size_t> pivots;
+  ASSERT(!tileLUFactorize(singular, pivots, 8));
+
+  bool threw = false;
+  try {
+    Matrix rectangular(3, 4);
+    tileLUFactorize(rectangular, pivots);
+  } catch (const std::runtime_error &e) {
+    threw = true;
+  }
+  ASSERT(threw);
+  setNumThreads(0);
+}
+
+void tileCholeskyWorks() {
+  setNumThreads(4);
+  for (size_t n : {1, 9, 64, 101}) {
+    Matrix J = randomMatrix(n, n + 5, -1.0, 1.0);
+    Matrix A = J.transpose() * J;
+    for (size_t tile_size : {1, 8, 32, 200}) {
+      Matrix L = A;
+      ASSERT(tileCholeskyFactorize(L, tile_size));
+      for (size_t y = 0; y < n; y++) {
+        for (size_t x = y + 1; x < n; x++) {
+          ASSERT_EQ(L(x, y), 0.0);
+        }
+      }
+      ASSERT_MATRIX_NEAR_TOL(L * L.transpose(), A, 1e-9);
+
+      // The same factorization on packed rows.
+      LowerTriangular L_packed(A);
+      ASSERT(tileCholeskyFactorize(L_packed, tile_size));
+      ASSERT_MATRIX_NEAR_TOL(L_packed.toDense(), L, 1e-12);
+    }
+  }
+
+  Matrix indefinite = identity(30);
+  indefinite(20, 20) = -1.0;
+  ASSERT(!tileCholeskyFactorize(indefinite, 7));
+  setNumThreads(0);
+}
+
+void largeFactorizationsGoThroughTheTaskGraph() {
+  // Big enough for lupDecomposition to use the tile factorization when
+  // there are threads to spare.
+  setNumThreads(4);
+  size_t n = 520;
+  Matrix A = generateNonsingularMatrix(n, n);
+  Matrix L, U, P;
+  ASSERT(lupDecomposition(A, L, U, P));
+  ASSERT_MATRIX_NEAR_TOL(P * A, L * U, 1e-8);
+
+  Matrix J = randomMatrix(n, n + 5, -1.0, 1.0);
+  SymmetricMatrix JtJ = gramMatrix(J);
+  LowerTriangular L_packed;
+  ASSERT(choleskyFactorize(JtJ, L_packed));
+  Matrix L_dense = L_packed.toDense();
+  ASSERT_MATRIX_NEAR_TOL(L_dense * L_dense.transpose(), JtJ.toDense(), 1e-8);
+  setNumThreads(0);
+}
+
+int main() {
+  tileLUMatchesLUFactorize();
+  tileCholeskyWorks();
+  largeFactorizationsGoThroughTheTaskGraph();
+}